@@ -0,0 +1,16 @@
+#pragma once
+// JSON bodies for the web API, built into caller buffers with snprintf.
+// Callers pass in everything that would need a clock or a lock, so the
+// native build can benchmark the same formatting.
+#include <stdint.h>
+#include <stddef.h>
+#include "SharedData.h"
+#include "Histogram.h"
+
+// /api/data and the /api/stream events. Returns the length written.
+int apiDataJson(char *json, size_t len, const SensorReadings &r, uint32_t seq,
+                uint32_t uptimeMs, bool recording, const char *recFile);
+
+// Non-empty histogram buckets as [upper bound, count] pairs, bounds divided
+// by div (cycles -> us, us -> us)
+int apiHistJson(char *json, size_t len, const Histogram &h, uint32_t div);
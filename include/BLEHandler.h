@@ -1,8 +1,18 @@
 #pragma once
 #include <Arduino.h>
+#include "SharedData.h"
 
 void setupBLE();
-void updateBLEData(float temp, float hum, float press, float iaq, float co2);
+// Notify the packed telemetry characteristic, and the per-channel ones
+// that have subscribers
+void updateBLEData(const SensorReadings &r);
+// Log download service: handles queued commands and sends the next
+// notifications. Call every loop pass.
+void serviceBLE();
+
+// A download is in progress; the loop should pump every XFER_POLL_MS
+bool isBLETransferActive();
+
 void stopBLE();
 bool isBLEConnected();
 bool isBLEActive();
@@ -0,0 +1,8 @@
+#pragma once
+// Li-ion state of charge from the cell voltage. No Arduino dependencies,
+// so the native build can benchmark it.
+#include <stdint.h>
+
+// Percentage (0..100) for a resting cell voltage, interpolated from a
+// discharge curve table
+int batteryPercent(float voltage);
@@ -0,0 +1,130 @@
+#pragma once
+// Log download over BLE: the device side of a small file-transfer protocol
+// carried by two characteristics, control (client writes commands) and
+// data (device notifies packets). Free of Arduino / NimBLE: files are read
+// through Hal.h and the link is whatever calls xferCommand() and
+// xferNextPacket(), so test/test_ble_file_xfer runs the same state machine
+// against a simulated lossy link.
+//
+// Commands (control characteristic, little-endian):
+//   'L' u16 first             list recordings from index first
+//   'O' name                  open a file ("/log_001.csv")
+//   'R' u32 offset            (re)start streaming the open file at offset
+//   'A' u32 offset            everything below offset has arrived
+//   'C'                       close
+//
+// Packets (data characteristic):
+//   'E' u16 index, u16 total, u32 size, name     one list entry
+//   'e' u16 total                                end of the list
+//   'O' u8 status, u32 size                      open result (XFER_OPEN_*)
+//   'D' u32 offset, bytes                        file data
+//   'Z' u32 size, u32 elapsedMs                  all data sent
+//
+// Data packets fill the notification (MTU - 3). At most XFER_WINDOW bytes
+// are sent beyond the last ack. A client that sees an offset it didn't
+// expect (lost notification) sends 'R' with the offset it needs; if acks
+// stop coming the device goes back to the last acked offset by itself, and
+// gives up after XFER_MAX_STALLS timeouts without progress (the file stays
+// open for 'R'). An ack of the whole file ends the transfer, 'Z' sent or
+// not. A dropped connection resumes the same way: reopen, then 'R' with
+// the bytes already received.
+#include <stdint.h>
+#include <stddef.h>
+
+#define XFER_CMD_LIST 'L'
+#define XFER_CMD_OPEN 'O'
+#define XFER_CMD_READ 'R'
+#define XFER_CMD_ACK 'A'
+#define XFER_CMD_CLOSE 'C'
+
+#define XFER_PKT_ENTRY 'E'
+#define XFER_PKT_LIST_END 'e'
+#define XFER_PKT_OPENED 'O'
+#define XFER_PKT_DATA 'D'
+#define XFER_PKT_END 'Z'
+
+#define XFER_OPEN_OK 0
+#define XFER_OPEN_NOT_FOUND 1
+
+#define XFER_DATA_HEADER 5   // 'D' + u32 offset
+#define XFER_MIN_PACKET 20   // Default ATT MTU 23 - 3
+#define XFER_MAX_PACKET 244  // ATT MTU 247 - 3
+#define XFER_READ_CHUNK 2048 // Flash read size; packets are cut from it
+#define XFER_WINDOW 8192     // Bytes in flight beyond the last ack
+#define XFER_ACK_TIMEOUT_MS 1500
+#define XFER_MAX_STALLS 4 // Ack timeouts in a row before the transfer is dropped
+#define XFER_MAX_COMMAND 40
+// Pumping: while busy the loop wakes every XFER_POLL_MS and queues up to
+// XFER_BURST notifications
+#define XFER_POLL_MS 10
+#define XFER_BURST 8
+
+// Recording i of the device's list; false past the end
+typedef bool (*XferListFn)(int index, char *name, size_t nameLen, uint32_t &size);
+
+enum XferState
+{
+    XFER_IDLE,
+    XFER_OPEN,    // File open, waiting for 'R'
+    XFER_SENDING, // Streaming; stays here until everything is acked
+    XFER_DONE     // Fully acked; 'R' sends again
+};
+
+struct XferServer
+{
+    XferState state = XFER_IDLE;
+    XferListFn list = nullptr;
+    size_t packetSize = XFER_MIN_PACKET;
+
+    // One reply waiting to go out ahead of list / data packets
+    uint8_t reply[16];
+    size_t replyLen = 0;
+
+    // Listing in progress
+    bool listing = false;
+    int listNext = 0;
+    int listTotal = 0;
+
+    // Open file
+    char path[32] = "";
+    uint32_t size = 0;
+    uint32_t sendOffset = 0;
+    uint32_t ackOffset = 0;
+    bool endSent = false;
+    uint32_t lastProgressMs = 0;
+    uint32_t stalls = 0;      // Ack timeouts since the last progress
+    uint32_t startMs = 0;
+
+    // Read cache
+    uint8_t cache[XFER_READ_CHUNK];
+    uint32_t cacheOffset = 0;
+    size_t cacheLen = 0;
+
+    // Stats of the current / last transfer
+    uint32_t bytesSent = 0;   // Data bytes including resends
+    uint32_t rewinds = 0;     // 'R' requests and ack timeouts
+    uint32_t elapsedMs = 0;   // First 'R' to the final ack
+};
+
+void xferInit(XferServer &s, XferListFn list);
+
+// Payload bytes per notification (negotiated MTU - 3), clamped to
+// XFER_MIN_PACKET..XFER_MAX_PACKET
+void xferSetPacketSize(XferServer &s, size_t payload);
+
+// A command written to the control characteristic
+void xferCommand(XferServer &s, const uint8_t *cmd, size_t len, uint32_t nowMs);
+
+// Next packet to notify, or 0 if nothing is due (window full, waiting for
+// an ack, idle). out needs XFER_MAX_PACKET bytes.
+size_t xferNextPacket(XferServer &s, uint8_t *out, size_t outSize, uint32_t nowMs);
+
+// The link couldn't take a packet from xferNextPacket() (notification
+// buffers full): it goes out again on the next call
+void xferUnsent(XferServer &s, const uint8_t *pkt, size_t len);
+
+// Packets are waiting or a transfer is still unacknowledged
+bool xferBusy(const XferServer &s);
+
+// The connection dropped: stop sending. The client resumes with 'O' + 'R'.
+void xferDisconnected(XferServer &s);
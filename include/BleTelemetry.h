@@ -0,0 +1,53 @@
+#pragma once
+// Packed BLE telemetry: one notification carries a whole sample.
+// Free of Arduino / NimBLE so test/test_ble_telemetry can check the exact
+// encoder/decoder on the host.
+#include <stdint.h>
+#include <stddef.h>
+#include "SharedData.h"
+
+// Packet layout v1 (all integers little-endian), 20 bytes so it fits one
+// notification at the default ATT MTU of 23:
+//
+//    0  u8   version << 4 | flags (bit 3 replaying, bit 2 recording) | accuracy (bits 0-1)
+//    1  u16  seq (packet counter, wraps; gaps are missed notifications)
+//    3  u32  timestamp ms (device uptime)
+//    7  i16  temp * 100 (C)
+//    9  u16  hum * 100 (%)
+//   11  u24  press * 10 (Pa)
+//   14  u16  iaq * 100
+//   16  u24  co2 * 100 (ppm)
+//   19  u8   battery %
+//
+// Values are rounded to the field resolution and clamped to its range.
+// Decoders should reject packets with a version they don't know; fields
+// are only ever appended, so newer decoders also accept older lengths.
+
+#define BLE_TELEMETRY_VERSION 1
+#define BLE_TELEMETRY_SIZE 20
+
+#define BLE_TELEMETRY_FLAG_RECORDING 0x04
+#define BLE_TELEMETRY_FLAG_REPLAYING 0x08
+
+struct BleTelemetry
+{
+    uint16_t seq = 0;
+    uint32_t timestampMs = 0;
+    float temp = 0;
+    float hum = 0;
+    float press = 0;
+    float iaq = 0;
+    float co2 = 0;
+    uint8_t accuracy = 0;
+    uint8_t batteryPercent = 0;
+    uint8_t flags = 0;
+};
+
+// Fill a packet from a reading
+BleTelemetry bleTelemetryFromReadings(const SensorReadings &r, uint32_t seq, uint32_t timestampMs, uint8_t flags);
+
+// Returns bytes written (BLE_TELEMETRY_SIZE), 0 if out is too small
+size_t bleTelemetryEncode(uint8_t *out, size_t outSize, const BleTelemetry &t);
+
+// False on a short packet or an unknown version
+bool bleTelemetryDecode(const uint8_t *in, size_t len, BleTelemetry &out);
@@ -0,0 +1,10 @@
+#pragma once
+// Pin map for the deneyapkart1Av2 (ESP32-S3)
+
+#define GPKEY_PIN 0
+#define TOUCH_PIN 10 // GPIO 10 on deneyapkart1Av2 (ESP32-S3)
+#define BATTERY_PIN 9 // GPIO 9 on deneyapkart1Av2 (ESP32-S3)
+#define VOLT_DIVIDER_RATIO 2.0
+
+#define I2C_SDA 47 // GPIO 47 on deneyapkart1Av2 (ESP32-S3)
+#define I2C_SCL 21 // GPIO 21 on deneyapkart1Av2 (ESP32-S3)
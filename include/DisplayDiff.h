@@ -0,0 +1,42 @@
+#pragma once
+// Partial refresh for the SSD1306: keeps a shadow of the frame last sent to
+// the panel and only transmits the changed column range of each 8-row page.
+// Every frame must go through displayPush() so the shadow stays in sync.
+// Talks to the panel through I2CBus / Hal.h, not the Adafruit driver, so it
+// also builds natively.
+#include <stdint.h>
+#include <stddef.h>
+
+struct DisplayStats
+{
+    uint32_t frames = 0;
+    uint32_t framesSkipped = 0;  // Nothing changed, nothing sent
+    uint32_t framesDeferred = 0; // Cut short to keep the bus free for the sensor
+    uint32_t pagesSent = 0;
+    uint32_t bytesOnBus = 0;    // Address + control + command + data bytes
+    uint32_t lastFrameBytes = 0;
+    uint32_t lastFrameUs = 0;
+    uint32_t maxFrameUs = 0;
+};
+
+// Call right after display.begin() with the driver's 128x64 framebuffer.
+// The first push is always a full frame.
+void initDisplayDiff(uint8_t *frameBuffer, uint8_t address);
+
+// The panel's framebuffer (what displayPush() sends)
+uint8_t *displayFrameBuffer();
+
+// Send the regions of the framebuffer that differ from the panel. Chunks
+// that would collide with the next sensor cycle are left for a later push.
+void displayPush();
+
+// True while part of the last frame is still waiting to be sent
+bool displayPending();
+
+// Forget the shadow; the next push sends the whole frame
+void displayInvalidate();
+
+// Panel on/off, under the bus lock like every other display transfer
+void displayPower(bool on);
+
+DisplayStats getDisplayStats();
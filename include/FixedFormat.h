@@ -0,0 +1,39 @@
+#pragma once
+// printf-free number formatting for the hot text paths (CSV lines, the
+// /api/data JSON, BLE values). Works on the float's bits with integer
+// arithmetic only: no heap, no float printf, a few dozen bytes of stack.
+//
+// fmtFixed() prints exactly what snprintf("%.Nf") prints for every float,
+// including round-half-even on exact ties and "-0.00" for small negative
+// values; test/test_fixed_format checks that against the host's snprintf.
+//
+// Output goes through FmtBuf, which behaves like snprintf into a fixed
+// buffer: writes stop at size - 1, the result is always terminated, and
+// the returned length counts everything that would have been written.
+#include <stdint.h>
+#include <stddef.h>
+
+#define FMT_MAX_DECIMALS 3
+
+struct FmtBuf
+{
+    char *out;
+    size_t size;
+    size_t len;
+};
+
+void fmtInit(FmtBuf &b, char *out, size_t size);
+
+// Terminate and return the length (like snprintf's return value)
+int fmtEnd(FmtBuf &b);
+
+void fmtChar(FmtBuf &b, char c);
+void fmtStr(FmtBuf &b, const char *s);
+void fmtUint(FmtBuf &b, unsigned long v);
+void fmtInt(FmtBuf &b, long v);
+
+// v with decimals (0..FMT_MAX_DECIMALS) fraction digits, as "%.Nf"
+void fmtFixed(FmtBuf &b, float v, int decimals);
+
+// One value into out, returns its length (out needs 48 bytes for any float)
+int fmtFixedTo(char *out, size_t size, float v, int decimals);
@@ -0,0 +1,82 @@
+#pragma once
+// On-device history behind the graph screen and /api/history.
+// One ring buffer per channel plus the sample timestamps.
+// Free of Arduino dependencies so test/test_graph_columns and
+// test/test_graph_tiers can build it on the host.
+#include <stdint.h>
+#define GRAPH_WIDTH 100
+#define GRAPH_COUNT 5
+
+// 0: IAQ, 1: CO2, 2: Temp, 3: Hum, 4: Press
+extern float graphBuffers[GRAPH_COUNT][GRAPH_WIDTH];
+extern unsigned long graphTimes[GRAPH_WIDTH];
+extern int graphHead;
+extern bool graphFilled;
+extern const char *graphLabels[GRAPH_COUNT];
+extern const char *graphUnits[GRAPH_COUNT];
+
+// Append one sample (values in channel order)
+void graphHistoryAdd(unsigned long timestamp, const float values[GRAPH_COUNT]);
+
+// Number of valid samples (<= GRAPH_WIDTH)
+int graphHistoryCount();
+
+// Ring index of the i-th sample in chronological order (0 = oldest)
+int graphHistoryIndex(int i);
+
+// --- MULTI-RESOLUTION TIERS ---
+// Longer spans for the graph screen. Each tier keeps GRAPH_WIDTH closed
+// buckets of min/max/mean per channel, updated in O(1) per sample:
+//   1 min buckets  -> 100 min
+//   15 min buckets -> 25 h
+//   1 h buckets    -> ~4 days
+// RAM: 3 tiers * 100 buckets * (5 ch * 3 floats + u32 start) = 19.2 KiB,
+// plus one open bucket (min/max/sum/count) per tier.
+#define GRAPH_TIER_COUNT 3
+#define GRAPH_SPAN_COUNT (GRAPH_TIER_COUNT + 1) // Span 0 is the raw ring
+
+struct GraphPoint
+{
+    float minV;
+    float maxV;
+    float meanV;
+};
+
+// Short label for the graph header ("RAW", "1m", ...)
+const char *graphSpanLabel(int span);
+
+// Points available for a span, including the partially filled open bucket
+int graphSpanPoints(int span);
+
+// i-th point of a span in chronological order. Raw samples have min == max == mean.
+GraphPoint graphSpanPoint(int span, int channel, int i);
+
+// --- AUTOSCALE + PLOT COLUMNS ---
+// Min/max over every point a span currently shows. Maintained on insert
+// with monotonic deques, so this is O(1) instead of a rescan per frame.
+// Returns false if the span has no points yet.
+bool graphSpanRange(int span, int channel, float &minV, float &maxV);
+
+// Bumped on every sample, so derived data can be cached between samples
+uint32_t graphHistoryVersion();
+
+// Integer y coordinates for plotting one span/channel between rows top and
+// bottom (bottom = minimum). The range is padded to at least 2 units.
+struct GraphColumns
+{
+    int count;
+    float minV;
+    float maxV;
+    uint8_t yMean[GRAPH_WIDTH];
+    uint8_t yTop[GRAPH_WIDTH];    // Envelope max
+    uint8_t yBottom[GRAPH_WIDTH]; // Envelope min
+
+    // Cache key
+    uint32_t version;
+    int span;
+    int channel;
+};
+
+// Refreshes cols if the history, span or channel changed since the last
+// call. Returns true if the columns were recomputed.
+bool graphSpanColumns(int span, int channel, int top, int bottom, GraphColumns &cols);
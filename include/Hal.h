@@ -0,0 +1,80 @@
+#pragma once
+// Hardware seam. Code that should also run on the host reaches the
+// hardware only through these calls. The board build links
+// src/HalEsp32.cpp; the native build (platformio.ini, env:native) links
+// src/native/HalHost.cpp instead. main.cpp, BSEC and the panel driver are
+// board-only and keep using Arduino directly.
+#include <stdint.h>
+#include <stddef.h>
+#include "SharedData.h"
+
+// --- CLOCK ---
+uint32_t halMillis();
+uint32_t halMicros();
+
+// Block the calling task (board) or the process (host) for ms
+void halDelay(uint32_t ms);
+
+// --- CONCURRENCY ---
+// One short critical section for small shared counters and snapshots.
+// Never block, allocate or touch flash inside it.
+void halLock();
+void halUnlock();
+
+// --- FILESYSTEM ---
+// Paths as on LittleFS ("/log_001.csv"). Returns the bytes written.
+size_t halFileWrite(const char *path, const uint8_t *data, size_t len, bool append);
+
+// Up to len bytes starting at offset. Returns the bytes read (0 at the end
+// or if the file doesn't exist).
+size_t halFileRead(const char *path, uint32_t offset, uint8_t *buf, size_t len);
+
+// Size in bytes, or -1 if the file doesn't exist
+long halFileSize(const char *path);
+
+bool halFileRemove(const char *path);
+
+// Cut the file down to size bytes
+bool halFileTruncate(const char *path, size_t size);
+
+// A file kept open while it grows (the active recording). Appends may sit
+// in the filesystem's caches until halFileSync(), which on LittleFS is the
+// metadata commit that makes them survive a reset.
+struct HalFile;
+HalFile *halFileOpenAppend(const char *path); // nullptr on failure
+size_t halFileAppend(HalFile *file, const uint8_t *data, size_t len);
+long halFileLength(HalFile *file);
+bool halFileSync(HalFile *file);
+void halFileClose(HalFile *file);
+
+// --- DISPLAY SINK ---
+// One full SSD1306 frame, width * height / 8 bytes: pages of 8 rows top to
+// bottom, one byte per column, LSB on top (Adafruit_SSD1306 buffer layout)
+void halDisplayFrame(const uint8_t *frame, int width, int height);
+
+// --- I2C BUS ---
+// Raw transactions on the bus shared by the BME688 and the SSD1306; the
+// scheduling around them is in I2CBus.h. halI2cTake() blocks until the bus
+// is free. writeRead sends wr, then reads rlen bytes after a repeated start.
+void halI2cBegin(int sda, int scl, uint32_t clockHz);
+void halI2cTake();
+void halI2cGive();
+bool halI2cWrite(uint8_t addr, const uint8_t *data, size_t len);
+bool halI2cWriteRead(uint8_t addr, const uint8_t *wr, size_t wlen, uint8_t *rd, size_t rlen);
+
+// --- SENSOR SOURCE ---
+// Next reading, if any (non-blocking)
+bool halSensorReceive(SensorReadings &out);
+
+// Battery voltage at the cell, averaged over a few ADC samples
+uint32_t halBatteryMilliVolts();
+
+// --- INPUT SOURCE ---
+bool halButtonDown();
+
+// Raw touch pad value (ESP32-S3: rises when touched)
+uint32_t halTouchRead();
+
+// --- RADIO ---
+bool halWiFiConnected();
+bool halBleActive();
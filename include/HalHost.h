@@ -0,0 +1,27 @@
+#pragma once
+// Host-only controls over src/native/HalHost.cpp, for the native test
+// suites in test/. Never included by firmware code.
+#include "Hal.h"
+
+// Freeze the clock at startUs: halMillis() / halMicros() only move with
+// halHostAdvanceUs(), and halDelay() advances it instead of sleeping
+void halHostManualClock(uint32_t startUs);
+void halHostAdvanceUs(uint32_t us);
+
+// Sees every append / sync on a HalFile and every truncate before it
+// happens. offset is the file length for appends, the new size for
+// truncates. Returning false fails the call and leaves the file alone.
+enum HalHostFileOp
+{
+    HAL_HOST_APPEND,
+    HAL_HOST_SYNC,
+    HAL_HOST_TRUNCATE
+};
+typedef bool (*HalHostFileHook)(HalHostFileOp op, const char *path, size_t offset, size_t len);
+void halHostSetFileHook(HalHostFileHook hook);
+
+// Receives every I2C transaction (wlen bytes written, then rlen read into
+// rd, zeroed beforehand). Returning false is a NACK. Without a sink every
+// transaction is acked.
+typedef bool (*HalHostI2cSink)(uint8_t addr, const uint8_t *wr, size_t wlen, uint8_t *rd, size_t rlen);
+void halHostSetI2cSink(HalHostI2cSink sink);
@@ -0,0 +1,81 @@
+#pragma once
+// Power-of-two bucketed histogram for durations and latencies.
+//
+// Bucket b counts values in [2^b, 2^(b+1)), with 0 going into bucket 0, so
+// adding a value is a count-leading-zeros and an increment. Percentiles are
+// reported as the upper edge of the bucket they fall in: never low, at most
+// 2x high. Portable, so host tools can use it too.
+#include <stdint.h>
+#include <string.h>
+
+#define HISTOGRAM_BUCKETS 32
+
+struct Histogram
+{
+    uint32_t buckets[HISTOGRAM_BUCKETS];
+    uint32_t count;
+    uint32_t max;
+    uint64_t total;
+
+    Histogram() { reset(); }
+
+    void reset()
+    {
+        memset(buckets, 0, sizeof(buckets));
+        count = 0;
+        max = 0;
+        total = 0;
+    }
+
+    static int bucketOf(uint32_t v)
+    {
+        return v ? 31 - __builtin_clz(v) : 0;
+    }
+
+    // Largest value that lands in bucket b
+    static uint32_t bucketTop(int b)
+    {
+        return b >= 31 ? 0xFFFFFFFFu : (2u << b) - 1;
+    }
+
+    void add(uint32_t v)
+    {
+        buckets[bucketOf(v)]++;
+        count++;
+        total += v;
+        if (v > max)
+            max = v;
+    }
+
+    // Upper bound for the pct-th percentile (0-100), capped at the maximum
+    uint32_t percentile(uint8_t pct) const
+    {
+        if (!count)
+            return 0;
+        uint64_t rank = ((uint64_t)count * pct + 99) / 100;
+        if (rank == 0)
+            rank = 1;
+        uint64_t seen = 0;
+        for (int b = 0; b < HISTOGRAM_BUCKETS; b++)
+        {
+            seen += buckets[b];
+            if (seen >= rank)
+                return bucketTop(b) < max ? bucketTop(b) : max;
+        }
+        return max;
+    }
+
+    uint32_t mean() const
+    {
+        return count ? (uint32_t)(total / count) : 0;
+    }
+
+    // Index past the last non-empty bucket, for compact output
+    int usedBuckets() const
+    {
+        int n = HISTOGRAM_BUCKETS;
+        while (n > 0 && !buckets[n - 1])
+            n--;
+        return n;
+    }
+};
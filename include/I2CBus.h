@@ -0,0 +1,58 @@
+#pragma once
+// Shared I2C bus for the BME688 and the SSD1306.
+//
+// Sensor transactions always go straight through. The display is sent in
+// bounded chunks, and a chunk is held back when it could overlap the next
+// BSEC measurement. Every transaction takes the bus mutex, so a sensor task
+// on another core can share the bus safely. The bus itself is reached
+// through Hal.h, so the schedule also runs in the native build, where
+// test/test_i2c_bus replays BSEC cycles against UI traffic.
+#include <stdint.h>
+#include <stddef.h>
+
+// Both devices are specified for 400 kHz fast mode. Many SSD1306 modules
+// also run at 1 MHz, but that is out of spec, so it is a build flag.
+#ifndef I2C_BUS_CLOCK
+#define I2C_BUS_CLOCK 400000
+#endif
+
+// No display chunk starts this close to the next expected sensor cycle
+#define I2C_SENSOR_GUARD_MS 15
+
+struct I2CBusStats
+{
+    uint32_t sensorTransactions = 0;
+    uint32_t sensorErrors = 0;
+    uint32_t displayChunks = 0;
+    uint32_t displayDeferrals = 0; // Chunks held back for the sensor
+    uint32_t maxLockWaitUs = 0;    // Longest wait for the bus mutex
+};
+
+void initI2CBus(int sda, int scl);
+
+void i2cBusLock();
+void i2cBusUnlock();
+
+// Expected BSEC cycle length, from the subscribed sample rate
+void i2cBusSetSensorPeriod(uint32_t periodMs);
+
+// When BSEC's next measurement call is due. BSEC talks to the sensor as
+// soon as bsec_sensor_control() returns, so the first transaction of a
+// cycle marks the call and the next one follows one period later. Returns
+// false until a cycle has been seen at the current period.
+bool i2cBusNextSensorCycle(uint32_t &atMs);
+
+// halMillis() of the last sensor transaction
+uint32_t i2cBusLastSensorIoMs();
+
+// True if a display transfer of this many bytes can go now without
+// running into the next sensor cycle
+bool i2cBusDisplaySlot(size_t bytes);
+void i2cBusCountDisplayChunk(bool deferred);
+
+// Sensor register access behind the Bsec2::begin() callbacks
+// (SensorTask.cpp). Holds the bus for the transaction and marks the cycle.
+bool i2cSensorReadRegs(uint8_t addr, uint8_t reg, uint8_t *data, uint32_t len);
+bool i2cSensorWriteRegs(uint8_t addr, uint8_t reg, const uint8_t *data, uint32_t len);
+
+I2CBusStats getI2CBusStats();
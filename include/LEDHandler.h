@@ -38,5 +38,10 @@ void turnOffLED();
 // Update LED animations (call in loop for animated states)
 void updateLED();
 
+// When updateLED() next has to run for the animation to stay on time.
+// mustWake is set for the low-battery blink; the recording pulse is a slow
+// fade that can pause through a light sleep. Returns false if nothing is due.
+bool ledNextDeadline(uint32_t &atMs, bool &mustWake);
+
 // Quick flash for feedback
 void flashLED(uint8_t r, uint8_t g, uint8_t b, int duration_ms = 100);
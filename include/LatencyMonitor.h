@@ -0,0 +1,41 @@
+#pragma once
+// Loop responsiveness: how long each loop pass keeps the CPU, and how long
+// a button or touch press takes to show up on the panel.
+//
+// Input-to-pixel runs from the physical press edge (stamped by the pin's
+// interrupt) to the first frame that finishes reaching the display after a
+// handler acted on that press. Clicks fire on release, so it includes how
+// long the button was held, plus anything that blocked the loop meanwhile
+// (flushes, display pushes, delay() in menu actions).
+//
+// Loop task only. Kept free of Arduino dependencies; callers pass
+// timestamps in, so test/test_latency_monitor drives the same code from a
+// virtual clock.
+#include <stdint.h>
+#include "Histogram.h"
+
+struct LatencyStats
+{
+    Histogram loopUs;         // Busy time per loop pass
+    Histogram inputToPixelUs; // Press edge -> frame on the panel
+    uint32_t inputsIgnored = 0; // Presses no handler acted on (debounce, lockout)
+};
+
+// One loop pass, from its start to the point it blocks or sleeps
+void latencyLoopPass(uint32_t busyUs);
+
+// A press edge at edgeUs. Ignored while an earlier press is still on its
+// way to the panel.
+void latencyInputEdge(uint32_t edgeUs);
+
+// An input handler acted on the pending press
+void latencyInputHandled();
+
+// The input went idle; a press nobody acted on is dropped
+void latencyInputIdle();
+
+// A frame finished reaching the display at nowUs
+void latencyFrameShown(uint32_t nowUs);
+
+const LatencyStats &getLatencyStats();
+void resetLatencyStats();
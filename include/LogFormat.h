@@ -0,0 +1,82 @@
+#pragma once
+// Binary recording format (".hlg").
+// Kept free of Arduino dependencies so the host-side converter in tools/
+// can compile the exact same encoder/decoder.
+#include <stdint.h>
+#include <stddef.h>
+
+struct LogData
+{
+    unsigned long timestamp;
+    float iaq;
+    float co2;
+    float temp;
+    float hum;
+};
+
+// File layout (all integers little-endian):
+//
+//   Header (16 bytes)
+//     u32 magic "HHLG", u8 version, u8 schema, u8 recordSize, u8 reserved,
+//     u32 startMs (millis() of the first sample), u32 sessionId (log index)
+//
+//   Block (repeated)
+//     u8 'B', u8 count, u16 blockSeq
+//     count * record
+//     u32 crc32 over the block header + records
+//
+//   Record (14 bytes)
+//     u32 timestamp ms, u16 iaq*100, u32 co2*100, i16 temp*100, u16 hum*100
+//
+// Values are stored with the same 2-decimal resolution the CSV files use.
+
+#define LOG_BIN_MAGIC 0x474C4848UL // "HHLG"
+#define LOG_BIN_VERSION 1
+#define LOG_BIN_HEADER_SIZE 16
+#define LOG_BIN_BLOCK_MARKER 'B'
+#define LOG_BIN_BLOCK_HEADER_SIZE 4
+#define LOG_BIN_BLOCK_CRC_SIZE 4
+#define LOG_BIN_RECORD_SIZE 14
+#define LOG_BIN_BLOCK_MAX_RECORDS 64
+#define LOG_BIN_BLOCK_MAX_SIZE (LOG_BIN_BLOCK_HEADER_SIZE + LOG_BIN_BLOCK_MAX_RECORDS * LOG_BIN_RECORD_SIZE + LOG_BIN_BLOCK_CRC_SIZE)
+
+// Channel schema bits
+#define LOG_CH_IAQ 0x01
+#define LOG_CH_CO2 0x02
+#define LOG_CH_TEMP 0x04
+#define LOG_CH_HUM 0x08
+#define LOG_SCHEMA_DEFAULT (LOG_CH_IAQ | LOG_CH_CO2 | LOG_CH_TEMP | LOG_CH_HUM)
+
+struct LogBinHeader
+{
+    uint32_t magic;
+    uint8_t version;
+    uint8_t schema;
+    uint8_t recordSize;
+    uint32_t startMs;
+    uint32_t sessionId;
+};
+
+uint32_t logCrc32(const uint8_t *data, size_t len, uint32_t crc = 0);
+
+// Returns bytes written (LOG_BIN_HEADER_SIZE)
+size_t logBinEncodeHeader(uint8_t *out, uint32_t startMs, uint32_t sessionId);
+bool logBinDecodeHeader(const uint8_t *in, size_t len, LogBinHeader &hdr);
+
+// Encodes up to LOG_BIN_BLOCK_MAX_RECORDS samples into one block.
+// Returns bytes written, or 0 if out is too small.
+size_t logBinEncodeBlock(uint8_t *out, size_t outSize, uint16_t blockSeq, const LogData *samples, int count);
+
+// Decodes one block from the start of in. Returns the number of samples,
+// or -1 if the block is incomplete or its CRC doesn't match (torn write).
+// consumed is set to the encoded block size on success.
+int logBinDecodeBlock(const uint8_t *in, size_t len, LogData *out, int maxOut, size_t &consumed, uint16_t *blockSeq = nullptr);
+
+// Formats one sample the way the CSV recordings do. Returns the line length.
+int logCsvFormatLine(char *out, size_t outSize, const LogData &sample);
+
+// Parses one CSV record (without its line ending). Returns false for the
+// header line or anything that isn't five numeric fields.
+bool logCsvParseLine(const char *line, size_t len, LogData &out);
+
+#define LOG_CSV_HEADER "Time(ms),IAQ,CO2,Temp,Hum\n"
@@ -0,0 +1,49 @@
+#pragma once
+#include <Arduino.h>
+#include "LogFormat.h"
+
+// Persistent index of recordings, so listing/quota code never has to walk the
+// LittleFS directory. Updated incrementally by the recording code and rebuilt
+// from a directory scan only when the file is missing or fails validation.
+#define LOG_MANIFEST_FILE "/logs.idx"
+#define LOG_MANIFEST_MAX 64
+// The active entry changes on every commit; don't rewrite the index more often
+#define LOG_MANIFEST_SAVE_INTERVAL 300000
+
+struct LogManifestEntry
+{
+    int32_t index;    // NNN in /log_NNN.xxx
+    uint8_t format;   // LogFileFormat
+    uint8_t schema;   // LOG_CH_* bits
+    uint16_t reserved;
+    uint32_t size;    // Bytes on flash (incl. the writer's buffered tail for the active file)
+    uint32_t samples;
+    uint32_t startMs; // Timestamp of the first / last sample
+    uint32_t endMs;
+};
+
+// Load (or rebuild) the manifest. Call once in setup after LittleFS.begin.
+void initLogManifest();
+
+// Throw the index away and rebuild it from the files on flash
+void logManifestRebuild();
+
+// A new recording file was started
+void logManifestAdd(const char *fileName);
+
+// Samples were appended to fileName, which is now size bytes long
+void logManifestRecord(const char *fileName, const LogData *samples, int count, uint32_t size);
+
+// Correct the size after recovery truncated the file
+void logManifestSetSize(const char *fileName, uint32_t size);
+
+// The file was deleted
+void logManifestRemove(const char *fileName);
+
+// Write the index to flash. Without force, only if dirty and the save
+// interval has passed.
+void logManifestSave(bool force);
+
+int logManifestCount();
+bool logManifestGet(int i, LogManifestEntry &out);
+void logManifestFileName(const LogManifestEntry &entry, char *out, size_t len);
@@ -0,0 +1,63 @@
+#pragma once
+// Plays a recording (.csv or .hlg) back as a stream of samples, paced by
+// the recorded timestamps. The sensor task uses it for the demo mode; the
+// native build drives the same code from the host filesystem.
+//
+// Files are read through Hal.h in chunks, so only one chunk and one decoded
+// binary block are held in RAM. Recordings only carry IAQ, CO2, temperature
+// and humidity; logReplayApply() leaves the other fields of a reading alone.
+#include <stdint.h>
+#include <stddef.h>
+#include "LogFormat.h"
+#include "SharedData.h"
+
+#define LOG_REPLAY_CHUNK 1024 // Holds at least one full binary block
+// Recorded gaps longer than this (device off, resumed session) are skipped
+#define LOG_REPLAY_MAX_GAP_MS 60000
+
+struct LogReplay
+{
+    bool active = false;
+    bool binary = false;
+    bool loop = false;
+    float speed = 1.0f; // 1 = real time, 0 = as fast as possible
+    char path[32] = "";
+
+    // File position and read buffer
+    uint32_t fileOffset = 0;
+    uint8_t buf[LOG_REPLAY_CHUNK];
+    size_t bufLen = 0;
+    size_t bufPos = 0;
+    bool headerDone = false;
+
+    // Decoded samples of the current binary block
+    LogData block[LOG_BIN_BLOCK_MAX_RECORDS];
+    int blockCount = 0;
+    int blockPos = 0;
+
+    // Next sample and when it is due
+    LogData next;
+    bool hasNext = false;
+    uint32_t nextDueMs = 0;
+    unsigned long lastTimestamp = 0;
+
+    uint32_t samples = 0; // Delivered so far
+    uint32_t loops = 0;   // Times the file wrapped around
+    uint32_t skipped = 0; // Lines / blocks that didn't parse
+};
+
+// Start playing path. The first sample is due at nowMs. Returns false if
+// the file is empty or not a recording.
+bool logReplayOpen(LogReplay &r, const char *path, float speed, bool loop, uint32_t nowMs);
+
+void logReplayClose(LogReplay &r);
+
+// The next sample if it is due at nowMs. Returns false when nothing is due
+// yet, or when playback ended (active turns false).
+bool logReplayNext(LogReplay &r, uint32_t nowMs, LogData &out);
+
+// When the next sample is due (only meaningful while active)
+uint32_t logReplayDueMs(const LogReplay &r);
+
+// Overlay a replayed sample on a reading
+void logReplayApply(const LogData &sample, SensorReadings &r);
@@ -0,0 +1,28 @@
+#pragma once
+#include <Arduino.h>
+#include "LogFormat.h"
+
+// ECO-mode staging buffer in RTC slow memory. Samples accumulate here across
+// light/deep sleep and soft resets and are committed to the recording in one
+// batch when the buffer is nearly full or recording stops.
+//
+// 96 samples * 20 B = 1.9 KiB of the 8 KiB RTC slow memory. At the 5-minute
+// ECO rate that is one flash commit every ~7 hours instead of every sample.
+#define LOG_STAGE_CAPACITY 96
+#define LOG_STAGE_COMMIT_THRESHOLD 88
+
+// Validate the RTC contents after boot. Staged samples are kept only if they
+// belong to logIndex (the recording that was resumed); pass -1 to discard.
+void initLogStaging(int logIndex);
+
+// Stage a sample for the given recording. Returns true when the buffer is
+// nearly full and should be drained.
+bool logStagePush(const LogData &sample, int logIndex);
+
+// Hand the staged samples to the log writer and ask it to commit them,
+// without waiting for flash. They stay staged (and count in
+// logStageCount()) until the writer reports them committed, so a reset
+// before the commit loses nothing. Returns the number of samples handed over.
+int logStageDrain();
+
+int logStageCount();
@@ -0,0 +1,42 @@
+#pragma once
+#include <Arduino.h>
+
+// Recordings are split into segments: once the active file reaches this size
+// recording continues in a new /log_NNN file.
+#define LOG_SEGMENT_SIZE (128 * 1024)
+
+// Default share of the filesystem recordings may use when no quota is set
+#define LOG_QUOTA_DEFAULT_PCT 80
+
+struct LogStorageReport
+{
+    uint32_t totalBytes = 0;
+    uint32_t usedBytes = 0;
+    uint32_t freeBytes = 0;
+    uint32_t quotaBytes = 0;
+    uint32_t logBytes = 0;       // Bytes used by recordings
+    int segments = 0;            // Number of recording files
+    int oldestIndex = -1;
+    float bytesPerSample = 0;    // Measured (or nominal) for the current format
+    uint32_t remainingSec = 0;   // Estimated recording time left at the current opMode
+};
+
+// Quota in bytes: sysConfig.logQuotaKB, or LOG_QUOTA_DEFAULT_PCT of the FS
+uint32_t logStorageQuota();
+
+// A requested quota limited to one segment .. the filesystem size (0 stays 0)
+uint32_t logStorageClampQuotaKB(uint32_t kb);
+
+// Delete the oldest recordings (never the active one) until another
+// reserveBytes fit within the quota and the free space, and the manifest
+// has room for one more file.
+// Returns the number of files removed.
+int logStorageEnforceQuota(uint32_t reserveBytes);
+
+// True if the active recording has reached LOG_SEGMENT_SIZE
+bool logStorageSegmentFull();
+
+LogStorageReport getLogStorageReport();
+
+// Parses "/log_NNN.csv" / "/log_NNN.hlg" (leading slash optional). -1 otherwise.
+int logFileIndex(const char *name);
@@ -0,0 +1,129 @@
+#pragma once
+// Recording writer: a double buffer filled by the sensor task and a writer
+// task that formats full buffers into the open recording file.
+//
+// The writer itself is portable (files and clock through Hal.h); only the
+// task around logWriterRun() is per platform: src/LogWriterTask.cpp on the
+// board, src/native/LogWriterHost.cpp on the host, where a wake-up runs the
+// pass inline so test/ can drive the writer step by step.
+#include <stdint.h>
+#include <stddef.h>
+#include "LogFormat.h"
+
+// Samples per buffer. Two of these exist: one being filled by the sensor
+// callback while the other is formatted and written by the writer task.
+#define LOG_BUFFER_SIZE 300
+
+// LittleFS block size on the ESP32 flash. The recording file is only written
+// in whole blocks, except for the tail on a metadata commit.
+#define LOG_FLASH_BLOCK_SIZE 4096
+// Default cadence for pushing the buffered tail + file metadata to flash
+#define LOG_COMMIT_INTERVAL_MS 60000
+
+struct LogWriterStats
+{
+    uint32_t buffersWritten = 0;
+    uint32_t samplesWritten = 0;
+    uint32_t droppedSamples = 0;    // Samples lost because both buffers were busy
+    uint32_t lastSwapLatencyUs = 0; // Handoff -> writer task picking the buffer up
+    uint32_t maxSwapLatencyUs = 0;
+    uint32_t lastWriteMs = 0; // Time spent formatting + writing the last buffer
+    uint32_t maxWriteMs = 0;
+    uint32_t flashBytesWritten = 0; // Bytes handed to LittleFS
+    uint32_t flashWrites = 0;       // Number of file.write() calls
+    uint32_t commits = 0;           // Metadata commits (file.flush())
+    char sessionFile[32] = "";      // File the writer currently holds open
+    uint32_t sessionBytes = 0;      // Its size including the buffered tail
+};
+
+// True for recordings using the binary format from LogFormat.h
+bool isBinaryLogName(const char *fileName);
+
+// Start the background writer task (call once in setup, after LittleFS.begin)
+void initLogWriter();
+
+// Recording index the writer keeps current (LogManifest registers itself in
+// initLogManifest()). Unset hooks are skipped.
+struct LogWriterIndex
+{
+    // Samples were appended; the file is now size bytes including the tail
+    void (*record)(const char *fileName, const LogData *samples, int count, uint32_t size);
+    // Recovery cut the file down to size bytes
+    void (*setSize)(const char *fileName, uint32_t size);
+    // The file was committed (force: closed)
+    void (*save)(bool force);
+};
+void logWriterSetIndex(const LogWriterIndex &index);
+
+// Append a sample to the active buffer. The buffer is handed to the writer
+// task automatically when it fills up. Returns false if the sample was dropped.
+bool logWriterPush(const LogData &sample);
+
+// Hand the active buffer to the writer even if it isn't full.
+// With wait=true, blocks until the writer has taken everything queued so far.
+void logWriterFlush(bool wait = false);
+
+// Flush and commit the recording file, blocking until it is on flash
+void logWriterCommit();
+
+// Same without waiting: the buffered samples are committed together with
+// the next handoff, which is attempted right away. Safe on the sensor task.
+void logWriterRequestCommit();
+
+// Flush, then commit and close the recording file (stop recording)
+void logWriterClose();
+
+// How often the open recording is committed to flash
+void logWriterSetCommitInterval(uint32_t intervalMs);
+
+// Power-safe batching: hand the active buffer over and commit it every
+// N samples, bounding what a power loss can take. 0 disables.
+void logWriterSetSyncBatch(int samples);
+
+// Discard any samples that haven't been handed over yet (new recording)
+void logWriterReset();
+
+// Samples sitting in the active buffer
+int logWriterPending();
+
+// True while the writer task is formatting/writing a buffer
+bool isLogWriterBusy();
+
+// Samples accepted by logWriterPush() so far, and how many of those are
+// committed to flash. Both only count up (modulo 2^32): everything pushed
+// up to a logWriterPushedSeq() value is durable once logWriterCommittedSeq()
+// has reached it. Samples discarded by logWriterReset() still count.
+uint32_t logWriterPushedSeq();
+uint32_t logWriterCommittedSeq();
+
+LogWriterStats getLogWriterStats();
+
+// Persist which file is being recorded so an interrupted session can be
+// found again after a brownout/reset. Cleared when recording stops.
+void logSessionBegin(const char *fileName, int logIndex);
+void logSessionEnd();
+
+// Boot-time recovery: if a recording was interrupted, truncate any torn tail
+// (partial CSV line / binary block with a bad CRC) and return its file name
+// so recording can resume; binary files continue their block sequence.
+// If the tail can't be cut, the index ends the file at its valid length
+// and the caller starts a new segment instead. expectedIndex is
+// sysConfig.nextLogIndex - 1.
+enum LogRecovery
+{
+    LOG_RECOVER_NONE,       // Nothing was being recorded
+    LOG_RECOVER_RESUME,     // Keep appending to fileName
+    LOG_RECOVER_NEW_SEGMENT // Start the next /log_NNN file
+};
+LogRecovery recoverLogSession(int expectedIndex, char *fileName, size_t len);
+
+// --- WRITER TASK (per platform) ---
+// One writer pass: write a handed-off buffer, then commit or close if
+// requested or due. Returns how many ms the task may sleep before the next
+// cadence commit, 0 to sleep until woken.
+uint32_t logWriterRun();
+
+// Implemented by the platform: create the task (from initLogWriter()) and
+// wake it for a pass
+void logWriterStartTask();
+void logWriterWake();
@@ -0,0 +1,59 @@
+#pragma once
+#include <Arduino.h>
+
+// CPU frequency scaling, light sleep and the loop's wake-up event.
+//
+// The Arduino loop blocks on powerWaitLoop() between passes instead of
+// spinning; sensor readings, button/touch interrupts, WiFi and BLE events
+// signal it early. While every task is blocked the idle task lets the
+// power manager drop the CPU to POWER_MIN_CPU_MHZ, and, when the SDK is
+// built with tickless idle, enter light sleep by itself. Otherwise the loop
+// still calls esp_light_sleep_start() from the wake-deadline scheduler.
+
+#ifndef POWER_MAX_CPU_MHZ
+#define POWER_MAX_CPU_MHZ 80
+#endif
+// 40 MHz runs from the crystal. Drivers that need an 80 MHz APB clock
+// (I2C, RMT) hold a power-management lock while they are busy.
+#ifndef POWER_MIN_CPU_MHZ
+#define POWER_MIN_CPU_MHZ 40
+#endif
+
+// Longest single wait, well inside the task watchdog timeout
+#define POWER_MAX_WAIT_MS 10000
+
+// Time since boot per power state, in the chip's terms: awake with a radio
+// in use (active), awake with the radios off (modem sleep), light sleep
+struct PowerResidency
+{
+    uint64_t activeMs = 0;
+    uint64_t modemSleepMs = 0;
+    uint64_t lightSleepMs = 0;
+    uint32_t lightSleeps = 0;
+    bool dfs = false;            // esp_pm_configure() accepted
+    bool autoLightSleep = false; // Tickless idle does the light sleeps
+    uint16_t minMhz = 0;
+    uint16_t maxMhz = 0;
+};
+
+// Call once from setup(), on the loop task
+void initPower();
+
+// True when light sleep is left to tickless idle; the loop then only waits
+bool powerAutoLightSleep();
+
+// Keep tickless idle out of light sleep (interactive screens, REALTIME).
+// No effect when the loop does its own light sleep.
+void powerHoldAwake(bool hold);
+
+// Wake the loop from another task, or from an interrupt handler
+void powerSignalLoop();
+void IRAM_ATTR powerSignalLoopFromISR();
+
+// Block the loop until signalled or timeoutMs passes
+void powerWaitLoop(uint32_t timeoutMs);
+
+// Residency bookkeeping
+void powerSetRadioActive(bool on);
+void powerNoteLightSleep(uint64_t sleptUs);
+PowerResidency getPowerResidency();
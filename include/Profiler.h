@@ -0,0 +1,69 @@
+#pragma once
+#include "Histogram.h"
+
+// Where the awake time goes: scoped cycle-counter timers around the hot
+// paths of each subsystem, aggregated into totals and histograms.
+//
+//   { PROFILE_SCOPE(PROF_BSEC); envSensor.run(); }
+//
+// Build with -DPROFILER_ENABLED=0 to compile every timer, the STATS page and
+// /api/metrics out.
+
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+enum ProfileSlot
+{
+    PROF_BSEC,    // envSensor.run() (sensor task)
+    PROF_DISPLAY, // displayPush()
+    PROF_LOG,     // Log writer: buffer formatting, file writes, commits
+    PROF_WEB,     // server.handleClient() + WebUI stream
+    PROF_BLE,     // updateBLEData()
+    PROF_TOUCH,   // checkTouchInput()
+    PROF_SLOT_COUNT
+};
+
+struct ProfileStats
+{
+    const char *name = "";
+    uint32_t calls = 0;
+    uint64_t totalUs = 0;
+    uint32_t maxUs = 0;
+    uint32_t meanUs = 0;
+    uint32_t p50Us = 0;
+    uint32_t p90Us = 0;
+    uint32_t p99Us = 0;
+    Histogram cycles; // Raw per-call cycle counts
+};
+
+#if PROFILER_ENABLED
+#include <Arduino.h>
+
+void profileRecord(ProfileSlot slot, uint32_t cycles);
+
+// Copy of one slot, converted to microseconds at the current CPU clock.
+// Tasks run at the maximum DFS frequency, so that is what the cycles mean.
+ProfileStats getProfileStats(ProfileSlot slot);
+void resetProfileStats();
+
+class ProfileScope
+{
+public:
+    explicit ProfileScope(ProfileSlot slot) : slot(slot), start(ESP.getCycleCount()) {}
+    ~ProfileScope() { profileRecord(slot, ESP.getCycleCount() - start); }
+
+private:
+    ProfileSlot slot;
+    uint32_t start;
+};
+
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+#define PROFILE_SCOPE(slot) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(slot)
+
+#else
+
+#define PROFILE_SCOPE(slot) ((void)0)
+
+#endif
@@ -0,0 +1,79 @@
+#pragma once
+#include <Arduino.h>
+#include "SharedData.h"
+
+// BSEC + logging pipeline on its own FreeRTOS task, pinned to the core the
+// Arduino loop (display, input, WiFi, web server, BLE) doesn't use. The
+// two sides only talk through queues: readings flow out to the loop,
+// commands flow in. Everything that touches envSensor or pushes samples to
+// the log writer runs on this task once it has started.
+
+#ifndef SENSOR_TASK_CORE
+#define SENSOR_TASK_CORE 0 // The Arduino loop runs on core 1
+#endif
+
+enum SensorCommandType
+{
+    SENSOR_CMD_SET_RATE,   // Subscribe all outputs at sampleRate (Hz)
+    SENSOR_CMD_SAVE_STATE, // Force a BSEC state save; replies true if saved
+    SENSOR_CMD_RECORD_START,
+    SENSOR_CMD_RECORD_STOP,
+    SENSOR_CMD_REPLAY_START, // Demo mode: play fileName back in a loop
+    SENSOR_CMD_REPLAY_STOP
+};
+
+// Playback speed range for the demo mode (1 = real time)
+#define SENSOR_REPLAY_MAX_SPEED 100.0f
+// Replayed samples published per task pass at most
+#define SENSOR_REPLAY_BURST 4
+
+struct SensorCommand
+{
+    SensorCommandType type;
+    float sampleRate;     // Hz for SET_RATE, playback speed for REPLAY_START
+    TaskHandle_t replyTo; // Notified with the result when set
+    char fileName[32];    // REPLAY_START; empty = newest finished recording
+};
+
+struct SensorStatus
+{
+    int bsecStatus = 0;
+    int8_t sensorStatus = 0;
+    bool stateLoaded = false;
+    bool hasSavedSinceBoot = false;
+    bool isSaving = false;
+    uint32_t lastStateSaveMs = 0;
+    uint32_t lastRunMs = 0;         // Last BSEC output
+    uint32_t droppedReadings = 0;   // Readings queue was full
+    bool replaying = false;         // Demo mode: readings come from a recording
+    char replayFile[32] = "";
+    uint32_t replaySamples = 0;
+    uint32_t replayDueMs = 0;       // Next replayed sample
+};
+
+// Bring up BSEC on the shared bus, restore its saved state and start the
+// task. Returns false if BSEC didn't start (see getSensorStatus()).
+bool initSensorTask();
+
+// Queue a command without waiting
+bool sensorSend(SensorCommandType type, float sampleRate = 0);
+
+// Queue a command and wait for the task to handle it. Returns its result,
+// or false on timeout.
+bool sensorRequest(SensorCommandType type, uint32_t timeoutMs);
+
+// Start the demo mode: replay a recording through the same pipeline as
+// live readings (graphs, web, BLE, recorder), looping at its end. An empty
+// fileName picks the newest recording that isn't being written.
+bool sensorReplay(const char *fileName, float speed);
+
+// Next reading from the task, if any (non-blocking, loop side)
+bool sensorReceive(SensorReadings &out);
+
+SensorStatus getSensorStatus();
+
+// When BSEC next wants to be called (millis()), for the sleep scheduler.
+// Taken from the observed measurement cycle on the bus; until one has been
+// seen at the current rate, estimated from the last output. In demo mode,
+// the next replayed sample if that comes first.
+uint32_t sensorNextCallMs();
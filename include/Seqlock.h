@@ -0,0 +1,75 @@
+#pragma once
+// Single-writer sequence lock for publishing a small struct to readers on
+// other tasks or cores without ever blocking the writer.
+//
+// The writer makes the sequence odd, stores the payload, then makes it even
+// again. A reader copies the payload and retries if the sequence was odd or
+// moved underneath it. The payload is kept as relaxed atomic words, so a
+// torn copy is detected and retried rather than being a data race.
+//
+// Plain C++11 so test/test_seqlock can run the same code on the host.
+// Readers spin while a write is in flight, so never read from a task that
+// can preempt the writer on the same core.
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+template <typename T>
+class Seqlock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Seqlock payload must be trivially copyable");
+
+public:
+    Seqlock()
+    {
+        for (size_t i = 0; i < WORDS; i++)
+            words[i].store(0, std::memory_order_relaxed);
+    }
+
+    // Only one task may write
+    void write(const T &value)
+    {
+        uint32_t buf[WORDS] = {0};
+        memcpy(buf, &value, sizeof(T));
+
+        uint32_t s = seq.load(std::memory_order_relaxed);
+        seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; i++)
+            words[i].store(buf[i], std::memory_order_relaxed);
+        seq.store(s + 2, std::memory_order_release);
+    }
+
+    // Copies a consistent snapshot into out and returns its sequence number:
+    // the number of completed writes (0 = never written).
+    uint32_t read(T &out) const
+    {
+        uint32_t buf[WORDS];
+        for (;;)
+        {
+            uint32_t s1 = seq.load(std::memory_order_acquire);
+            if (s1 & 1)
+                continue;
+            for (size_t i = 0; i < WORDS; i++)
+                buf[i] = words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq.load(std::memory_order_relaxed) == s1)
+            {
+                memcpy(&out, buf, sizeof(T));
+                return s1 >> 1;
+            }
+        }
+    }
+
+    // Cheap "anything new?" check against a sequence from read()
+    uint32_t sequence() const
+    {
+        return seq.load(std::memory_order_acquire) >> 1;
+    }
+
+private:
+    static const size_t WORDS = (sizeof(T) + 3) / 4;
+    std::atomic<uint32_t> seq{0};
+    std::atomic<uint32_t> words[WORDS];
+};
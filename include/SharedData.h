@@ -1,5 +1,6 @@
 #pragma once
-#include <Arduino.h>
+#include <stdint.h>
+#include "Seqlock.h"
 
 struct SensorReadings
 {
@@ -11,6 +12,7 @@ struct SensorReadings
     float voltage = 0.0;
     int batteryPercent = 0;
     uint8_t accuracy = 0;
+    uint32_t seq = 0; // Sample number, as readingsSnapshot() reports it
 };
 
 struct Stats
@@ -27,15 +29,47 @@ enum OpMode
     MODE_ECO
 };
 
+enum LogFileFormat
+{
+    LOG_FORMAT_CSV,
+    LOG_FORMAT_BIN
+};
+
 struct SystemConfig
 {
     OpMode opMode = MODE_NORMAL;
     int timeoutIndex = 1;
     int nextLogIndex = 1;
+    LogFileFormat logFormat = LOG_FORMAT_CSV;
+    uint32_t logQuotaKB = 0; // 0 = LOG_QUOTA_DEFAULT_PCT of the filesystem
 };
 
-extern volatile SensorReadings currentData;
+// Latest readings, written only by the sensor task
+extern Seqlock<SensorReadings> currentReadings;
+
+// Consistent copy of the latest readings from any task. seq, if given, is
+// the sample number; it grows by one per sample (0 = none yet).
+SensorReadings readingsSnapshot(uint32_t *seq = nullptr);
 extern Stats sysStats;
 extern SystemConfig sysConfig;
+
+// Owned by the sensor task (and setup, before the task starts). Other tasks
+// read them through recordingSnapshot(): the file name can change under a
+// reader when a new segment starts.
 extern bool isRecording;
 extern char currentLogFileName[32];
+
+struct RecordingState
+{
+    bool active = false;
+    char fileName[32] = "";
+};
+
+// Copies isRecording / currentLogFileName for other tasks; the owner calls
+// this after every change
+void publishRecordingState();
+RecordingState recordingSnapshot();
+
+// Persist sysConfig (implemented in main.cpp). Callable from any task:
+// each config field has one writing task, and saves are serialised.
+void saveConfig();
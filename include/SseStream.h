@@ -0,0 +1,62 @@
+#pragma once
+// Server-Sent Events fan-out behind /api/stream. Free of Arduino / WiFi:
+// clients are slots the caller maps to its sockets and every write goes
+// through SseLink, so test/test_sse_stream runs the same push path against
+// simulated sockets on a virtual clock.
+//
+// Each new reading goes out as one "data: {...}\n\n" event to every client
+// at once. With nothing new, a comment line keeps the connection alive
+// every SSE_KEEPALIVE_MS. A client that is gone, or whose socket can't
+// take a whole event (it stopped reading), is closed and its slot freed.
+#include <stdint.h>
+#include <stddef.h>
+#include "SharedData.h"
+
+#define SSE_MAX_CLIENTS 4
+#define SSE_KEEPALIVE_MS 15000
+#define SSE_EVENT_MAX 544
+
+// The caller's sockets, by slot
+struct SseLink
+{
+    // Bytes the socket took, without blocking
+    size_t (*write)(int slot, const uint8_t *data, size_t len) = nullptr;
+    bool (*connected)(int slot) = nullptr;
+    // Close the socket and release it
+    void (*close)(int slot) = nullptr;
+};
+
+struct SseStream
+{
+    SseLink link;
+    bool open[SSE_MAX_CLIENTS] = {};
+    uint32_t lastWriteMs = 0;
+
+    uint32_t events = 0;     // Data events published
+    uint32_t keepalives = 0;
+    uint32_t dropped = 0;    // Clients closed by the stream
+};
+
+void sseInit(SseStream &s, const SseLink &link, uint32_t nowMs);
+
+// "data: {...}\n\n" for the current readings (apiDataJson() body).
+// msg needs SSE_EVENT_MAX bytes. Returns the length written.
+int sseDataEvent(char *msg, size_t len, const SensorReadings &r, uint32_t seq,
+                 uint32_t uptimeMs, bool recording, const char *recFile);
+
+// A slot for a new client, closing a disconnected one if needed; -1 if all
+// SSE_MAX_CLIENTS are live
+int sseFreeSlot(SseStream &s);
+
+// The client in slot has its headers and first event: stream to it
+void sseAttach(SseStream &s, int slot);
+
+// One event to every client (call when new data arrives)
+void ssePublish(SseStream &s, const char *msg, size_t len, uint32_t nowMs);
+
+// Keep-alive once SSE_KEEPALIVE_MS passed without a write (call from loop)
+void ssePoll(SseStream &s, uint32_t nowMs);
+
+int sseClientCount(const SseStream &s);
+
+void sseCloseAll(SseStream &s);
@@ -0,0 +1,35 @@
+#pragma once
+#include <Arduino.h>
+
+// Per-task CPU time and stack headroom. Each task brackets its working
+// section with taskMonitorBegin/End; time spent blocked on a queue,
+// notification or delay is not counted.
+
+// Load is reported over this window
+#define TASK_LOAD_WINDOW_MS 5000
+
+enum TaskSlot
+{
+    TASK_SLOT_UI,     // Arduino loop: display, input, WiFi, web server, BLE
+    TASK_SLOT_SENSOR, // BSEC + logging pipeline
+    TASK_SLOT_LOG_WRITER,
+    TASK_SLOT_COUNT
+};
+
+struct TaskLoad
+{
+    const char *name = "";
+    bool registered = false;
+    int core = -1;                // Core the last busy section ran on
+    uint16_t loadPermille = 0;    // Busy share of the last full window
+    uint32_t maxBusyUs = 0;       // Longest single busy section
+    uint32_t stackFreeBytes = 0;  // High-water mark: least free stack seen
+};
+
+// Call from the task itself, once, before its first busy section
+void taskMonitorRegister(TaskSlot slot, const char *name);
+
+void taskMonitorBegin(TaskSlot slot);
+void taskMonitorEnd(TaskSlot slot);
+
+TaskLoad getTaskLoad(TaskSlot slot);
@@ -0,0 +1,46 @@
+#pragma once
+// Screen navigation driven by the single button: which screen is up, the
+// menu cursor, and the graph / stats page selection. Pure state, no
+// drawing or side effects, so the native build can drive it; main.cpp
+// carries out the commands it returns.
+#include <stdint.h>
+
+enum UiState
+{
+    DASHBOARD,
+    MENU,
+    GRAPH,
+    STATS,
+    CONFIRM_RESET
+};
+
+#define UI_MENU_ROWS 5 // Menu lines that fit below the header
+
+struct UiNav
+{
+    UiState state = DASHBOARD;
+    int selectedItem = 0;
+    int menuScrollOffset = 0;
+    int activeGraph = 0; // Channel on the graph screen
+    int activeSpan = 0;  // 0 = raw samples, then 1m / 15m / 1h tiers
+    int statsPage = 0;
+};
+
+enum UiCommand
+{
+    UI_CMD_NONE,
+    UI_CMD_RUN_ITEM,   // Run menuItems[selectedItem]
+    UI_CMD_RESET_STATE // Confirmed: delete the BSEC state and restart
+};
+
+// Sizes of the pages the button cycles through
+struct UiLayout
+{
+    int menuLength;
+    int graphChannels;
+    int graphSpans;
+    int statsPages;
+};
+
+UiCommand uiClick(UiNav &nav, const UiLayout &layout);
+UiCommand uiLongPress(UiNav &nav);
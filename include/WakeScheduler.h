@@ -0,0 +1,71 @@
+#pragma once
+// Wake-deadline scheduler for light sleep.
+//
+// Each subsystem that needs the CPU at a known time arms a deadline; the
+// loop blocks until the earliest one (or an event) instead of spinning, and
+// light sleep ends at the earliest one that has to interrupt a sleep. GPIO,
+// touch and sensor readings signal the loop on their own, so input only
+// arms a deadline while a gesture is in progress.
+//
+// Kept free of Arduino dependencies so test/test_wake_scheduler can drive
+// the same code with a simulated clock. All times are millis() values;
+// comparisons are wrap-safe.
+#include <stdint.h>
+
+enum WakeSource
+{
+    WAKE_SENSOR,  // BSEC's next measurement call
+    WAKE_LED,     // Status LED blink step
+    WAKE_BLE,     // BLE connection / advertising service interval
+    WAKE_INPUT,   // Button or touch gesture still being decoded
+    WAKE_DISPLAY, // Frame held back for a sensor cycle
+    WAKE_WEB,     // WiFi up: the web server and OTA are polled
+    WAKE_UI,      // Next frame, blink or screen timeout
+    WAKE_SOURCE_COUNT
+};
+
+// What a deadline bounds. The loop's blocking wait ends at the earliest
+// WAKE_FROM_WAIT deadline; a light sleep only at the earliest WAKE_FROM_SLEEP.
+enum WakeKind
+{
+    WAKE_FROM_WAIT = 1,  // Loop work; may slip while the chip sleeps
+    WAKE_FROM_SLEEP = 2, // Another task or the radio needs the chip awake
+    WAKE_FROM_BOTH = 3
+};
+
+// Never sleep for less than this; the wake-up costs more than it saves.
+// Short enough that a connected BLE link (50 ms) still sleeps between events.
+#define WAKE_MIN_SLEEP_MS 30
+// Wake this much before the deadline so the sensor task is running in time
+#define WAKE_LEAD_MS 10
+
+struct WakeStats
+{
+    uint32_t sleeps = 0;
+    uint32_t timerWakeups[WAKE_SOURCE_COUNT] = {0}; // By the deadline that set the timer
+    uint32_t externalWakeups = 0;                   // Button / touch
+    uint64_t sleptMs = 0;
+};
+
+void wakeAt(WakeSource src, uint32_t atMs, WakeKind kind = WAKE_FROM_BOTH);
+void wakeClear(WakeSource src);
+void wakeClearAll();
+
+// Earliest armed deadline of the given kind. Returns false if none is armed.
+bool wakeNextDeadline(uint32_t nowMs, uint32_t &atMs, WakeSource &src, WakeKind kind = WAKE_FROM_SLEEP);
+
+// How long the loop may block from nowMs: until the earliest WAKE_FROM_WAIT
+// deadline, at most maxMs, 0 if one is already due.
+uint32_t wakePlanWait(uint32_t nowMs, uint32_t maxMs);
+
+// How long to sleep from nowMs: the earliest WAKE_FROM_SLEEP deadline minus WAKE_LEAD_MS,
+// or 0 if that is under WAKE_MIN_SLEEP_MS (or nothing is armed, since then
+// there is no wake-up time to trust). src is the deadline that decided it.
+uint32_t wakePlanSleep(uint32_t nowMs, WakeSource &src);
+
+// Bookkeeping for the STATS page / simulation
+void wakeNoteSleep(WakeSource src, uint32_t sleptMs, bool external);
+WakeStats getWakeStats();
+void resetWakeStats();
+
+const char *wakeSourceName(WakeSource src);
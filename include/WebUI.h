@@ -1,6 +1,15 @@
 #pragma once
 #include <WebServer.h>
 #include <LittleFS.h>
+#include "SharedData.h"
 
 void setupWebUI(WebServer &server);
 void stopWebUI(WebServer &server);
+
+// Push one reading to every /api/stream client (call for each new sample,
+// in order). r.seq and nowMs are the event's seq and uptime; pass the
+// timestamp the sample got in the graph history.
+void publishWebUI(const SensorReadings &r, uint32_t nowMs);
+
+// Keep-alives and dead-client cleanup for /api/stream (call from loop)
+void handleWebUIStream();
@@ -0,0 +1,46 @@
+#include "ApiJson.h"
+#include "FixedFormat.h"
+#include <stdio.h>
+
+int apiDataJson(char *json, size_t len, const SensorReadings &r, uint32_t seq,
+                uint32_t uptimeMs, bool recording, const char *recFile)
+{
+    // Built with FixedFormat rather than snprintf: this runs once per
+    // reading for the SSE stream and every /api/data poll
+    static const char *const keys[6] = {",\"iaq\":", ",\"co2\":", ",\"temp\":", ",\"hum\":", ",\"press\":", ",\"volt\":"};
+    const float values[6] = {r.iaq, r.co2, r.temp, r.hum, r.press, r.voltage};
+
+    FmtBuf b;
+    fmtInit(b, json, len);
+    fmtStr(b, "{\"seq\":");
+    fmtUint(b, seq);
+    for (int i = 0; i < 6; i++)
+    {
+        fmtStr(b, keys[i]);
+        fmtFixed(b, values[i], 2);
+    }
+    fmtStr(b, ",\"acc\":");
+    fmtInt(b, r.accuracy);
+    fmtStr(b, ",\"uptime\":");
+    fmtUint(b, uptimeMs);
+    fmtStr(b, recording ? ",\"isRec\":true,\"recFile\":\"" : ",\"isRec\":false,\"recFile\":\"");
+    fmtStr(b, recFile);
+    fmtStr(b, "\"}");
+    return fmtEnd(b);
+}
+
+int apiHistJson(char *json, size_t len, const Histogram &h, uint32_t div)
+{
+    int n = snprintf(json, len, "[");
+    bool first = true;
+    for (int b = 0; b < h.usedBuckets() && n < (int)len - 32; b++)
+    {
+        if (!h.buckets[b])
+            continue;
+        n += snprintf(json + n, len - n, "%s[%lu,%lu]", first ? "" : ",",
+                      (unsigned long)(Histogram::bucketTop(b) / div), (unsigned long)h.buckets[b]);
+        first = false;
+    }
+    n += snprintf(json + n, len - n, "]");
+    return n;
+}
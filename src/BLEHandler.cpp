@@ -1,4 +1,10 @@
 #include "BLEHandler.h"
+#include "PowerManager.h"
+#include "FixedFormat.h"
+#include "BleTelemetry.h"
+#include "SensorTask.h"
+#include "BleFileXfer.h"
+#include "LogManifest.h"
 #include <NimBLEDevice.h>
 
 static NimBLEServer *pServer = nullptr;
@@ -7,6 +13,30 @@ static NimBLECharacteristic *pHumChar = nullptr;
 static NimBLECharacteristic *pPressChar = nullptr;
 static NimBLECharacteristic *pIAQChar = nullptr;
 static NimBLECharacteristic *pCO2Char = nullptr;
+static NimBLECharacteristic *pTelemetryChar = nullptr;
+
+// Latest reading, for the legacy characteristics' reads. Written on the
+// loop and read on the NimBLE host task, so both sides copy it under the mux.
+static SensorReadings lastReadings;
+static portMUX_TYPE lastReadingsMux = portMUX_INITIALIZER_UNLOCKED;
+// Packet counter, lets clients spot missed notifications
+static uint16_t telemetrySeq = 0;
+
+// Log download (BleFileXfer.h). Commands arrive on the NimBLE host task
+// and are queued; the transfer itself runs on the loop in serviceBLE().
+struct XferCommandMsg
+{
+    uint8_t len;
+    uint8_t data[XFER_MAX_COMMAND];
+};
+#define XFER_COMMAND_DEPTH 8
+static NimBLECharacteristic *pXferCtrlChar = nullptr;
+static NimBLECharacteristic *pXferDataChar = nullptr;
+static QueueHandle_t xferCommands = nullptr;
+static XferServer xfer;
+static volatile uint16_t peerMtu = 23;
+static volatile bool xferLinkDropped = false;
+static volatile bool xferNotifyFailed = false;
 
 #define SERVICE_UUID "181A"
 #define CHAR_TEMP_UUID "2A6E"
@@ -17,6 +47,15 @@ static NimBLECharacteristic *pCO2Char = nullptr;
 #define SERVICE_AQ_UUID "4fafc201-1fb5-459e-8fcc-c5c9c331914b"
 #define CHAR_IAQ_UUID "beb5483e-36e1-4688-b7f5-ea07361b26a8"
 #define CHAR_CO2_UUID "beb5483e-36e1-4688-b7f5-ea07361b26a9"
+// Packed telemetry, one notification per sample (layout in BleTelemetry.h)
+#define CHAR_TELEMETRY_UUID "beb5483e-36e1-4688-b7f5-ea07361b26aa"
+
+// Log download service (not advertised; found after connecting)
+#define SERVICE_XFER_UUID "4fafc201-1fb5-459e-8fcc-c5c9c331914c"
+#define CHAR_XFER_CTRL_UUID "beb5483e-36e1-4688-b7f5-ea07361b26b0"
+#define CHAR_XFER_DATA_UUID "beb5483e-36e1-4688-b7f5-ea07361b26b1"
+// Asked for in the MTU exchange; the peer may settle on less
+#define BLE_PREFERRED_MTU (XFER_MAX_PACKET + 3)
 
 bool deviceConnected = false;
 
@@ -25,14 +64,104 @@ class MyServerCallbacks : public NimBLEServerCallbacks
     void onConnect(NimBLEServer *pServer)
     {
         deviceConnected = true;
+        peerMtu = 23;
+        powerSignalLoop(); // LED and status icon
     };
     void onDisconnect(NimBLEServer *pServer)
     {
         deviceConnected = false;
+        xferLinkDropped = true;
         pServer->getAdvertising()->start();
+        powerSignalLoop();
+    }
+    void onMTUChange(uint16_t MTU, ble_gap_conn_desc *desc)
+    {
+        peerMtu = MTU;
+    }
+};
+
+class XferControlCallbacks : public NimBLECharacteristicCallbacks
+{
+    void onWrite(NimBLECharacteristic *c)
+    {
+        NimBLEAttValue value = c->getValue();
+        XferCommandMsg msg;
+        msg.len = value.length() < sizeof(msg.data) ? value.length() : sizeof(msg.data);
+        memcpy(msg.data, value.data(), msg.len);
+        xQueueSend(xferCommands, &msg, 0);
+        powerSignalLoop();
+    }
+};
+
+class XferDataCallbacks : public NimBLECharacteristicCallbacks
+{
+    // Called from inside notify() when the host stack is out of buffers
+    void onStatus(NimBLECharacteristic *c, Status s, int code)
+    {
+        if (s == ERROR_GATT)
+            xferNotifyFailed = true;
+    }
+};
+
+static XferControlCallbacks xferControlCallbacks;
+static XferDataCallbacks xferDataCallbacks;
+
+// The recordings the manifest knows about, oldest first
+static bool listRecordings(int index, char *name, size_t nameLen, uint32_t &size)
+{
+    LogManifestEntry entry;
+    if (!logManifestGet(index, entry))
+        return false;
+    logManifestFileName(entry, name, nameLen);
+    size = entry.size;
+    return true;
+}
+
+// Value of one of the per-channel characteristics from the latest reading
+static void setLegacyValue(NimBLECharacteristic *c, const SensorReadings &r)
+{
+    if (c == pTempChar)
+    {
+        // 2A6E (Temp) is int16 (0.01 degrees Celsius)
+        int16_t t = (int16_t)(r.temp * 100);
+        c->setValue((uint8_t *)&t, 2);
+    }
+    else if (c == pHumChar)
+    {
+        // 2A6F (Hum) is uint16 (0.01 %)
+        uint16_t h = (uint16_t)(r.hum * 100);
+        c->setValue((uint8_t *)&h, 2);
+    }
+    else if (c == pPressChar)
+    {
+        // 2A6D (Press) is uint32 (0.1 Pa). press is Pa.
+        uint32_t p = (uint32_t)(r.press * 10);
+        c->setValue((uint8_t *)&p, 4);
+    }
+    else
+    {
+        // Custom: ASCII "%.2f"
+        char valBuf[16];
+        int len = fmtFixedTo(valBuf, sizeof(valBuf), c == pIAQChar ? r.iaq : r.co2, 2);
+        c->setValue((uint8_t *)valBuf, len);
+    }
+}
+
+// Legacy characteristics are only kept current for subscribers; a plain
+// read fills the value in on demand
+class LegacyReadCallbacks : public NimBLECharacteristicCallbacks
+{
+    void onRead(NimBLECharacteristic *c)
+    {
+        portENTER_CRITICAL(&lastReadingsMux);
+        SensorReadings r = lastReadings;
+        portEXIT_CRITICAL(&lastReadingsMux);
+        setLegacyValue(c, r);
     }
 };
 
+static LegacyReadCallbacks legacyReadCallbacks;
+
 void setupBLE()
 {
     NimBLEDevice::init("HandheldLogger");
@@ -40,6 +169,7 @@ void setupBLE()
     // N12 is -12dBm, P3 is +3dBm. Let's try P3 for a balance or N0.
     // Using ESP_PWR_LVL_P3 (+3dBm) for decent range but less power than P9.
     NimBLEDevice::setPower(ESP_PWR_LVL_P3);
+    NimBLEDevice::setMTU(BLE_PREFERRED_MTU);
 
     pServer = NimBLEDevice::createServer();
     pServer->setCallbacks(new MyServerCallbacks());
@@ -48,13 +178,29 @@ void setupBLE()
     pTempChar = pEnvService->createCharacteristic(CHAR_TEMP_UUID, NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY);
     pHumChar = pEnvService->createCharacteristic(CHAR_HUM_UUID, NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY);
     pPressChar = pEnvService->createCharacteristic(CHAR_PRESS_UUID, NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY);
+    pTempChar->setCallbacks(&legacyReadCallbacks);
+    pHumChar->setCallbacks(&legacyReadCallbacks);
+    pPressChar->setCallbacks(&legacyReadCallbacks);
     pEnvService->start();
 
     NimBLEService *pAQService = pServer->createService(SERVICE_AQ_UUID);
     pIAQChar = pAQService->createCharacteristic(CHAR_IAQ_UUID, NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY);
     pCO2Char = pAQService->createCharacteristic(CHAR_CO2_UUID, NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY);
+    pIAQChar->setCallbacks(&legacyReadCallbacks);
+    pCO2Char->setCallbacks(&legacyReadCallbacks);
+    pTelemetryChar = pAQService->createCharacteristic(CHAR_TELEMETRY_UUID, NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY, BLE_TELEMETRY_SIZE);
     pAQService->start();
 
+    if (!xferCommands)
+        xferCommands = xQueueCreate(XFER_COMMAND_DEPTH, sizeof(XferCommandMsg));
+    xferInit(xfer, listRecordings);
+    NimBLEService *pXferService = pServer->createService(SERVICE_XFER_UUID);
+    pXferCtrlChar = pXferService->createCharacteristic(CHAR_XFER_CTRL_UUID, NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::WRITE_NR, XFER_MAX_COMMAND);
+    pXferDataChar = pXferService->createCharacteristic(CHAR_XFER_DATA_UUID, NIMBLE_PROPERTY::NOTIFY, XFER_MAX_PACKET);
+    pXferCtrlChar->setCallbacks(&xferControlCallbacks);
+    pXferDataChar->setCallbacks(&xferDataCallbacks);
+    pXferService->start();
+
     NimBLEAdvertising *pAdvertising = NimBLEDevice::getAdvertising();
     pAdvertising->addServiceUUID(SERVICE_UUID);
     pAdvertising->addServiceUUID(SERVICE_AQ_UUID);
@@ -66,46 +212,84 @@ void setupBLE()
     pAdvertising->start();
 }
 
-void updateBLEData(float temp, float hum, float press, float iaq, float co2)
+void updateBLEData(const SensorReadings &r)
 {
-    if (pServer)
+    if (!pServer)
+        return;
+    portENTER_CRITICAL(&lastReadingsMux);
+    lastReadings = r;
+    portEXIT_CRITICAL(&lastReadingsMux);
+
+    uint8_t flags = 0;
+    if (recordingSnapshot().active)
+        flags |= BLE_TELEMETRY_FLAG_RECORDING;
+    if (getSensorStatus().replaying)
+        flags |= BLE_TELEMETRY_FLAG_REPLAYING;
+
+    // The whole sample in one notification
+    uint8_t packet[BLE_TELEMETRY_SIZE];
+    size_t len = bleTelemetryEncode(packet, sizeof(packet), bleTelemetryFromReadings(r, ++telemetrySeq, millis(), flags));
+    pTelemetryChar->setValue(packet, len);
+    if (!deviceConnected)
+        return;
+    pTelemetryChar->notify();
+
+    // Older clients that subscribed to the per-channel characteristics
+    NimBLECharacteristic *legacy[5] = {pTempChar, pHumChar, pPressChar, pIAQChar, pCO2Char};
+    for (NimBLECharacteristic *c : legacy)
     {
-        // 2A6E (Temp) is int16 (0.01 degrees Celsius)
-        int16_t t = (int16_t)(temp * 100);
-        pTempChar->setValue((uint8_t *)&t, 2);
-        if (deviceConnected)
-            pTempChar->notify();
+        if (c->getSubscribedCount() == 0)
+            continue;
+        setLegacyValue(c, r);
+        c->notify();
+    }
+}
 
-        // 2A6F (Hum) is uint16 (0.01 %)
-        uint16_t h = (uint16_t)(hum * 100);
-        pHumChar->setValue((uint8_t *)&h, 2);
-        if (deviceConnected)
-            pHumChar->notify();
+void serviceBLE()
+{
+    if (!pServer)
+        return;
+    uint32_t now = millis();
+    if (xferLinkDropped)
+    {
+        xferLinkDropped = false;
+        xferDisconnected(xfer);
+    }
 
-        // 2A6D (Press) is uint32 (0.1 Pa). press is Pa.
-        uint32_t p = (uint32_t)(press * 10);
-        pPressChar->setValue((uint8_t *)&p, 4);
-        if (deviceConnected)
-            pPressChar->notify();
+    XferCommandMsg msg;
+    while (xQueueReceive(xferCommands, &msg, 0) == pdTRUE)
+        xferCommand(xfer, msg.data, msg.len, now);
+    if (!deviceConnected)
+        return;
 
-        // Custom
-        char valBuf[16];
-        int len = snprintf(valBuf, sizeof(valBuf), "%.2f", iaq);
-        pIAQChar->setValue((uint8_t *)valBuf, len);
-        if (deviceConnected)
-            pIAQChar->notify();
-
-        len = snprintf(valBuf, sizeof(valBuf), "%.2f", co2);
-        pCO2Char->setValue((uint8_t *)valBuf, len);
-        if (deviceConnected)
-            pCO2Char->notify();
+    xferSetPacketSize(xfer, peerMtu - 3);
+    uint8_t pkt[XFER_MAX_PACKET];
+    for (int i = 0; i < XFER_BURST; i++)
+    {
+        size_t n = xferNextPacket(xfer, pkt, sizeof(pkt), now);
+        if (n == 0)
+            break;
+        xferNotifyFailed = false;
+        pXferDataChar->notify(pkt, n);
+        if (xferNotifyFailed)
+        {
+            // Buffers full: try again next pass
+            xferUnsent(xfer, pkt, n);
+            break;
+        }
     }
 }
 
+bool isBLETransferActive()
+{
+    return pServer && deviceConnected && xferBusy(xfer);
+}
+
 void stopBLE()
 {
     if (pServer)
     {
+        xferDisconnected(xfer);
         NimBLEDevice::deinit(true);
         pServer = nullptr;
         deviceConnected = false;
@@ -0,0 +1,29 @@
+#include "Battery.h"
+
+#define BATTERY_LUT_SIZE 9
+
+// LUT: Voltage -> Percentage
+static const float volts[BATTERY_LUT_SIZE] = {4.20, 4.10, 4.00, 3.90, 3.80, 3.70, 3.60, 3.50, 3.00};
+static const int percents[BATTERY_LUT_SIZE] = {100, 90, 80, 70, 60, 50, 15, 5, 0};
+
+int batteryPercent(float voltage)
+{
+    if (voltage >= volts[0])
+        return 100;
+    if (voltage <= volts[BATTERY_LUT_SIZE - 1])
+        return 0;
+
+    for (int i = 0; i < BATTERY_LUT_SIZE - 1; i++)
+    {
+        if (voltage <= volts[i] && voltage > volts[i + 1])
+        {
+            // Linear interpolation
+            float range = volts[i] - volts[i + 1];
+            float delta = voltage - volts[i + 1];
+            float factor = delta / range;
+            int pRange = percents[i] - percents[i + 1];
+            return percents[i + 1] + (int)(factor * pRange);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,320 @@
+#include "BleFileXfer.h"
+#include "Hal.h"
+#include <string.h>
+
+static void put16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+}
+
+static uint16_t get16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void xferInit(XferServer &s, XferListFn list)
+{
+    s.list = list;
+    s.state = XFER_IDLE;
+    s.replyLen = 0;
+    s.listing = false;
+    s.packetSize = XFER_MIN_PACKET;
+}
+
+void xferSetPacketSize(XferServer &s, size_t payload)
+{
+    if (payload < XFER_MIN_PACKET)
+        payload = XFER_MIN_PACKET;
+    if (payload > XFER_MAX_PACKET)
+        payload = XFER_MAX_PACKET;
+    s.packetSize = payload;
+}
+
+// Only files on the device's list can be opened
+static bool findListed(XferServer &s, const char *path, uint32_t &size)
+{
+    char name[32];
+    for (int i = 0; s.list && s.list(i, name, sizeof(name), size); i++)
+    {
+        if (strcmp(name, path) == 0)
+            return true;
+    }
+    return false;
+}
+
+static void startList(XferServer &s, int first)
+{
+    char name[32];
+    uint32_t size;
+    int total = 0;
+    while (s.list && s.list(total, name, sizeof(name), size))
+        total++;
+    s.listing = true;
+    s.listNext = first < 0 ? 0 : first;
+    s.listTotal = total;
+}
+
+static void openFile(XferServer &s, const char *path, size_t len)
+{
+    char name[32];
+    if (len >= sizeof(name))
+        len = sizeof(name) - 1;
+    memcpy(name, path, len);
+    name[len] = '\0';
+
+    uint32_t listedSize;
+    long size = findListed(s, name, listedSize) ? halFileSize(name) : -1;
+
+    s.reply[0] = XFER_PKT_OPENED;
+    if (size < 0)
+    {
+        s.state = XFER_IDLE;
+        s.reply[1] = XFER_OPEN_NOT_FOUND;
+        put32(s.reply + 2, 0);
+    }
+    else
+    {
+        // The active recording keeps growing; this transfer covers what is
+        // on flash now
+        memcpy(s.path, name, len + 1);
+        s.size = (uint32_t)size;
+        s.state = XFER_OPEN;
+        s.cacheLen = 0;
+        s.reply[1] = XFER_OPEN_OK;
+        put32(s.reply + 2, s.size);
+    }
+    s.replyLen = 6;
+}
+
+static void startSending(XferServer &s, uint32_t offset, uint32_t nowMs)
+{
+    if (s.state == XFER_IDLE)
+        return;
+    if (offset > s.size)
+        offset = s.size;
+    if (s.state == XFER_OPEN || s.state == XFER_DONE)
+    {
+        s.startMs = nowMs;
+        s.bytesSent = 0;
+        s.rewinds = 0;
+    }
+    else
+    {
+        s.rewinds++;
+    }
+    s.state = XFER_SENDING;
+    s.sendOffset = offset;
+    s.ackOffset = offset;
+    s.endSent = false;
+    s.lastProgressMs = nowMs;
+    s.stalls = 0;
+}
+
+void xferCommand(XferServer &s, const uint8_t *cmd, size_t len, uint32_t nowMs)
+{
+    if (len == 0)
+        return;
+    switch (cmd[0])
+    {
+    case XFER_CMD_LIST:
+        startList(s, len >= 3 ? get16(cmd + 1) : 0);
+        break;
+    case XFER_CMD_OPEN:
+        openFile(s, (const char *)cmd + 1, len - 1);
+        break;
+    case XFER_CMD_READ:
+        if (len >= 5)
+            startSending(s, get32(cmd + 1), nowMs);
+        break;
+    case XFER_CMD_ACK:
+        if (len >= 5 && s.state == XFER_SENDING)
+        {
+            uint32_t ack = get32(cmd + 1);
+            if (ack > s.ackOffset && ack <= s.sendOffset)
+            {
+                s.ackOffset = ack;
+                s.lastProgressMs = nowMs;
+                s.stalls = 0;
+            }
+            // The client has it all, whether or not 'Z' went out yet
+            if (s.ackOffset == s.size)
+            {
+                s.state = XFER_DONE;
+                s.elapsedMs = nowMs - s.startMs;
+            }
+        }
+        break;
+    case XFER_CMD_CLOSE:
+        s.state = XFER_IDLE;
+        s.listing = false;
+        break;
+    }
+}
+
+// Payload bytes at s.sendOffset, read from flash a chunk at a time. A
+// packet that would straddle the end of the chunk reloads it, so every
+// packet but the last is full.
+static size_t readData(XferServer &s, uint8_t *out, size_t len)
+{
+    if (s.sendOffset < s.cacheOffset || s.sendOffset + len > s.cacheOffset + s.cacheLen)
+    {
+        s.cacheOffset = s.sendOffset;
+        s.cacheLen = halFileRead(s.path, s.cacheOffset, s.cache, sizeof(s.cache));
+        if (s.cacheLen == 0)
+            return 0;
+    }
+    size_t avail = s.cacheOffset + s.cacheLen - s.sendOffset;
+    if (len > avail)
+        len = avail;
+    memcpy(out, s.cache + (s.sendOffset - s.cacheOffset), len);
+    return len;
+}
+
+size_t xferNextPacket(XferServer &s, uint8_t *out, size_t outSize, uint32_t nowMs)
+{
+    if (outSize > s.packetSize)
+        outSize = s.packetSize;
+
+    if (s.replyLen)
+    {
+        size_t n = s.replyLen;
+        memcpy(out, s.reply, n);
+        s.replyLen = 0;
+        return n;
+    }
+
+    if (s.listing)
+    {
+        char name[32];
+        uint32_t size;
+        if (s.listNext < s.listTotal && s.list(s.listNext, name, sizeof(name), size))
+        {
+            size_t nameLen = strlen(name);
+            if (nameLen > outSize - 9)
+                nameLen = outSize - 9;
+            out[0] = XFER_PKT_ENTRY;
+            put16(out + 1, (uint16_t)s.listNext);
+            put16(out + 3, (uint16_t)s.listTotal);
+            put32(out + 5, size);
+            memcpy(out + 9, name, nameLen);
+            s.listNext++;
+            return 9 + nameLen;
+        }
+        s.listing = false;
+        out[0] = XFER_PKT_LIST_END;
+        put16(out + 1, (uint16_t)s.listTotal);
+        return 3;
+    }
+
+    if (s.state != XFER_SENDING)
+        return 0;
+
+    // No ack for a while: the tail of the window (or the ack) was lost
+    if (nowMs - s.lastProgressMs > XFER_ACK_TIMEOUT_MS)
+    {
+        if (++s.stalls > XFER_MAX_STALLS)
+        {
+            // Client gone quiet: stop sending, it can still 'R' to resume
+            s.state = XFER_OPEN;
+            return 0;
+        }
+        s.sendOffset = s.ackOffset;
+        s.endSent = false;
+        s.lastProgressMs = nowMs;
+        s.rewinds++;
+    }
+
+    if (s.sendOffset < s.size)
+    {
+        if (s.sendOffset - s.ackOffset >= XFER_WINDOW)
+            return 0;
+        size_t want = outSize - XFER_DATA_HEADER;
+        if (want > s.size - s.sendOffset)
+            want = s.size - s.sendOffset;
+        size_t n = readData(s, out + XFER_DATA_HEADER, want);
+        if (n == 0)
+        {
+            // File shrank (deleted, recovered): end the transfer here
+            s.size = s.sendOffset;
+            return 0;
+        }
+        out[0] = XFER_PKT_DATA;
+        put32(out + 1, s.sendOffset);
+        s.sendOffset += n;
+        s.bytesSent += n;
+        return XFER_DATA_HEADER + n;
+    }
+
+    if (!s.endSent)
+    {
+        s.endSent = true;
+        out[0] = XFER_PKT_END;
+        put32(out + 1, s.size);
+        put32(out + 5, nowMs - s.startMs);
+        return 9;
+    }
+    return 0;
+}
+
+void xferUnsent(XferServer &s, const uint8_t *pkt, size_t len)
+{
+    if (len == 0)
+        return;
+    switch (pkt[0])
+    {
+    case XFER_PKT_DATA:
+        if (s.state == XFER_SENDING && len > XFER_DATA_HEADER)
+        {
+            uint32_t offset = get32(pkt + 1);
+            if (offset >= s.ackOffset && offset < s.sendOffset)
+            {
+                s.bytesSent -= s.sendOffset - offset;
+                s.sendOffset = offset;
+            }
+        }
+        break;
+    case XFER_PKT_END:
+        s.endSent = false;
+        break;
+    case XFER_PKT_ENTRY:
+        s.listing = true;
+        s.listNext = get16(pkt + 1);
+        break;
+    case XFER_PKT_LIST_END:
+        s.listing = true;
+        break;
+    default:
+        if (len <= sizeof(s.reply))
+        {
+            memcpy(s.reply, pkt, len);
+            s.replyLen = len;
+        }
+        break;
+    }
+}
+
+bool xferBusy(const XferServer &s)
+{
+    return s.replyLen || s.listing || s.state == XFER_SENDING;
+}
+
+void xferDisconnected(XferServer &s)
+{
+    s.replyLen = 0;
+    s.listing = false;
+    s.state = XFER_IDLE;
+}
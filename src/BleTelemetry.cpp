@@ -0,0 +1,100 @@
+#include "BleTelemetry.h"
+#include <math.h>
+
+static void put16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void put24(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    put24(p, v);
+    p[3] = v >> 24;
+}
+
+static uint16_t get16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get24(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    return get24(p) | ((uint32_t)p[3] << 24);
+}
+
+// Scale and round, clamped to the field range (NaN reads as lo)
+static int32_t toFixed(float v, float scale, int32_t lo, int32_t hi)
+{
+    float s = v * scale;
+    if (!(s > lo))
+        return lo;
+    if (s >= hi)
+        return hi;
+    return (int32_t)lroundf(s);
+}
+
+BleTelemetry bleTelemetryFromReadings(const SensorReadings &r, uint32_t seq, uint32_t timestampMs, uint8_t flags)
+{
+    BleTelemetry t;
+    t.seq = (uint16_t)seq;
+    t.timestampMs = timestampMs;
+    t.temp = r.temp;
+    t.hum = r.hum;
+    t.press = r.press;
+    t.iaq = r.iaq;
+    t.co2 = r.co2;
+    t.accuracy = r.accuracy;
+    t.batteryPercent = r.batteryPercent < 0 ? 0 : (r.batteryPercent > 100 ? 100 : r.batteryPercent);
+    t.flags = flags;
+    return t;
+}
+
+size_t bleTelemetryEncode(uint8_t *out, size_t outSize, const BleTelemetry &t)
+{
+    if (outSize < BLE_TELEMETRY_SIZE)
+        return 0;
+
+    out[0] = (uint8_t)((BLE_TELEMETRY_VERSION << 4) |
+                       (t.flags & (BLE_TELEMETRY_FLAG_RECORDING | BLE_TELEMETRY_FLAG_REPLAYING)) |
+                       (t.accuracy > 3 ? 3 : t.accuracy));
+    put16(out + 1, t.seq);
+    put32(out + 3, t.timestampMs);
+    put16(out + 7, (uint16_t)(int16_t)toFixed(t.temp, 100.0f, -32768, 32767));
+    put16(out + 9, (uint16_t)toFixed(t.hum, 100.0f, 0, 65535));
+    put24(out + 11, (uint32_t)toFixed(t.press, 10.0f, 0, 0xFFFFFF));
+    put16(out + 14, (uint16_t)toFixed(t.iaq, 100.0f, 0, 65535));
+    put24(out + 16, (uint32_t)toFixed(t.co2, 100.0f, 0, 0xFFFFFF));
+    out[19] = t.batteryPercent;
+    return BLE_TELEMETRY_SIZE;
+}
+
+bool bleTelemetryDecode(const uint8_t *in, size_t len, BleTelemetry &out)
+{
+    if (len < BLE_TELEMETRY_SIZE || (in[0] >> 4) != BLE_TELEMETRY_VERSION)
+        return false;
+
+    out.accuracy = in[0] & 0x03;
+    out.flags = in[0] & (BLE_TELEMETRY_FLAG_RECORDING | BLE_TELEMETRY_FLAG_REPLAYING);
+    out.seq = get16(in + 1);
+    out.timestampMs = get32(in + 3);
+    out.temp = (int16_t)get16(in + 7) / 100.0f;
+    out.hum = get16(in + 9) / 100.0f;
+    out.press = get24(in + 11) / 10.0f;
+    out.iaq = get16(in + 14) / 100.0f;
+    out.co2 = get24(in + 16) / 100.0f;
+    out.batteryPercent = in[19];
+    return true;
+}
@@ -0,0 +1,177 @@
+#include "DisplayDiff.h"
+#include "I2CBus.h"
+#include "Hal.h"
+#include "Profiler.h"
+#include "LatencyMonitor.h"
+#include <string.h>
+
+#define SCREEN_WIDTH_PX 128
+#define SCREEN_HEIGHT_PX 64
+#define DISPLAY_PAGES (SCREEN_HEIGHT_PX / 8)
+
+// ESP32 Wire buffer is 128 bytes; one goes to the 0x40 control byte
+#define DISPLAY_I2C_CHUNK 127
+
+// SSD1306 commands (as in Adafruit_SSD1306.h)
+#define SSD1306_CMD_DISPLAYOFF 0xAE
+#define SSD1306_CMD_DISPLAYON 0xAF
+#define SSD1306_CMD_COLUMNADDR 0x21
+#define SSD1306_CMD_PAGEADDR 0x22
+
+static uint8_t *panel = nullptr; // The driver's framebuffer
+static uint8_t panelAddress = 0x3C;
+
+static uint8_t shadow[SCREEN_WIDTH_PX * DISPLAY_PAGES];
+static bool shadowValid = false;
+static bool pending = false; // Last push was cut short for the sensor
+static DisplayStats stats;
+
+void initDisplayDiff(uint8_t *frameBuffer, uint8_t address)
+{
+    panel = frameBuffer;
+    panelAddress = address;
+    shadowValid = false;
+}
+
+uint8_t *displayFrameBuffer()
+{
+    return panel;
+}
+
+void displayInvalidate()
+{
+    shadowValid = false;
+}
+
+void displayPower(bool on)
+{
+    if (!panel)
+        return;
+    uint8_t cmd[2] = {0x00, (uint8_t)(on ? SSD1306_CMD_DISPLAYON : SSD1306_CMD_DISPLAYOFF)};
+    i2cBusLock();
+    halI2cWrite(panelAddress, cmd, sizeof(cmd));
+    i2cBusUnlock();
+}
+
+// Point the panel's write window at one page / column range
+static uint32_t setWindow(int page, int c0, int c1)
+{
+    uint8_t cmd[7] = {
+        0x00, // Command stream
+        SSD1306_CMD_PAGEADDR, (uint8_t)page, (uint8_t)page,
+        SSD1306_CMD_COLUMNADDR, (uint8_t)c0, (uint8_t)c1,
+    };
+    i2cBusLock();
+    halI2cWrite(panelAddress, cmd, sizeof(cmd));
+    i2cBusUnlock();
+    return 1 + sizeof(cmd); // Address byte + payload
+}
+
+static uint32_t sendChunk(const uint8_t *data, int len)
+{
+    uint8_t buf[1 + DISPLAY_I2C_CHUNK];
+    buf[0] = 0x40; // Data stream
+    memcpy(buf + 1, data, len);
+    i2cBusLock();
+    halI2cWrite(panelAddress, buf, 1 + len);
+    i2cBusUnlock();
+    return 2 + len;
+}
+
+void displayPush()
+{
+    if (!panel)
+        return;
+    PROFILE_SCOPE(PROF_DISPLAY);
+
+    uint32_t startUs = halMicros();
+    const uint8_t *frame = panel;
+    uint32_t bytes = 0;
+    uint32_t pages = 0;
+    bool deferred = false;
+
+    for (int page = 0; page < DISPLAY_PAGES && !deferred; page++)
+    {
+        const uint8_t *cur = frame + page * SCREEN_WIDTH_PX;
+        uint8_t *prev = shadow + page * SCREEN_WIDTH_PX;
+
+        int c0 = 0;
+        int c1 = SCREEN_WIDTH_PX - 1;
+        if (shadowValid)
+        {
+            while (c0 < SCREEN_WIDTH_PX && cur[c0] == prev[c0])
+                c0++;
+            if (c0 == SCREEN_WIDTH_PX)
+                continue; // Page unchanged
+            while (cur[c1] == prev[c1])
+                c1--;
+        }
+
+        // The window command and the first chunk go out together
+        int len = c1 - c0 + 1;
+        int n = len > DISPLAY_I2C_CHUNK ? DISPLAY_I2C_CHUNK : len;
+        if (!i2cBusDisplaySlot(8 + 2 + n))
+        {
+            deferred = true;
+            break;
+        }
+
+        bytes += setWindow(page, c0, c1);
+        pages++;
+
+        // Shadow is updated per chunk, so a deferred page resumes where it stopped
+        int col = c0;
+        while (col <= c1)
+        {
+            n = c1 - col + 1;
+            if (n > DISPLAY_I2C_CHUNK)
+                n = DISPLAY_I2C_CHUNK;
+            if (col != c0 && !i2cBusDisplaySlot(2 + n))
+            {
+                deferred = true;
+                break;
+            }
+            bytes += sendChunk(cur + col, n);
+            memcpy(prev + col, cur + col, n);
+            i2cBusCountDisplayChunk(false);
+            col += n;
+        }
+    }
+
+    if (deferred)
+    {
+        i2cBusCountDisplayChunk(true);
+        stats.framesDeferred++;
+    }
+    else
+    {
+        // Only a complete pass makes the whole shadow trustworthy
+        shadowValid = true;
+    }
+    pending = deferred;
+
+    uint32_t endUs = halMicros();
+    if (!deferred)
+        latencyFrameShown(endUs);
+
+    uint32_t frameUs = endUs - startUs;
+    stats.frames++;
+    if (pages == 0 && !deferred)
+        stats.framesSkipped++;
+    stats.pagesSent += pages;
+    stats.bytesOnBus += bytes;
+    stats.lastFrameBytes = bytes;
+    stats.lastFrameUs = frameUs;
+    if (frameUs > stats.maxFrameUs)
+        stats.maxFrameUs = frameUs;
+}
+
+bool displayPending()
+{
+    return pending;
+}
+
+DisplayStats getDisplayStats()
+{
+    return stats;
+}
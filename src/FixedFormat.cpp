@@ -0,0 +1,185 @@
+#include "FixedFormat.h"
+#include <string.h>
+
+static const uint32_t pow10[FMT_MAX_DECIMALS + 1] = {1, 10, 100, 1000};
+
+void fmtInit(FmtBuf &b, char *out, size_t size)
+{
+    b.out = out;
+    b.size = size;
+    b.len = 0;
+    if (size)
+        out[0] = '\0';
+}
+
+int fmtEnd(FmtBuf &b)
+{
+    if (b.size)
+        b.out[b.len < b.size ? b.len : b.size - 1] = '\0';
+    return (int)b.len;
+}
+
+void fmtChar(FmtBuf &b, char c)
+{
+    if (b.len + 1 < b.size)
+        b.out[b.len] = c;
+    b.len++;
+}
+
+void fmtStr(FmtBuf &b, const char *s)
+{
+    while (*s)
+        fmtChar(b, *s++);
+}
+
+// Digits of v, most significant first, zero-padded to at least minDigits
+static void putDigits(FmtBuf &b, uint64_t v, int minDigits)
+{
+    char tmp[24];
+    int n = 0;
+    // 32-bit divisions where possible; 64-bit ones are a libgcc call on the ESP32
+    while (v > 0xFFFFFFFFULL)
+    {
+        tmp[n++] = '0' + (char)(v % 10);
+        v /= 10;
+    }
+    uint32_t w = (uint32_t)v;
+    while (w || n < minDigits || n == 0)
+    {
+        tmp[n++] = '0' + (char)(w % 10);
+        w /= 10;
+    }
+    while (n)
+        fmtChar(b, tmp[--n]);
+}
+
+void fmtUint(FmtBuf &b, unsigned long v)
+{
+    putDigits(b, v, 1);
+}
+
+void fmtInt(FmtBuf &b, long v)
+{
+    if (v < 0)
+    {
+        fmtChar(b, '-');
+        putDigits(b, 0 - (unsigned long)v, 1);
+    }
+    else
+    {
+        putDigits(b, (unsigned long)v, 1);
+    }
+}
+
+// n / 10^decimals, '.', then the remainder zero-padded
+static void putScaled(FmtBuf &b, uint64_t n, int decimals)
+{
+    putDigits(b, n / pow10[decimals], 1);
+    if (decimals)
+    {
+        fmtChar(b, '.');
+        putDigits(b, n % pow10[decimals], decimals);
+    }
+}
+
+// m * 2^e for shifts too large for 64 bits (|v| >= 2^53). Such floats are
+// whole numbers, so print the exact integer from 32-bit limbs.
+static void putBigInt(FmtBuf &b, uint32_t m, int e)
+{
+    uint32_t limbs[5] = {0, 0, 0, 0, 0};
+    int word = e / 32;
+    int bit = e % 32;
+    limbs[word] = m << bit;
+    if (bit)
+        limbs[word + 1] = m >> (32 - bit);
+
+    char tmp[48];
+    int n = 0;
+    int top = 4;
+    while (top >= 0)
+    {
+        // Divide the whole number by 10, most significant limb first
+        uint64_t rem = 0;
+        for (int i = top; i >= 0; i--)
+        {
+            uint64_t cur = (rem << 32) | limbs[i];
+            limbs[i] = (uint32_t)(cur / 10);
+            rem = cur % 10;
+        }
+        tmp[n++] = '0' + (char)rem;
+        while (top >= 0 && limbs[top] == 0)
+            top--;
+    }
+    while (n)
+        fmtChar(b, tmp[--n]);
+}
+
+void fmtFixed(FmtBuf &b, float v, int decimals)
+{
+    if (decimals < 0)
+        decimals = 0;
+    if (decimals > FMT_MAX_DECIMALS)
+        decimals = FMT_MAX_DECIMALS;
+
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    bool neg = bits >> 31;
+    int biased = (bits >> 23) & 0xFF;
+    uint32_t frac = bits & 0x7FFFFF;
+
+    if (biased == 0xFF)
+    {
+        if (neg)
+            fmtChar(b, '-');
+        fmtStr(b, frac ? "nan" : "inf");
+        return;
+    }
+
+    // |v| = m * 2^e exactly
+    uint32_t m = biased ? (frac | 0x800000) : frac;
+    int e = biased ? biased - 150 : -149;
+
+    if (neg)
+        fmtChar(b, '-');
+
+    // |v| * 10^decimals needs at most 24 + 10 bits before the shift
+    uint64_t scaled = (uint64_t)m * pow10[decimals];
+
+    if (e >= 0)
+    {
+        if (e <= 29)
+        {
+            putScaled(b, scaled << e, decimals);
+            return;
+        }
+        putBigInt(b, m, e);
+        if (decimals)
+        {
+            fmtChar(b, '.');
+            putDigits(b, 0, decimals);
+        }
+        return;
+    }
+
+    // Fractional bits: round to nearest, ties to even, as printf does
+    uint64_t q = 0;
+    if (-e < 64)
+    {
+        int s = -e;
+        q = scaled >> s;
+        uint64_t r = scaled & ((1ULL << s) - 1);
+        uint64_t half = 1ULL << (s - 1);
+        if (r > half || (r == half && (q & 1)))
+            q++;
+    }
+    // else: scaled < 2^34, far below half of 2^64, rounds to zero
+    putScaled(b, q, decimals);
+}
+
+int fmtFixedTo(char *out, size_t size, float v, int decimals)
+{
+    FmtBuf b;
+    fmtInit(b, out, size);
+    fmtFixed(b, v, decimals);
+    return fmtEnd(b);
+}
@@ -0,0 +1,327 @@
+#include "GraphHistory.h"
+#include <stddef.h>
+
+float graphBuffers[GRAPH_COUNT][GRAPH_WIDTH];
+unsigned long graphTimes[GRAPH_WIDTH];
+int graphHead = 0;
+bool graphFilled = false;
+const char *graphLabels[GRAPH_COUNT] = {"IAQ", "CO2", "TEMP", "HUM", "PRESS"};
+const char *graphUnits[GRAPH_COUNT] = {"", "ppm", "C", "%", "Pa"};
+
+struct GraphBucket
+{
+    float minV[GRAPH_COUNT];
+    float maxV[GRAPH_COUNT];
+    float meanV[GRAPH_COUNT];
+    uint32_t start;
+};
+
+// Monotonic deque of ring positions over a sliding window. Values along it
+// only increase (min queue) or decrease (max queue), so the front is always
+// the window extreme and every position is pushed and popped once.
+struct RangeDeque
+{
+    uint8_t pos[GRAPH_WIDTH];
+    uint8_t first;
+    uint8_t count;
+};
+
+struct GraphTier
+{
+    GraphBucket buckets[GRAPH_WIDTH];
+    int head;
+    bool filled;
+
+    // Bucket being accumulated
+    GraphBucket open;
+    float sum[GRAPH_COUNT];
+    uint16_t openCount;
+
+    // Extremes of the closed buckets on screen (all but a skipped oldest one)
+    RangeDeque minQ[GRAPH_COUNT];
+    RangeDeque maxQ[GRAPH_COUNT];
+};
+
+// Bucket lengths live apart from the (zero-initialised) tier state
+static const uint32_t tierBucketMs[GRAPH_TIER_COUNT] = {60000UL, 900000UL, 3600000UL};
+static GraphTier tiers[GRAPH_TIER_COUNT];
+static const char *spanLabels[GRAPH_SPAN_COUNT] = {"RAW", "1m", "15m", "1h"};
+
+static RangeDeque rawMinQ[GRAPH_COUNT];
+static RangeDeque rawMaxQ[GRAPH_COUNT];
+static uint32_t historyVersion = 0;
+
+// Values live in arrays of floats or of buckets; stride is in bytes
+static inline float valueAt(const float *base, size_t stride, int pos)
+{
+    return *(const float *)((const uint8_t *)base + pos * stride);
+}
+
+// Drop pos if it is the oldest entry (it is leaving the window)
+static void dequeEvict(RangeDeque &q, int pos)
+{
+    if (q.count > 0 && q.pos[q.first] == pos)
+    {
+        q.first = (q.first + 1) % GRAPH_WIDTH;
+        q.count--;
+    }
+}
+
+static void dequePush(RangeDeque &q, int pos, const float *base, size_t stride, bool isMax)
+{
+    float v = valueAt(base, stride, pos);
+    while (q.count > 0)
+    {
+        float back = valueAt(base, stride, q.pos[(q.first + q.count - 1) % GRAPH_WIDTH]);
+        if (isMax ? back > v : back < v)
+            break;
+        q.count--;
+    }
+    q.pos[(q.first + q.count) % GRAPH_WIDTH] = (uint8_t)pos;
+    q.count++;
+}
+
+static inline float dequeFront(const RangeDeque &q, const float *base, size_t stride)
+{
+    return valueAt(base, stride, q.pos[q.first]);
+}
+
+static void tierAdd(GraphTier &tier, uint32_t bucketMs, uint32_t timestamp, const float values[GRAPH_COUNT])
+{
+    uint32_t start = timestamp - (timestamp % bucketMs);
+
+    // Close the open bucket once a sample lands in the next one
+    if (tier.openCount > 0 && start != tier.open.start)
+    {
+        for (int g = 0; g < GRAPH_COUNT; g++)
+            tier.open.meanV[g] = tier.sum[g] / tier.openCount;
+
+        // The slot being overwritten leaves the window. Once the ring is
+        // full the next-oldest is hidden behind the open bucket too.
+        int pos = tier.head;
+        bool full = tier.filled || pos == GRAPH_WIDTH - 1;
+        for (int g = 0; g < GRAPH_COUNT; g++)
+        {
+            dequeEvict(tier.minQ[g], pos);
+            dequeEvict(tier.maxQ[g], pos);
+            if (full)
+            {
+                dequeEvict(tier.minQ[g], (pos + 1) % GRAPH_WIDTH);
+                dequeEvict(tier.maxQ[g], (pos + 1) % GRAPH_WIDTH);
+            }
+        }
+
+        tier.buckets[pos] = tier.open;
+        for (int g = 0; g < GRAPH_COUNT; g++)
+        {
+            dequePush(tier.minQ[g], pos, &tier.buckets[0].minV[g], sizeof(GraphBucket), false);
+            dequePush(tier.maxQ[g], pos, &tier.buckets[0].maxV[g], sizeof(GraphBucket), true);
+        }
+        tier.head++;
+        if (tier.head >= GRAPH_WIDTH)
+        {
+            tier.head = 0;
+            tier.filled = true;
+        }
+        tier.openCount = 0;
+    }
+
+    if (tier.openCount == 0)
+    {
+        tier.open.start = start;
+        for (int g = 0; g < GRAPH_COUNT; g++)
+        {
+            tier.open.minV[g] = values[g];
+            tier.open.maxV[g] = values[g];
+            tier.sum[g] = 0;
+        }
+    }
+
+    for (int g = 0; g < GRAPH_COUNT; g++)
+    {
+        if (values[g] < tier.open.minV[g])
+            tier.open.minV[g] = values[g];
+        if (values[g] > tier.open.maxV[g])
+            tier.open.maxV[g] = values[g];
+        tier.sum[g] += values[g];
+    }
+    tier.openCount++;
+}
+
+void graphHistoryAdd(unsigned long timestamp, const float values[GRAPH_COUNT])
+{
+    for (int g = 0; g < GRAPH_COUNT; g++)
+    {
+        dequeEvict(rawMinQ[g], graphHead);
+        dequeEvict(rawMaxQ[g], graphHead);
+        graphBuffers[g][graphHead] = values[g];
+        dequePush(rawMinQ[g], graphHead, graphBuffers[g], sizeof(float), false);
+        dequePush(rawMaxQ[g], graphHead, graphBuffers[g], sizeof(float), true);
+    }
+    graphTimes[graphHead] = timestamp;
+
+    graphHead++;
+    if (graphHead >= GRAPH_WIDTH)
+    {
+        graphHead = 0;
+        graphFilled = true;
+    }
+
+    for (int t = 0; t < GRAPH_TIER_COUNT; t++)
+        tierAdd(tiers[t], tierBucketMs[t], timestamp, values);
+
+    historyVersion++;
+}
+
+uint32_t graphHistoryVersion()
+{
+    return historyVersion;
+}
+
+int graphHistoryCount()
+{
+    return graphFilled ? GRAPH_WIDTH : graphHead;
+}
+
+int graphHistoryIndex(int i)
+{
+    // Once the ring has wrapped, the oldest sample sits at graphHead
+    int idx = graphFilled ? graphHead + i : i;
+    if (idx >= GRAPH_WIDTH)
+        idx -= GRAPH_WIDTH;
+    return idx;
+}
+
+const char *graphSpanLabel(int span)
+{
+    return spanLabels[span];
+}
+
+int graphSpanPoints(int span)
+{
+    if (span == 0)
+        return graphHistoryCount();
+
+    const GraphTier &tier = tiers[span - 1];
+    int closed = tier.filled ? GRAPH_WIDTH : tier.head;
+    // The open bucket replaces the oldest one once the ring is full
+    int points = closed + (tier.openCount > 0 ? 1 : 0);
+    return points > GRAPH_WIDTH ? GRAPH_WIDTH : points;
+}
+
+GraphPoint graphSpanPoint(int span, int channel, int i)
+{
+    GraphPoint p;
+
+    if (span == 0)
+    {
+        float v = graphBuffers[channel][graphHistoryIndex(i)];
+        p.minV = v;
+        p.maxV = v;
+        p.meanV = v;
+        return p;
+    }
+
+    const GraphTier &tier = tiers[span - 1];
+    int points = graphSpanPoints(span);
+
+    if (tier.openCount > 0 && i == points - 1)
+    {
+        p.minV = tier.open.minV[channel];
+        p.maxV = tier.open.maxV[channel];
+        p.meanV = tier.sum[channel] / tier.openCount;
+        return p;
+    }
+
+    // Skip the oldest closed bucket when the open one takes its place
+    int closed = tier.filled ? GRAPH_WIDTH : tier.head;
+    int skip = (tier.openCount > 0 && closed == GRAPH_WIDTH) ? 1 : 0;
+    int idx = (tier.filled ? tier.head : 0) + i + skip;
+    if (idx >= GRAPH_WIDTH)
+        idx -= GRAPH_WIDTH;
+
+    const GraphBucket &b = tier.buckets[idx];
+    p.minV = b.minV[channel];
+    p.maxV = b.maxV[channel];
+    p.meanV = b.meanV[channel];
+    return p;
+}
+
+bool graphSpanRange(int span, int channel, float &minV, float &maxV)
+{
+    if (span == 0)
+    {
+        if (rawMinQ[channel].count == 0)
+            return false;
+        minV = dequeFront(rawMinQ[channel], graphBuffers[channel], sizeof(float));
+        maxV = dequeFront(rawMaxQ[channel], graphBuffers[channel], sizeof(float));
+        return true;
+    }
+
+    const GraphTier &tier = tiers[span - 1];
+    const RangeDeque &minQ = tier.minQ[channel];
+    const RangeDeque &maxQ = tier.maxQ[channel];
+    bool any = false;
+
+    if (minQ.count > 0)
+    {
+        minV = dequeFront(minQ, &tier.buckets[0].minV[channel], sizeof(GraphBucket));
+        maxV = dequeFront(maxQ, &tier.buckets[0].maxV[channel], sizeof(GraphBucket));
+        any = true;
+    }
+
+    // The open bucket only ever widens, so it is folded in at query time
+    if (tier.openCount > 0)
+    {
+        if (!any || tier.open.minV[channel] < minV)
+            minV = tier.open.minV[channel];
+        if (!any || tier.open.maxV[channel] > maxV)
+            maxV = tier.open.maxV[channel];
+        any = true;
+    }
+    return any;
+}
+
+// Row for a value; pxPerUnit is precomputed so there is no division per point
+static inline uint8_t plotRow(float v, float minV, float pxPerUnit, int top, int bottom)
+{
+    int y = (int)(bottom - (v - minV) * pxPerUnit);
+    if (y < top)
+        y = top;
+    if (y > bottom)
+        y = bottom;
+    return (uint8_t)y;
+}
+
+bool graphSpanColumns(int span, int channel, int top, int bottom, GraphColumns &cols)
+{
+    if (cols.version == historyVersion && cols.span == span && cols.channel == channel)
+        return false;
+
+    cols.version = historyVersion;
+    cols.span = span;
+    cols.channel = channel;
+    cols.count = graphSpanPoints(span);
+
+    if (cols.count == 0 || !graphSpanRange(span, channel, cols.minV, cols.maxV))
+    {
+        cols.count = 0;
+        return true;
+    }
+
+    if (cols.maxV - cols.minV < 2)
+    {
+        cols.maxV += 1;
+        cols.minV -= 1;
+    }
+
+    float pxPerUnit = (bottom - top) / (cols.maxV - cols.minV);
+    for (int i = 0; i < cols.count; i++)
+    {
+        GraphPoint p = graphSpanPoint(span, channel, i);
+        cols.yMean[i] = plotRow(p.meanV, cols.minV, pxPerUnit, top, bottom);
+        cols.yTop[i] = plotRow(p.maxV, cols.minV, pxPerUnit, top, bottom);
+        cols.yBottom[i] = plotRow(p.minV, cols.minV, pxPerUnit, top, bottom);
+    }
+    return true;
+}
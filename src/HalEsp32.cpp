@@ -0,0 +1,208 @@
+#include "Hal.h"
+#include "Board.h"
+#include "SensorTask.h"
+#include "DisplayDiff.h"
+#include "BLEHandler.h"
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <WiFi.h>
+#include <Wire.h>
+#include <unistd.h>
+
+#define BATTERY_ADC_SAMPLES 8
+#define LITTLEFS_MOUNT "/littlefs"
+
+static portMUX_TYPE halMux = portMUX_INITIALIZER_UNLOCKED;
+static SemaphoreHandle_t i2cMutex = nullptr;
+
+struct HalFile
+{
+    File file;
+};
+
+uint32_t halMillis()
+{
+    return millis();
+}
+
+uint32_t halMicros()
+{
+    return micros();
+}
+
+void halDelay(uint32_t ms)
+{
+    delay(ms);
+}
+
+void halLock()
+{
+    portENTER_CRITICAL(&halMux);
+}
+
+void halUnlock()
+{
+    portEXIT_CRITICAL(&halMux);
+}
+
+size_t halFileWrite(const char *path, const uint8_t *data, size_t len, bool append)
+{
+    File f = LittleFS.open(path, append ? "a" : "w");
+    if (!f)
+        return 0;
+    size_t n = f.write(data, len);
+    f.close();
+    return n;
+}
+
+size_t halFileRead(const char *path, uint32_t offset, uint8_t *buf, size_t len)
+{
+    File f = LittleFS.open(path, "r");
+    if (!f)
+        return 0;
+    size_t n = 0;
+    if (f.seek(offset))
+        n = f.read(buf, len);
+    f.close();
+    return n;
+}
+
+long halFileSize(const char *path)
+{
+    if (!LittleFS.exists(path))
+        return -1;
+    File f = LittleFS.open(path, "r");
+    if (!f)
+        return -1;
+    long size = f.size();
+    f.close();
+    return size;
+}
+
+bool halFileRemove(const char *path)
+{
+    return LittleFS.remove(path);
+}
+
+// LittleFS' File has no truncate; go through the VFS mount
+bool halFileTruncate(const char *path, size_t size)
+{
+    char full[48];
+    snprintf(full, sizeof(full), LITTLEFS_MOUNT "%s", path);
+    return truncate(full, size) == 0;
+}
+
+HalFile *halFileOpenAppend(const char *path)
+{
+    File f = LittleFS.open(path, "a");
+    if (!f)
+        return nullptr;
+    HalFile *file = new HalFile;
+    file->file = f;
+    return file;
+}
+
+size_t halFileAppend(HalFile *file, const uint8_t *data, size_t len)
+{
+    return file->file.write(data, len);
+}
+
+long halFileLength(HalFile *file)
+{
+    return file->file.size();
+}
+
+bool halFileSync(HalFile *file)
+{
+    file->file.flush();
+    return true;
+}
+
+void halFileClose(HalFile *file)
+{
+    file->file.close();
+    delete file;
+}
+
+void halDisplayFrame(const uint8_t *frame, int width, int height)
+{
+    uint8_t *fb = displayFrameBuffer();
+    if (!fb)
+        return;
+    if (fb != frame)
+        memcpy(fb, frame, (size_t)width * height / 8);
+    displayPush();
+}
+
+void halI2cBegin(int sda, int scl, uint32_t clockHz)
+{
+    if (!i2cMutex)
+        i2cMutex = xSemaphoreCreateMutex();
+    Wire.begin(sda, scl);
+    Wire.setClock(clockHz);
+}
+
+void halI2cTake()
+{
+    if (i2cMutex)
+        xSemaphoreTake(i2cMutex, portMAX_DELAY);
+}
+
+void halI2cGive()
+{
+    if (i2cMutex)
+        xSemaphoreGive(i2cMutex);
+}
+
+bool halI2cWrite(uint8_t addr, const uint8_t *data, size_t len)
+{
+    Wire.beginTransmission(addr);
+    Wire.write(data, len);
+    return Wire.endTransmission() == 0;
+}
+
+bool halI2cWriteRead(uint8_t addr, const uint8_t *wr, size_t wlen, uint8_t *rd, size_t rlen)
+{
+    Wire.beginTransmission(addr);
+    Wire.write(wr, wlen);
+    if (Wire.endTransmission(false) != 0 || Wire.requestFrom(addr, rlen) != rlen)
+        return false;
+    for (size_t i = 0; i < rlen; i++)
+        rd[i] = Wire.read();
+    return true;
+}
+
+bool halSensorReceive(SensorReadings &out)
+{
+    return sensorReceive(out);
+}
+
+uint32_t halBatteryMilliVolts()
+{
+    uint32_t rawMv = 0;
+    for (int i = 0; i < BATTERY_ADC_SAMPLES; i++)
+    {
+        rawMv += analogReadMilliVolts(BATTERY_PIN);
+    }
+    return (uint32_t)(rawMv * VOLT_DIVIDER_RATIO / BATTERY_ADC_SAMPLES);
+}
+
+bool halButtonDown()
+{
+    return digitalRead(GPKEY_PIN) == LOW;
+}
+
+uint32_t halTouchRead()
+{
+    return touchRead(TOUCH_PIN);
+}
+
+bool halWiFiConnected()
+{
+    return WiFi.status() == WL_CONNECTED;
+}
+
+bool halBleActive()
+{
+    return isBLEActive();
+}
@@ -0,0 +1,143 @@
+#include "I2CBus.h"
+#include "Hal.h"
+#include <string.h>
+
+// Time to clock one byte (8 bits + ACK) at the bus speed, in microseconds
+#define I2C_BYTE_US ((9UL * 1000000UL + I2C_BUS_CLOCK - 1) / I2C_BUS_CLOCK)
+
+// Longest register write the BME68x driver issues (interleaved reg/value
+// pairs), plus the register address
+#define I2C_SENSOR_WRITE_MAX 64
+
+static bool busReady = false;
+static I2CBusStats stats;
+
+// BSEC cycle tracking. A cycle starts with the first sensor transaction
+// after a quiet gap; the next one is expected one period later.
+static uint32_t sensorPeriodMs = 3000;
+static uint32_t lastSensorIoMs = 0;
+static uint32_t cycleStartMs = 0;
+static bool cycleKnown = false;
+
+void initI2CBus(int sda, int scl)
+{
+    halI2cBegin(sda, scl, I2C_BUS_CLOCK);
+    busReady = true;
+}
+
+void i2cBusLock()
+{
+    if (!busReady)
+        return;
+    uint32_t startUs = halMicros();
+    halI2cTake();
+    uint32_t waitUs = halMicros() - startUs;
+    if (waitUs > stats.maxLockWaitUs)
+        stats.maxLockWaitUs = waitUs;
+}
+
+void i2cBusUnlock()
+{
+    if (busReady)
+        halI2cGive();
+}
+
+void i2cBusSetSensorPeriod(uint32_t periodMs)
+{
+    sensorPeriodMs = periodMs;
+    cycleKnown = false;
+}
+
+bool i2cBusDisplaySlot(size_t bytes)
+{
+    if (!cycleKnown)
+        return true;
+
+    uint32_t now = halMillis();
+    uint32_t costMs = (bytes * I2C_BYTE_US + 999) / 1000;
+    int32_t untilDue = (int32_t)(cycleStartMs + sensorPeriodMs - now);
+
+    // Too late for the expected cycle: either it ran and the estimate is
+    // stale, or the sensor didn't need the bus. Don't starve the display.
+    if (untilDue < -(int32_t)I2C_SENSOR_GUARD_MS)
+        return true;
+
+    return untilDue > (int32_t)(costMs + I2C_SENSOR_GUARD_MS);
+}
+
+bool i2cBusNextSensorCycle(uint32_t &atMs)
+{
+    if (!cycleKnown)
+        return false;
+
+    // A cycle that never showed up (BSEC skipped it) must not hold the
+    // deadline in the past; assume the schedule carried on
+    uint32_t now = halMillis();
+    atMs = cycleStartMs + sensorPeriodMs;
+    while ((int32_t)(atMs - now) < -(int32_t)I2C_SENSOR_GUARD_MS)
+        atMs += sensorPeriodMs;
+    return true;
+}
+
+uint32_t i2cBusLastSensorIoMs()
+{
+    return lastSensorIoMs;
+}
+
+void i2cBusCountDisplayChunk(bool deferred)
+{
+    if (deferred)
+        stats.displayDeferrals++;
+    else
+        stats.displayChunks++;
+}
+
+static void noteSensorIo()
+{
+    uint32_t now = halMillis();
+    if (!cycleKnown || now - lastSensorIoMs > sensorPeriodMs / 2)
+    {
+        cycleStartMs = now;
+        cycleKnown = true;
+    }
+    lastSensorIoMs = now;
+    stats.sensorTransactions++;
+}
+
+bool i2cSensorReadRegs(uint8_t addr, uint8_t reg, uint8_t *data, uint32_t len)
+{
+    i2cBusLock();
+    noteSensorIo();
+    bool ok = halI2cWriteRead(addr, &reg, 1, data, len);
+    i2cBusUnlock();
+
+    if (!ok)
+        stats.sensorErrors++;
+    return ok;
+}
+
+bool i2cSensorWriteRegs(uint8_t addr, uint8_t reg, const uint8_t *data, uint32_t len)
+{
+    uint8_t buf[I2C_SENSOR_WRITE_MAX];
+    if (len >= sizeof(buf))
+    {
+        stats.sensorErrors++;
+        return false;
+    }
+    buf[0] = reg;
+    memcpy(buf + 1, data, len);
+
+    i2cBusLock();
+    noteSensorIo();
+    bool ok = halI2cWrite(addr, buf, len + 1);
+    i2cBusUnlock();
+
+    if (!ok)
+        stats.sensorErrors++;
+    return ok;
+}
+
+I2CBusStats getI2CBusStats()
+{
+    return stats;
+}
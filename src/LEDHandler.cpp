@@ -133,6 +133,24 @@ void updateLED()
     }
 }
 
+bool ledNextDeadline(uint32_t &atMs, bool &mustWake)
+{
+    // updateLED() steps once more than the period has passed
+    switch (currentState)
+    {
+    case LED_RECORDING:
+        atMs = lastUpdate + 31;
+        mustWake = false;
+        return true;
+    case LED_LOW_BATTERY:
+        atMs = lastUpdate + 501;
+        mustWake = true;
+        return true;
+    default:
+        return false;
+    }
+}
+
 void flashLED(uint8_t r, uint8_t g, uint8_t b, int duration_ms)
 {
     LEDState previousState = currentState;
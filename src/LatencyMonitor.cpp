@@ -0,0 +1,59 @@
+#include "LatencyMonitor.h"
+
+enum InputPhase
+{
+    INPUT_IDLE,
+    INPUT_EDGE,    // Pressed, no handler yet
+    INPUT_HANDLED  // Waiting for the next complete frame
+};
+
+static LatencyStats stats;
+static InputPhase phase = INPUT_IDLE;
+static uint32_t edgeAtUs = 0;
+
+void latencyLoopPass(uint32_t busyUs)
+{
+    stats.loopUs.add(busyUs);
+}
+
+void latencyInputEdge(uint32_t edgeUs)
+{
+    if (phase != INPUT_IDLE)
+        return;
+    edgeAtUs = edgeUs;
+    phase = INPUT_EDGE;
+}
+
+void latencyInputHandled()
+{
+    if (phase == INPUT_EDGE)
+        phase = INPUT_HANDLED;
+}
+
+void latencyInputIdle()
+{
+    if (phase == INPUT_EDGE)
+    {
+        stats.inputsIgnored++;
+        phase = INPUT_IDLE;
+    }
+}
+
+void latencyFrameShown(uint32_t nowUs)
+{
+    if (phase != INPUT_HANDLED)
+        return;
+    stats.inputToPixelUs.add(nowUs - edgeAtUs);
+    phase = INPUT_IDLE;
+}
+
+const LatencyStats &getLatencyStats()
+{
+    return stats;
+}
+
+void resetLatencyStats()
+{
+    stats = LatencyStats();
+    phase = INPUT_IDLE;
+}
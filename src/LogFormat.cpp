@@ -0,0 +1,188 @@
+#include "LogFormat.h"
+#include "FixedFormat.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Nibble-wise CRC-32 (IEEE 802.3), small enough to keep in flash
+static const uint32_t crcNibbleTable[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+    0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+
+uint32_t logCrc32(const uint8_t *data, size_t len, uint32_t crc)
+{
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++)
+    {
+        crc = crcNibbleTable[(crc ^ data[i]) & 0x0F] ^ (crc >> 4);
+        crc = crcNibbleTable[(crc ^ (data[i] >> 4)) & 0x0F] ^ (crc >> 4);
+    }
+    return ~crc;
+}
+
+static void put16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+}
+
+static uint16_t get16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Scale by 100 and round, clamped to the field range
+static int32_t toCenti(float v, int32_t lo, int32_t hi)
+{
+    long c = lroundf(v * 100.0f);
+    if (c < lo)
+        return lo;
+    if (c > hi)
+        return hi;
+    return (int32_t)c;
+}
+
+size_t logBinEncodeHeader(uint8_t *out, uint32_t startMs, uint32_t sessionId)
+{
+    put32(out, LOG_BIN_MAGIC);
+    out[4] = LOG_BIN_VERSION;
+    out[5] = LOG_SCHEMA_DEFAULT;
+    out[6] = LOG_BIN_RECORD_SIZE;
+    out[7] = 0;
+    put32(out + 8, startMs);
+    put32(out + 12, sessionId);
+    return LOG_BIN_HEADER_SIZE;
+}
+
+bool logBinDecodeHeader(const uint8_t *in, size_t len, LogBinHeader &hdr)
+{
+    if (len < LOG_BIN_HEADER_SIZE)
+        return false;
+    hdr.magic = get32(in);
+    hdr.version = in[4];
+    hdr.schema = in[5];
+    hdr.recordSize = in[6];
+    hdr.startMs = get32(in + 8);
+    hdr.sessionId = get32(in + 12);
+    return hdr.magic == LOG_BIN_MAGIC && hdr.version == LOG_BIN_VERSION && hdr.recordSize == LOG_BIN_RECORD_SIZE;
+}
+
+size_t logBinEncodeBlock(uint8_t *out, size_t outSize, uint16_t blockSeq, const LogData *samples, int count)
+{
+    if (count <= 0 || count > LOG_BIN_BLOCK_MAX_RECORDS)
+        return 0;
+
+    size_t total = LOG_BIN_BLOCK_HEADER_SIZE + count * LOG_BIN_RECORD_SIZE + LOG_BIN_BLOCK_CRC_SIZE;
+    if (outSize < total)
+        return 0;
+
+    out[0] = LOG_BIN_BLOCK_MARKER;
+    out[1] = (uint8_t)count;
+    put16(out + 2, blockSeq);
+
+    uint8_t *p = out + LOG_BIN_BLOCK_HEADER_SIZE;
+    for (int i = 0; i < count; i++)
+    {
+        put32(p, (uint32_t)samples[i].timestamp);
+        put16(p + 4, (uint16_t)toCenti(samples[i].iaq, 0, 65535));
+        put32(p + 6, (uint32_t)toCenti(samples[i].co2, 0, 0x7FFFFFFF));
+        put16(p + 10, (uint16_t)(int16_t)toCenti(samples[i].temp, -32768, 32767));
+        put16(p + 12, (uint16_t)toCenti(samples[i].hum, 0, 65535));
+        p += LOG_BIN_RECORD_SIZE;
+    }
+
+    put32(p, logCrc32(out, p - out));
+    return total;
+}
+
+int logBinDecodeBlock(const uint8_t *in, size_t len, LogData *out, int maxOut, size_t &consumed, uint16_t *blockSeq)
+{
+    if (len < LOG_BIN_BLOCK_HEADER_SIZE || in[0] != LOG_BIN_BLOCK_MARKER)
+        return -1;
+
+    int count = in[1];
+    if (count == 0 || count > LOG_BIN_BLOCK_MAX_RECORDS)
+        return -1;
+
+    size_t total = LOG_BIN_BLOCK_HEADER_SIZE + count * LOG_BIN_RECORD_SIZE + LOG_BIN_BLOCK_CRC_SIZE;
+    if (len < total)
+        return -1;
+
+    size_t crcOffset = total - LOG_BIN_BLOCK_CRC_SIZE;
+    if (logCrc32(in, crcOffset) != get32(in + crcOffset))
+        return -1;
+
+    if (blockSeq)
+        *blockSeq = get16(in + 2);
+
+    const uint8_t *p = in + LOG_BIN_BLOCK_HEADER_SIZE;
+    int n = count < maxOut ? count : maxOut;
+    for (int i = 0; i < n; i++)
+    {
+        out[i].timestamp = get32(p);
+        out[i].iaq = get16(p + 4) / 100.0f;
+        out[i].co2 = get32(p + 6) / 100.0f;
+        out[i].temp = (int16_t)get16(p + 10) / 100.0f;
+        out[i].hum = get16(p + 12) / 100.0f;
+        p += LOG_BIN_RECORD_SIZE;
+    }
+
+    consumed = total;
+    return n;
+}
+
+int logCsvFormatLine(char *out, size_t outSize, const LogData &sample)
+{
+    FmtBuf b;
+    fmtInit(b, out, outSize);
+    fmtUint(b, sample.timestamp);
+    const float values[4] = {sample.iaq, sample.co2, sample.temp, sample.hum};
+    for (float v : values)
+    {
+        fmtChar(b, ',');
+        fmtFixed(b, v, 2);
+    }
+    fmtChar(b, '\n');
+    return fmtEnd(b);
+}
+
+bool logCsvParseLine(const char *line, size_t len, LogData &out)
+{
+    char buf[96];
+    if (len == 0 || len >= sizeof(buf))
+        return false;
+    memcpy(buf, line, len);
+    buf[len] = '\0';
+
+    if (buf[0] < '0' || buf[0] > '9')
+        return false;
+
+    char *p = buf;
+    char *end;
+    out.timestamp = strtoul(p, &end, 10);
+    float *fields[4] = {&out.iaq, &out.co2, &out.temp, &out.hum};
+    for (int i = 0; i < 4; i++)
+    {
+        if (end == p || *end != ',')
+            return false;
+        p = end + 1;
+        *fields[i] = strtof(p, &end);
+    }
+    return end != p && (*end == '\0' || *end == '\r');
+}
@@ -0,0 +1,338 @@
+#include "LogManifest.h"
+#include "LogStorage.h"
+#include "LogWriter.h"
+#include "SharedData.h"
+#include <LittleFS.h>
+
+#define LOG_MANIFEST_MAGIC 0x58444948UL // "HIDX"
+#define LOG_MANIFEST_VERSION 1
+
+struct LogManifestHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+    uint32_t crc; // Over the entries
+};
+
+static LogManifestEntry entries[LOG_MANIFEST_MAX];
+static int entryCount = 0;
+static bool dirty = false;
+static unsigned long lastSaveMs = 0;
+
+// Written by the log writer task, read by the web server and main loop
+static SemaphoreHandle_t manifestMutex = nullptr;
+
+static void lock()
+{
+    if (manifestMutex)
+        xSemaphoreTake(manifestMutex, portMAX_DELAY);
+}
+
+static void unlock()
+{
+    if (manifestMutex)
+        xSemaphoreGive(manifestMutex);
+}
+
+static int findEntry(int index)
+{
+    for (int i = 0; i < entryCount; i++)
+    {
+        if (entries[i].index == index)
+            return i;
+    }
+    return -1;
+}
+
+void logManifestFileName(const LogManifestEntry &entry, char *out, size_t len)
+{
+    snprintf(out, len, "/log_%03d.%s", (int)entry.index, entry.format == LOG_FORMAT_BIN ? "hlg" : "csv");
+}
+
+static bool loadManifest()
+{
+    File file = LittleFS.open(LOG_MANIFEST_FILE, "r");
+    if (!file)
+        return false;
+
+    LogManifestHeader hdr;
+    bool ok = file.read((uint8_t *)&hdr, sizeof(hdr)) == sizeof(hdr) &&
+              hdr.magic == LOG_MANIFEST_MAGIC &&
+              hdr.version == LOG_MANIFEST_VERSION &&
+              hdr.count <= LOG_MANIFEST_MAX;
+
+    if (ok)
+    {
+        size_t bytes = hdr.count * sizeof(LogManifestEntry);
+        ok = file.read((uint8_t *)entries, bytes) == bytes &&
+             logCrc32((const uint8_t *)entries, bytes) == hdr.crc;
+    }
+    file.close();
+
+    entryCount = ok ? hdr.count : 0;
+    return ok;
+}
+
+static void saveManifest()
+{
+    LogManifestHeader hdr;
+    hdr.magic = LOG_MANIFEST_MAGIC;
+    hdr.version = LOG_MANIFEST_VERSION;
+    hdr.count = entryCount;
+    hdr.crc = logCrc32((const uint8_t *)entries, entryCount * sizeof(LogManifestEntry));
+
+    File file = LittleFS.open(LOG_MANIFEST_FILE, "w");
+    if (file)
+    {
+        file.write((uint8_t *)&hdr, sizeof(hdr));
+        file.write((uint8_t *)entries, entryCount * sizeof(LogManifestEntry));
+        file.close();
+    }
+    dirty = false;
+    lastSaveMs = millis();
+}
+
+// Reads a CSV recording once to recover sample count and time span
+static void scanCsv(File &file, LogManifestEntry &entry)
+{
+    char line[64];
+    int lineLen = 0;
+    bool header = true;
+    uint8_t chunk[256];
+    size_t n;
+
+    while ((n = file.read(chunk, sizeof(chunk))) > 0)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            if (chunk[i] != '\n')
+            {
+                if (lineLen < (int)sizeof(line) - 1)
+                    line[lineLen++] = chunk[i];
+                continue;
+            }
+            line[lineLen] = '\0';
+            lineLen = 0;
+            if (header)
+            {
+                header = false;
+                continue;
+            }
+            uint32_t ts = strtoul(line, nullptr, 10);
+            if (entry.samples == 0)
+                entry.startMs = ts;
+            entry.endMs = ts;
+            entry.samples++;
+        }
+    }
+}
+
+// Walks the blocks of a binary recording without decoding every record
+static void scanBinary(File &file, LogManifestEntry &entry)
+{
+    uint8_t block[LOG_BIN_BLOCK_MAX_SIZE];
+    LogData records[LOG_BIN_BLOCK_MAX_RECORDS];
+    size_t size = file.size();
+    size_t offset = LOG_BIN_HEADER_SIZE;
+
+    while (offset + LOG_BIN_BLOCK_HEADER_SIZE <= size)
+    {
+        file.seek(offset);
+        size_t n = file.read(block, sizeof(block));
+        size_t consumed = 0;
+        int count = logBinDecodeBlock(block, n, records, LOG_BIN_BLOCK_MAX_RECORDS, consumed);
+        if (count <= 0)
+            break;
+        if (entry.samples == 0)
+            entry.startMs = records[0].timestamp;
+        entry.endMs = records[count - 1].timestamp;
+        entry.samples += count;
+        offset += consumed;
+    }
+}
+
+void logManifestRebuild()
+{
+    lock();
+    entryCount = 0;
+
+    File root = LittleFS.open("/");
+    if (root && root.isDirectory())
+    {
+        File file = root.openNextFile();
+        while (file && entryCount < LOG_MANIFEST_MAX)
+        {
+            int index = logFileIndex(file.name());
+            if (index >= 0)
+            {
+                LogManifestEntry &entry = entries[entryCount++];
+                memset(&entry, 0, sizeof(entry));
+                entry.index = index;
+                entry.format = isBinaryLogName(file.name()) ? LOG_FORMAT_BIN : LOG_FORMAT_CSV;
+                entry.schema = LOG_SCHEMA_DEFAULT;
+                entry.size = file.size();
+                if (entry.format == LOG_FORMAT_BIN)
+                    scanBinary(file, entry);
+                else
+                    scanCsv(file, entry);
+            }
+            file = root.openNextFile();
+        }
+    }
+
+    // Keep entries ordered oldest first
+    for (int i = 1; i < entryCount; i++)
+    {
+        LogManifestEntry e = entries[i];
+        int j = i - 1;
+        while (j >= 0 && entries[j].index > e.index)
+        {
+            entries[j + 1] = entries[j];
+            j--;
+        }
+        entries[j + 1] = e;
+    }
+
+    saveManifest();
+    unlock();
+}
+
+void initLogManifest()
+{
+    if (!manifestMutex)
+        manifestMutex = xSemaphoreCreateMutex();
+
+    LogWriterIndex hooks;
+    hooks.record = logManifestRecord;
+    hooks.setSize = logManifestSetSize;
+    hooks.save = logManifestSave;
+    logWriterSetIndex(hooks);
+
+    if (!loadManifest())
+    {
+        logManifestRebuild();
+        return;
+    }
+
+    // Stale check: every indexed file must still exist, and the most recent
+    // recording must be indexed (a reset can land between the two updates)
+    bool stale = false;
+    char name[32];
+    for (int i = 0; i < entryCount && !stale; i++)
+    {
+        logManifestFileName(entries[i], name, sizeof(name));
+        stale = !LittleFS.exists(name);
+    }
+    int lastIndex = sysConfig.nextLogIndex - 1;
+    if (!stale && lastIndex > 0 && findEntry(lastIndex) < 0)
+    {
+        snprintf(name, sizeof(name), "/log_%03d.csv", lastIndex);
+        stale = LittleFS.exists(name);
+        snprintf(name, sizeof(name), "/log_%03d.hlg", lastIndex);
+        stale = stale || LittleFS.exists(name);
+    }
+
+    if (stale)
+        logManifestRebuild();
+}
+
+void logManifestAdd(const char *fileName)
+{
+    int index = logFileIndex(fileName);
+    if (index < 0)
+        return;
+
+    lock();
+    int i = findEntry(index);
+    if (i < 0)
+    {
+        // Full index: drop the oldest recording. Quota enforcement normally
+        // makes room first; the file goes too, or it would sit on flash
+        // where neither the listing nor the quota can see it.
+        if (entryCount >= LOG_MANIFEST_MAX)
+        {
+            char evicted[32];
+            logManifestFileName(entries[0], evicted, sizeof(evicted));
+            LittleFS.remove(evicted);
+            memmove(entries, entries + 1, (LOG_MANIFEST_MAX - 1) * sizeof(LogManifestEntry));
+            entryCount--;
+        }
+        i = entryCount++;
+    }
+    LogManifestEntry &entry = entries[i];
+    memset(&entry, 0, sizeof(entry));
+    entry.index = index;
+    entry.format = isBinaryLogName(fileName) ? LOG_FORMAT_BIN : LOG_FORMAT_CSV;
+    entry.schema = LOG_SCHEMA_DEFAULT;
+    saveManifest();
+    unlock();
+}
+
+void logManifestRecord(const char *fileName, const LogData *samples, int count, uint32_t size)
+{
+    lock();
+    int i = findEntry(logFileIndex(fileName));
+    if (i >= 0 && count > 0)
+    {
+        LogManifestEntry &entry = entries[i];
+        if (entry.samples == 0)
+            entry.startMs = samples[0].timestamp;
+        entry.endMs = samples[count - 1].timestamp;
+        entry.samples += count;
+        entry.size = size;
+        dirty = true;
+    }
+    unlock();
+}
+
+void logManifestSetSize(const char *fileName, uint32_t size)
+{
+    lock();
+    int i = findEntry(logFileIndex(fileName));
+    if (i >= 0 && entries[i].size != size)
+    {
+        entries[i].size = size;
+        saveManifest();
+    }
+    unlock();
+}
+
+void logManifestRemove(const char *fileName)
+{
+    lock();
+    int i = findEntry(logFileIndex(fileName));
+    if (i >= 0)
+    {
+        memmove(entries + i, entries + i + 1, (entryCount - i - 1) * sizeof(LogManifestEntry));
+        entryCount--;
+        saveManifest();
+    }
+    unlock();
+}
+
+void logManifestSave(bool force)
+{
+    lock();
+    if (dirty && (force || millis() - lastSaveMs >= LOG_MANIFEST_SAVE_INTERVAL))
+        saveManifest();
+    unlock();
+}
+
+int logManifestCount()
+{
+    lock();
+    int count = entryCount;
+    unlock();
+    return count;
+}
+
+bool logManifestGet(int i, LogManifestEntry &out)
+{
+    lock();
+    bool ok = i >= 0 && i < entryCount;
+    if (ok)
+        out = entries[i];
+    unlock();
+    return ok;
+}
@@ -0,0 +1,210 @@
+#include "LogReplay.h"
+#include "Hal.h"
+#include <string.h>
+#include <stdio.h>
+
+// Fall this far behind (blocked loop, light sleep) and the schedule is
+// moved up instead of bursting through the backlog
+#define LOG_REPLAY_MAX_LAG_MS 2000
+
+static bool isBinaryPath(const char *path)
+{
+    size_t n = strlen(path);
+    return n > 4 && strcmp(path + n - 4, ".hlg") == 0;
+}
+
+static void replayRewind(LogReplay &r)
+{
+    r.fileOffset = 0;
+    r.bufLen = 0;
+    r.bufPos = 0;
+    r.headerDone = false;
+    r.blockCount = 0;
+    r.blockPos = 0;
+}
+
+// Keep the unread tail and top the buffer up from the file.
+// Returns false if nothing more could be read.
+static bool fillBuffer(LogReplay &r)
+{
+    size_t tail = r.bufLen - r.bufPos;
+    memmove(r.buf, r.buf + r.bufPos, tail);
+    r.bufLen = tail;
+    r.bufPos = 0;
+
+    size_t n = halFileRead(r.path, r.fileOffset, r.buf + r.bufLen, sizeof(r.buf) - r.bufLen);
+    r.fileOffset += n;
+    r.bufLen += n;
+    return n > 0;
+}
+
+static bool readBinary(LogReplay &r, LogData &out)
+{
+    for (;;)
+    {
+        if (r.blockPos < r.blockCount)
+        {
+            out = r.block[r.blockPos++];
+            return true;
+        }
+
+        if (!r.headerDone)
+        {
+            if (r.bufLen - r.bufPos < LOG_BIN_HEADER_SIZE)
+                fillBuffer(r);
+            LogBinHeader hdr;
+            if (!logBinDecodeHeader(r.buf + r.bufPos, r.bufLen - r.bufPos, hdr))
+                return false;
+            r.bufPos += LOG_BIN_HEADER_SIZE;
+            r.headerDone = true;
+            continue;
+        }
+
+        size_t consumed = 0;
+        int n = logBinDecodeBlock(r.buf + r.bufPos, r.bufLen - r.bufPos, r.block, LOG_BIN_BLOCK_MAX_RECORDS, consumed);
+        if (n > 0)
+        {
+            r.bufPos += consumed;
+            r.blockCount = n;
+            r.blockPos = 0;
+            continue;
+        }
+
+        // Possibly just split across chunks; otherwise torn or corrupt,
+        // and playback stops there like hlg2csv does
+        if (r.bufLen - r.bufPos < LOG_BIN_BLOCK_MAX_SIZE && fillBuffer(r))
+            continue;
+        if (r.bufLen > r.bufPos)
+            r.skipped++;
+        return false;
+    }
+}
+
+static bool readCsv(LogReplay &r, LogData &out)
+{
+    for (;;)
+    {
+        const char *line = (const char *)r.buf + r.bufPos;
+        const char *nl = (const char *)memchr(line, '\n', r.bufLen - r.bufPos);
+        size_t len;
+        if (nl)
+        {
+            len = nl - line;
+            r.bufPos += len + 1;
+        }
+        else if (fillBuffer(r))
+        {
+            continue;
+        }
+        else if (r.bufLen > r.bufPos)
+        {
+            // Last line without a line ending (fillBuffer moved it)
+            line = (const char *)r.buf + r.bufPos;
+            len = r.bufLen - r.bufPos;
+            r.bufPos = r.bufLen;
+        }
+        else
+        {
+            return false;
+        }
+
+        bool ok = logCsvParseLine(line, len, out);
+        if (!ok && r.headerDone)
+            r.skipped++;
+        r.headerDone = true; // The first line is the column header
+        if (ok)
+            return true;
+    }
+}
+
+static bool readRecord(LogReplay &r, LogData &out)
+{
+    return r.binary ? readBinary(r, out) : readCsv(r, out);
+}
+
+// Load the sample after the one just delivered and work out when it is
+// due, from the recorded gap scaled by the playback speed
+static void loadNext(LogReplay &r, bool first)
+{
+    LogData s;
+    bool ok = readRecord(r, s);
+    if (!ok && r.loop && r.samples > 0)
+    {
+        replayRewind(r);
+        r.loops++;
+        first = true;
+        ok = readRecord(r, s);
+    }
+    if (!ok)
+    {
+        r.hasNext = false;
+        r.active = false;
+        return;
+    }
+
+    uint32_t gap = 0;
+    if (!first && s.timestamp >= r.lastTimestamp && s.timestamp - r.lastTimestamp <= LOG_REPLAY_MAX_GAP_MS)
+        gap = s.timestamp - r.lastTimestamp;
+    if (r.speed > 0)
+        r.nextDueMs += (uint32_t)(gap / r.speed);
+
+    r.lastTimestamp = s.timestamp;
+    r.next = s;
+    r.hasNext = true;
+}
+
+bool logReplayOpen(LogReplay &r, const char *path, float speed, bool loop, uint32_t nowMs)
+{
+    logReplayClose(r);
+    snprintf(r.path, sizeof(r.path), "%s", path);
+    r.binary = isBinaryPath(path);
+    r.speed = speed < 0 ? 0 : speed;
+    r.loop = loop;
+    r.samples = 0;
+    r.loops = 0;
+    r.skipped = 0;
+    r.nextDueMs = nowMs;
+    replayRewind(r);
+
+    r.active = true;
+    loadNext(r, true);
+    return r.active;
+}
+
+void logReplayClose(LogReplay &r)
+{
+    r.active = false;
+    r.hasNext = false;
+}
+
+bool logReplayNext(LogReplay &r, uint32_t nowMs, LogData &out)
+{
+    if (!r.active || !r.hasNext)
+        return false;
+    if (r.speed > 0)
+    {
+        int32_t lateMs = (int32_t)(nowMs - r.nextDueMs);
+        if (lateMs < 0)
+            return false;
+        if (lateMs > LOG_REPLAY_MAX_LAG_MS)
+            r.nextDueMs = nowMs;
+    }
+
+    out = r.next;
+    r.samples++;
+    loadNext(r, false);
+    return true;
+}
+
+uint32_t logReplayDueMs(const LogReplay &r)
+{
+    return r.nextDueMs;
+}
+
+void logReplayApply(const LogData &sample, SensorReadings &r)
+{
+    r.iaq = sample.iaq;
+    r.co2 = sample.co2;
+    r.temp = sample.temp;
+    r.hum = sample.hum;
+}
@@ -0,0 +1,123 @@
+#include "LogStaging.h"
+#include "LogWriter.h"
+
+#define LOG_STAGE_MAGIC 0x47545352UL // "RSTG"
+
+struct LogStage
+{
+    uint32_t magic;
+    int32_t logIndex;
+    uint32_t count;
+    // The first `handed` samples are with the writer; they leave the stage
+    // once its committed count reaches handedSeq
+    uint32_t handed;
+    uint32_t handedSeq;
+    LogData samples[LOG_STAGE_CAPACITY];
+    uint32_t crc;
+};
+
+// RTC_NOINIT_ATTR survives deep sleep and software resets. Its contents are
+// random after power-on, so they are only trusted when magic and CRC match.
+RTC_NOINIT_ATTR static LogStage stage;
+
+static uint32_t stageCrc()
+{
+    return logCrc32((const uint8_t *)&stage, offsetof(LogStage, crc));
+}
+
+static void stageClear(int logIndex)
+{
+    stage.magic = LOG_STAGE_MAGIC;
+    stage.logIndex = logIndex;
+    stage.count = 0;
+    stage.handed = 0;
+    stage.crc = stageCrc();
+}
+
+static void stageRemove(uint32_t n)
+{
+    stage.count -= n;
+    stage.handed = stage.handed > n ? stage.handed - n : 0;
+    memmove(stage.samples, stage.samples + n, stage.count * sizeof(LogData));
+    stage.crc = stageCrc();
+}
+
+// Drop the handed-over samples once the writer has committed them
+static void stageTrim()
+{
+    if (stage.handed > 0 && (int32_t)(logWriterCommittedSeq() - stage.handedSeq) >= 0)
+        stageRemove(stage.handed);
+}
+
+void initLogStaging(int logIndex)
+{
+    bool valid = stage.magic == LOG_STAGE_MAGIC &&
+                 stage.count <= LOG_STAGE_CAPACITY &&
+                 stage.crc == stageCrc();
+
+    if (!valid || stage.logIndex != logIndex || logIndex < 0)
+    {
+        stageClear(logIndex);
+        return;
+    }
+
+    // The writer's RAM didn't survive the reset: whatever it had not
+    // committed goes to it again
+    stage.handed = 0;
+    stage.crc = stageCrc();
+}
+
+bool logStagePush(const LogData &sample, int logIndex)
+{
+    // A new recording invalidates whatever was staged for the previous one
+    if (stage.logIndex != logIndex)
+        stageClear(logIndex);
+
+    stageTrim();
+    if (stage.count >= LOG_STAGE_CAPACITY)
+        logStageDrain();
+    // Still full: the writer hasn't committed a whole stage. Let go of what
+    // it already holds, or as a last resort the oldest sample.
+    if (stage.count >= LOG_STAGE_CAPACITY)
+        stageRemove(stage.handed > 0 ? stage.handed : 1);
+
+    stage.samples[stage.count++] = sample;
+    stage.crc = stageCrc();
+
+    return stage.count >= LOG_STAGE_COMMIT_THRESHOLD;
+}
+
+int logStageDrain()
+{
+    stageTrim();
+    if (stage.count == 0)
+        return 0;
+
+    // Samples the writer can't take yet (both buffers busy) stay staged
+    int taken = 0;
+    while (stage.handed < stage.count)
+    {
+        if (logWriterPending() >= LOG_BUFFER_SIZE && isLogWriterBusy())
+            break;
+        if (!logWriterPush(stage.samples[stage.handed]))
+            break;
+        stage.handed++;
+        taken++;
+    }
+    if (taken > 0)
+        stage.handedSeq = logWriterPushedSeq();
+    stage.crc = stageCrc();
+
+    // The writer commits the batch on its own task; waiting for it here
+    // would stall the sensor task for up to the writer's flush timeout.
+    // Everything stays staged until that commit lands, and each later
+    // drain asks again if the handoff couldn't happen yet.
+    logWriterRequestCommit();
+    stageTrim();
+    return taken;
+}
+
+int logStageCount()
+{
+    return stage.count;
+}
@@ -0,0 +1,136 @@
+#include "LogStorage.h"
+#include "LogWriter.h"
+#include "SharedData.h"
+#include "LogManifest.h"
+#include <LittleFS.h>
+
+// Nominal encoded sizes, used until the writer has real numbers
+#define CSV_BYTES_PER_SAMPLE 36.0f
+#define BIN_BYTES_PER_SAMPLE 14.2f
+
+int logFileIndex(const char *name)
+{
+    if (name[0] == '/')
+        name++;
+
+    int index = -1;
+    char ext[4] = "";
+    if (sscanf(name, "log_%d.%3s", &index, ext) != 2)
+        return -1;
+    if (strcmp(ext, "csv") != 0 && strcmp(ext, "hlg") != 0)
+        return -1;
+    return index;
+}
+
+uint32_t logStorageQuota()
+{
+    if (sysConfig.logQuotaKB > 0)
+        return sysConfig.logQuotaKB * 1024UL;
+    return (uint32_t)((uint64_t)LittleFS.totalBytes() * LOG_QUOTA_DEFAULT_PCT / 100);
+}
+
+uint32_t logStorageClampQuotaKB(uint32_t kb)
+{
+    if (kb == 0)
+        return 0;
+    uint32_t minKB = LOG_SEGMENT_SIZE / 1024;
+    uint32_t maxKB = LittleFS.totalBytes() / 1024;
+    if (kb < minKB)
+        kb = minKB;
+    if (kb > maxKB)
+        kb = maxKB;
+    return kb;
+}
+
+// Sums up recordings from the manifest. Optionally reports the oldest one
+// that isn't currently being recorded.
+static void scanLogs(uint32_t &logBytes, int &segments, int &oldestIndex, char *oldestName, size_t oldestLen)
+{
+    logBytes = 0;
+    segments = 0;
+    oldestIndex = -1;
+
+    RecordingState rec = recordingSnapshot();
+    int activeIndex = rec.active ? logFileIndex(rec.fileName) : -1;
+    LogManifestEntry entry;
+    for (int i = 0; logManifestGet(i, entry); i++)
+    {
+        logBytes += entry.size;
+        segments++;
+
+        if (entry.index != activeIndex && (oldestIndex < 0 || entry.index < oldestIndex))
+        {
+            oldestIndex = entry.index;
+            if (oldestName)
+                logManifestFileName(entry, oldestName, oldestLen);
+        }
+    }
+}
+
+int logStorageEnforceQuota(uint32_t reserveBytes)
+{
+    uint32_t quota = logStorageQuota();
+    int removed = 0;
+
+    for (;;)
+    {
+        uint32_t logBytes;
+        int segments, oldestIndex;
+        char oldestName[32];
+        scanLogs(logBytes, segments, oldestIndex, oldestName, sizeof(oldestName));
+
+        uint32_t freeBytes = LittleFS.totalBytes() - LittleFS.usedBytes();
+        bool fits = (logBytes + reserveBytes <= quota) && (reserveBytes <= freeBytes) &&
+                    segments < LOG_MANIFEST_MAX;
+        if (fits || oldestIndex < 0)
+            break;
+
+        // A missing file just means the index was stale
+        LittleFS.remove(oldestName);
+        logManifestRemove(oldestName);
+        removed++;
+    }
+    return removed;
+}
+
+bool logStorageSegmentFull()
+{
+    if (!isRecording)
+        return false;
+
+    LogWriterStats stats = getLogWriterStats();
+    return stats.sessionBytes >= LOG_SEGMENT_SIZE && strcmp(stats.sessionFile, currentLogFileName) == 0;
+}
+
+LogStorageReport getLogStorageReport()
+{
+    LogStorageReport report;
+    report.totalBytes = LittleFS.totalBytes();
+    report.usedBytes = LittleFS.usedBytes();
+    report.freeBytes = report.totalBytes - report.usedBytes;
+    report.quotaBytes = logStorageQuota();
+    scanLogs(report.logBytes, report.segments, report.oldestIndex, nullptr, 0);
+
+    // Only trust the measurement once something reached flash; before that
+    // the ratio is 0 and the estimate below would divide by it
+    LogWriterStats stats = getLogWriterStats();
+    if (stats.samplesWritten > 0 && stats.flashBytesWritten > 0)
+        report.bytesPerSample = (float)stats.flashBytesWritten / stats.samplesWritten;
+    else
+        report.bytesPerSample = (sysConfig.logFormat == LOG_FORMAT_BIN) ? BIN_BYTES_PER_SAMPLE : CSV_BYTES_PER_SAMPLE;
+
+    // Sample period of the current mode (ECO assumes the screen-off rate)
+    float periodSec = 3.0f;
+    if (sysConfig.opMode == MODE_REALTIME)
+        periodSec = 1.0f;
+    else if (sysConfig.opMode == MODE_ECO)
+        periodSec = 300.0f;
+
+    uint32_t available = report.quotaBytes > report.logBytes ? report.quotaBytes - report.logBytes : 0;
+    if (available > report.freeBytes)
+        available = report.freeBytes;
+
+    float remaining = available / report.bytesPerSample * periodSec;
+    report.remainingSec = remaining < 4294967295.0f ? (uint32_t)remaining : 0xFFFFFFFFUL;
+    return report;
+}
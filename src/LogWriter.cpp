@@ -0,0 +1,534 @@
+#include "LogWriter.h"
+#include "SharedData.h"
+#include "Hal.h"
+#include <stdio.h>
+#include <string.h>
+
+#define LOG_FLUSH_WAIT_MS 5000
+
+// Marker describing the recording in progress, used for boot-time recovery
+#define LOG_SESSION_FILE "/rec_session.bin"
+#define LOG_SESSION_MAGIC 0x53454C48UL // "HLES"
+
+// Double buffer: the sensor callback fills logBuffers[activeBuf] while the
+// writer task owns logBuffers[pendingBuf] (if any).
+static LogData logBuffers[2][LOG_BUFFER_SIZE];
+static int activeBuf = 0;
+static int activeHead = 0;
+
+static volatile int pendingBuf = -1; // -1 when the writer is idle
+static int pendingCount = 0;
+static char pendingFileName[32];
+static uint32_t pendingSinceUs = 0;
+static bool pendingSync = false;
+static volatile int syncBatch = 0;
+static bool commitOnHandOff = false; // logWriterRequestCommit() is waiting for a handoff
+
+// Running sample counts: accepted by logWriterPush(), handed over with the
+// pending buffer, in the session, and committed to flash
+static uint32_t pushedSeq = 0;
+static uint32_t pendingSeq = 0;
+static uint32_t writtenSeq = 0;
+static volatile uint32_t committedSeq = 0;
+
+static bool writerStarted = false;
+static LogWriterStats stats;
+static LogWriterIndex hooks = {};
+
+// Recording session: owned by the writer task. Keeps the log file open for
+// the whole recording and only hands LittleFS whole, block-aligned chunks,
+// plus a partial tail on each metadata commit.
+struct RecordingSession
+{
+    HalFile *file;
+    char fileName[32];
+    bool binary;
+    uint16_t blockSeq;
+    size_t fileSize; // Bytes already handed to LittleFS
+    size_t fill;     // Bytes waiting in buf
+    uint32_t lastCommitMs;
+    uint8_t buf[LOG_FLASH_BLOCK_SIZE];
+};
+static RecordingSession session;
+static volatile bool closeRequested = false;
+static volatile bool commitRequested = false;
+static volatile uint32_t commitIntervalMs = LOG_COMMIT_INTERVAL_MS;
+
+// Set by recovery: the resumed binary file continues its block sequence
+static char resumeFileName[32] = "";
+static uint16_t resumeBlockSeq = 0;
+
+struct LogSessionMarker
+{
+    uint32_t magic;
+    int32_t logIndex;
+    char fileName[32];
+    uint32_t crc;
+};
+
+bool isBinaryLogName(const char *fileName)
+{
+    size_t len = strlen(fileName);
+    return len > 4 && strcmp(fileName + len - 4, ".hlg") == 0;
+}
+
+static void sessionWrite(const uint8_t *data, size_t len)
+{
+    halFileAppend(session.file, data, len);
+    session.fileSize += len;
+
+    halLock();
+    stats.flashBytesWritten += len;
+    stats.flashWrites++;
+    halUnlock();
+}
+
+static void sessionAppend(const uint8_t *data, size_t len)
+{
+    while (len > 0)
+    {
+        // Fill up to the next flash block boundary of the file
+        size_t room = LOG_FLASH_BLOCK_SIZE - ((session.fileSize + session.fill) % LOG_FLASH_BLOCK_SIZE);
+        if (room > LOG_FLASH_BLOCK_SIZE - session.fill)
+            room = LOG_FLASH_BLOCK_SIZE - session.fill;
+        size_t n = len < room ? len : room;
+
+        memcpy(session.buf + session.fill, data, n);
+        session.fill += n;
+        data += n;
+        len -= n;
+
+        if ((session.fileSize + session.fill) % LOG_FLASH_BLOCK_SIZE == 0)
+        {
+            sessionWrite(session.buf, session.fill);
+            session.fill = 0;
+        }
+    }
+}
+
+static void sessionCommit()
+{
+    if (!session.file)
+        return;
+
+    if (session.fill > 0)
+    {
+        sessionWrite(session.buf, session.fill);
+        session.fill = 0;
+    }
+    halFileSync(session.file);
+    committedSeq = writtenSeq;
+    session.lastCommitMs = halMillis();
+    if (hooks.save)
+        hooks.save(false);
+
+    halLock();
+    stats.commits++;
+    halUnlock();
+}
+
+static void sessionClose()
+{
+    if (!session.file)
+        return;
+    sessionCommit();
+    halFileClose(session.file);
+    session.file = nullptr;
+    session.fileName[0] = '\0';
+    if (hooks.save)
+        hooks.save(true);
+}
+
+static bool sessionOpen(const char *fileName)
+{
+    if (session.file && strcmp(session.fileName, fileName) == 0)
+        return true;
+
+    sessionClose();
+
+    session.file = halFileOpenAppend(fileName);
+    if (!session.file)
+        return false;
+
+    snprintf(session.fileName, sizeof(session.fileName), "%s", fileName);
+    session.binary = isBinaryLogName(fileName);
+    session.blockSeq = strcmp(fileName, resumeFileName) == 0 ? resumeBlockSeq : 0;
+    resumeFileName[0] = '\0';
+    session.fileSize = halFileLength(session.file);
+    session.fill = 0;
+    session.lastCommitMs = halMillis();
+    return true;
+}
+
+static void appendCsv(const LogData *samples, int count)
+{
+    if (session.fileSize + session.fill == 0)
+    {
+        sessionAppend((const uint8_t *)LOG_CSV_HEADER, strlen(LOG_CSV_HEADER));
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        char lineBuf[128];
+        int len = logCsvFormatLine(lineBuf, sizeof(lineBuf), samples[i]);
+        sessionAppend((const uint8_t *)lineBuf, len);
+    }
+}
+
+static void appendBinary(const LogData *samples, int count)
+{
+    uint8_t block[LOG_BIN_BLOCK_MAX_SIZE];
+
+    if (session.fileSize + session.fill == 0)
+    {
+        int sessionId = 0;
+        sscanf(session.fileName, "/log_%d", &sessionId);
+        size_t len = logBinEncodeHeader(block, samples[0].timestamp, sessionId);
+        sessionAppend(block, len);
+    }
+
+    for (int i = 0; i < count; i += LOG_BIN_BLOCK_MAX_RECORDS)
+    {
+        int n = count - i;
+        if (n > LOG_BIN_BLOCK_MAX_RECORDS)
+            n = LOG_BIN_BLOCK_MAX_RECORDS;
+        size_t len = logBinEncodeBlock(block, sizeof(block), session.blockSeq++, samples + i, n);
+        sessionAppend(block, len);
+    }
+}
+
+uint32_t logWriterRun()
+{
+    int buf = pendingBuf;
+    if (buf >= 0)
+    {
+        uint32_t startUs = halMicros();
+        uint32_t latencyUs = startUs - pendingSinceUs;
+
+        if (sessionOpen(pendingFileName))
+        {
+            if (session.binary)
+                appendBinary(logBuffers[buf], pendingCount);
+            else
+                appendCsv(logBuffers[buf], pendingCount);
+            if (hooks.record)
+                hooks.record(session.fileName, logBuffers[buf], pendingCount, session.fileSize + session.fill);
+            writtenSeq = pendingSeq;
+        }
+
+        uint32_t writeMs = (halMicros() - startUs) / 1000;
+
+        halLock();
+        stats.buffersWritten++;
+        stats.samplesWritten += pendingCount;
+        stats.lastSwapLatencyUs = latencyUs;
+        if (latencyUs > stats.maxSwapLatencyUs)
+            stats.maxSwapLatencyUs = latencyUs;
+        stats.lastWriteMs = writeMs;
+        if (writeMs > stats.maxWriteMs)
+            stats.maxWriteMs = writeMs;
+        memcpy(stats.sessionFile, session.fileName, sizeof(stats.sessionFile));
+        stats.sessionBytes = session.fileSize + session.fill;
+        halUnlock();
+    }
+
+    if ((buf >= 0 && pendingSync) || commitRequested)
+    {
+        // Power-safe batch / explicit commit: make it durable right away
+        sessionCommit();
+        commitRequested = false;
+    }
+
+    if (closeRequested)
+    {
+        sessionClose();
+        closeRequested = false;
+    }
+    else if (session.file && halMillis() - session.lastCommitMs >= commitIntervalMs)
+    {
+        sessionCommit();
+    }
+
+    // Release the buffer back to the producer
+    if (buf >= 0)
+        pendingBuf = -1;
+
+    // Sleep until woken, or until the next commit is due
+    if (!session.file)
+        return 0;
+    uint32_t sinceCommit = halMillis() - session.lastCommitMs;
+    return sinceCommit < commitIntervalMs ? commitIntervalMs - sinceCommit : 1;
+}
+
+// Swap buffers. Only called from the producer side. Fails if the writer
+// still owns the other buffer.
+static bool handOff()
+{
+    if (activeHead == 0)
+        return true;
+    if (pendingBuf >= 0 || !writerStarted)
+        return false;
+
+    pendingCount = activeHead;
+    snprintf(pendingFileName, sizeof(pendingFileName), "%s", currentLogFileName);
+    pendingSinceUs = halMicros();
+    pendingSeq = pushedSeq;
+    pendingSync = syncBatch > 0 || commitOnHandOff;
+    commitOnHandOff = false;
+    pendingBuf = activeBuf;
+
+    activeBuf ^= 1;
+    activeHead = 0;
+
+    logWriterWake();
+    return true;
+}
+
+static bool waitIdle(uint32_t timeoutMs)
+{
+    uint32_t start = halMillis();
+    while (pendingBuf >= 0)
+    {
+        if (halMillis() - start > timeoutMs)
+            return false;
+        halDelay(5);
+    }
+    return true;
+}
+
+void initLogWriter()
+{
+    if (writerStarted)
+        return;
+    writerStarted = true;
+    logWriterStartTask();
+}
+
+void logWriterSetIndex(const LogWriterIndex &index)
+{
+    hooks = index;
+}
+
+bool logWriterPush(const LogData &sample)
+{
+    if (activeHead >= LOG_BUFFER_SIZE && !handOff())
+    {
+        halLock();
+        stats.droppedSamples++;
+        halUnlock();
+        return false;
+    }
+
+    logBuffers[activeBuf][activeHead++] = sample;
+    pushedSeq++;
+
+    int batch = syncBatch;
+    if (activeHead >= LOG_BUFFER_SIZE || (batch > 0 && activeHead >= batch))
+        handOff();
+    return true;
+}
+
+void logWriterFlush(bool wait)
+{
+    if (wait)
+        waitIdle(LOG_FLUSH_WAIT_MS);
+
+    // If the writer is still busy the samples simply stay in the active
+    // buffer and go out with the next handoff.
+    handOff();
+
+    if (wait)
+        waitIdle(LOG_FLUSH_WAIT_MS);
+}
+
+// Flush, then raise a request flag for the writer and wait for it to clear
+static void flushAndRequest(volatile bool &request)
+{
+    logWriterFlush(true);
+    if (!writerStarted)
+        return;
+
+    request = true;
+    logWriterWake();
+
+    uint32_t start = halMillis();
+    while (request && halMillis() - start < LOG_FLUSH_WAIT_MS)
+        halDelay(5);
+}
+
+void logWriterCommit()
+{
+    flushAndRequest(commitRequested);
+}
+
+void logWriterRequestCommit()
+{
+    if (!writerStarted)
+        return;
+
+    if (activeHead > 0)
+    {
+        // If the writer still owns the other buffer the request rides on
+        // whichever handoff comes next
+        commitOnHandOff = true;
+        handOff();
+        return;
+    }
+    commitRequested = true;
+    logWriterWake();
+}
+
+void logWriterClose()
+{
+    flushAndRequest(closeRequested);
+}
+
+void logWriterSetCommitInterval(uint32_t intervalMs)
+{
+    commitIntervalMs = intervalMs;
+}
+
+void logWriterSetSyncBatch(int samples)
+{
+    syncBatch = samples < LOG_BUFFER_SIZE ? samples : LOG_BUFFER_SIZE;
+}
+
+void logWriterReset()
+{
+    activeHead = 0;
+}
+
+int logWriterPending()
+{
+    return activeHead;
+}
+
+bool isLogWriterBusy()
+{
+    return pendingBuf >= 0;
+}
+
+uint32_t logWriterPushedSeq()
+{
+    return pushedSeq;
+}
+
+uint32_t logWriterCommittedSeq()
+{
+    return committedSeq;
+}
+
+LogWriterStats getLogWriterStats()
+{
+    halLock();
+    LogWriterStats copy = stats;
+    halUnlock();
+    return copy;
+}
+
+// --- SESSION MARKER + RECOVERY ---
+
+void logSessionBegin(const char *fileName, int logIndex)
+{
+    LogSessionMarker marker;
+    memset(&marker, 0, sizeof(marker));
+    marker.magic = LOG_SESSION_MAGIC;
+    marker.logIndex = logIndex;
+    snprintf(marker.fileName, sizeof(marker.fileName), "%s", fileName);
+    marker.crc = logCrc32((const uint8_t *)&marker, offsetof(LogSessionMarker, crc));
+
+    halFileWrite(LOG_SESSION_FILE, (const uint8_t *)&marker, sizeof(marker), false);
+}
+
+void logSessionEnd()
+{
+    halFileRemove(LOG_SESSION_FILE);
+}
+
+// Length of the CSV file up to and including its last complete line
+static size_t validCsvLength(const char *fileName, size_t size)
+{
+    size_t end = size;
+    uint8_t chunk[128];
+
+    while (end > 0)
+    {
+        size_t start = end > sizeof(chunk) ? end - sizeof(chunk) : 0;
+        size_t n = halFileRead(fileName, start, chunk, end - start);
+        for (size_t i = n; i > 0; i--)
+        {
+            if (chunk[i - 1] == '\n')
+                return start + i;
+        }
+        end = start;
+    }
+    return 0;
+}
+
+// Length of the binary file up to the end of its last block with a good CRC.
+// nextSeq is the block sequence number to continue with.
+static size_t validBinaryLength(const char *fileName, size_t size, uint16_t &nextSeq)
+{
+    uint8_t block[LOG_BIN_BLOCK_MAX_SIZE];
+    LogData records[LOG_BIN_BLOCK_MAX_RECORDS];
+
+    nextSeq = 0;
+    if (size < LOG_BIN_HEADER_SIZE)
+        return 0;
+
+    LogBinHeader hdr;
+    if (halFileRead(fileName, 0, block, LOG_BIN_HEADER_SIZE) != LOG_BIN_HEADER_SIZE ||
+        !logBinDecodeHeader(block, LOG_BIN_HEADER_SIZE, hdr))
+        return 0;
+
+    size_t offset = LOG_BIN_HEADER_SIZE;
+    while (offset + LOG_BIN_BLOCK_HEADER_SIZE <= size)
+    {
+        size_t n = halFileRead(fileName, offset, block, sizeof(block));
+        size_t consumed = 0;
+        uint16_t seq = 0;
+        if (logBinDecodeBlock(block, n, records, LOG_BIN_BLOCK_MAX_RECORDS, consumed, &seq) < 0)
+            break;
+        offset += consumed;
+        nextSeq = seq + 1;
+    }
+    return offset;
+}
+
+LogRecovery recoverLogSession(int expectedIndex, char *fileName, size_t len)
+{
+    LogSessionMarker marker;
+    if (halFileSize(LOG_SESSION_FILE) < 0)
+        return LOG_RECOVER_NONE;
+
+    bool valid = halFileRead(LOG_SESSION_FILE, 0, (uint8_t *)&marker, sizeof(marker)) == sizeof(marker) &&
+                 marker.magic == LOG_SESSION_MAGIC &&
+                 marker.crc == logCrc32((const uint8_t *)&marker, offsetof(LogSessionMarker, crc));
+
+    // The marker must describe the most recently started recording
+    long size = valid ? halFileSize(marker.fileName) : -1;
+    if (!valid || marker.logIndex != expectedIndex || size < 0)
+    {
+        logSessionEnd();
+        return LOG_RECOVER_NONE;
+    }
+
+    uint16_t nextSeq = 0;
+    size_t validLen = isBinaryLogName(marker.fileName) ? validBinaryLength(marker.fileName, size, nextSeq)
+                                                       : validCsvLength(marker.fileName, size);
+    if (hooks.setSize)
+        hooks.setSize(marker.fileName, validLen);
+
+    if (validLen < (size_t)size && !halFileTruncate(marker.fileName, validLen))
+    {
+        // Appending after the torn tail would bury it mid-file: the index
+        // ends this segment at validLen and recording moves on to a new one
+        logSessionEnd();
+        return LOG_RECOVER_NEW_SEGMENT;
+    }
+
+    snprintf(resumeFileName, sizeof(resumeFileName), "%s", marker.fileName);
+    resumeBlockSeq = nextSeq;
+    snprintf(fileName, len, "%s", marker.fileName);
+    return LOG_RECOVER_RESUME;
+}
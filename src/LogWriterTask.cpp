@@ -0,0 +1,38 @@
+#include "LogWriter.h"
+#include "TaskMonitor.h"
+#include "Profiler.h"
+#include <Arduino.h>
+
+#define LOG_WRITER_STACK 6144
+#define LOG_WRITER_PRIORITY 1
+
+static TaskHandle_t writerTask = nullptr;
+
+static void logWriterTask(void *param)
+{
+    taskMonitorRegister(TASK_SLOT_LOG_WRITER, "logWriter");
+
+    uint32_t sleepMs = 0;
+    for (;;)
+    {
+        // Wake up on new buffers, or on the commit cadence while a session is open
+        ulTaskNotifyTake(pdTRUE, sleepMs ? pdMS_TO_TICKS(sleepMs) : portMAX_DELAY);
+        taskMonitorBegin(TASK_SLOT_LOG_WRITER);
+        {
+            PROFILE_SCOPE(PROF_LOG);
+            sleepMs = logWriterRun();
+        }
+        taskMonitorEnd(TASK_SLOT_LOG_WRITER);
+    }
+}
+
+void logWriterStartTask()
+{
+    xTaskCreate(logWriterTask, "logWriter", LOG_WRITER_STACK, nullptr, LOG_WRITER_PRIORITY, &writerTask);
+}
+
+void logWriterWake()
+{
+    if (writerTask)
+        xTaskNotifyGive(writerTask);
+}
@@ -0,0 +1,166 @@
+#include "PowerManager.h"
+#include <esp_pm.h>
+#include <esp_timer.h>
+
+// Light sleep is only left to the idle task when it can be accounted for
+#if defined(CONFIG_FREERTOS_USE_TICKLESS_IDLE) && defined(CONFIG_PM_LIGHT_SLEEP_CALLBACKS)
+#define POWER_TICKLESS 1
+#else
+#define POWER_TICKLESS 0
+#endif
+
+static SemaphoreHandle_t loopEvent = nullptr;
+static esp_pm_lock_handle_t awakeLock = nullptr;
+static bool awakeHeld = false;
+
+static PowerResidency residency;
+static portMUX_TYPE residencyMux = portMUX_INITIALIZER_UNLOCKED;
+static int64_t markUs = 0;
+static uint64_t lightSinceMarkUs = 0;
+static uint64_t activeUs = 0;
+static uint64_t modemSleepUs = 0;
+static uint64_t lightSleepUs = 0;
+static bool radioActive = false;
+
+// Moves the awake time since the last mark into the current radio state
+static void settle(int64_t nowUs)
+{
+    int64_t awakeUs = nowUs - markUs - (int64_t)lightSinceMarkUs;
+    if (awakeUs > 0)
+    {
+        if (radioActive)
+            activeUs += awakeUs;
+        else
+            modemSleepUs += awakeUs;
+    }
+    markUs = nowUs;
+    lightSinceMarkUs = 0;
+}
+
+#if POWER_TICKLESS
+static esp_err_t onLightSleepExit(int64_t sleptUs, void *arg)
+{
+    powerNoteLightSleep(sleptUs);
+    return ESP_OK;
+}
+#endif
+
+void initPower()
+{
+    if (!loopEvent)
+        loopEvent = xSemaphoreCreateBinary();
+    markUs = esp_timer_get_time();
+
+#if ESP_IDF_VERSION_MAJOR >= 5
+    esp_pm_config_t pmConfig = {};
+#else
+    esp_pm_config_esp32s3_t pmConfig = {};
+#endif
+    pmConfig.max_freq_mhz = POWER_MAX_CPU_MHZ;
+    pmConfig.min_freq_mhz = POWER_MIN_CPU_MHZ;
+    pmConfig.light_sleep_enable = POWER_TICKLESS;
+
+    // Fails with ESP_ERR_NOT_SUPPORTED when the SDK is built without
+    // CONFIG_PM_ENABLE; the CPU then stays at the frequency setup() chose
+    if (esp_pm_configure(&pmConfig) != ESP_OK)
+        return;
+
+    residency.dfs = true;
+    residency.minMhz = POWER_MIN_CPU_MHZ;
+    residency.maxMhz = POWER_MAX_CPU_MHZ;
+
+#if POWER_TICKLESS
+    esp_pm_sleep_cbs_register_config_t cbs = {};
+    cbs.exit_cb = onLightSleepExit;
+    if (esp_pm_light_sleep_register_cbs(&cbs) == ESP_OK &&
+        esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "loop", &awakeLock) == ESP_OK)
+    {
+        residency.autoLightSleep = true;
+    }
+    else
+    {
+        // Can't account for it, so don't let the idle task sleep at all
+        pmConfig.light_sleep_enable = false;
+        esp_pm_configure(&pmConfig);
+    }
+#endif
+}
+
+bool powerAutoLightSleep()
+{
+    return residency.autoLightSleep;
+}
+
+void powerHoldAwake(bool hold)
+{
+    if (!awakeLock || hold == awakeHeld)
+        return;
+    if (hold)
+        esp_pm_lock_acquire(awakeLock);
+    else
+        esp_pm_lock_release(awakeLock);
+    awakeHeld = hold;
+}
+
+void powerSignalLoop()
+{
+    if (loopEvent)
+        xSemaphoreGive(loopEvent);
+}
+
+void IRAM_ATTR powerSignalLoopFromISR()
+{
+    if (!loopEvent)
+        return;
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(loopEvent, &woken);
+    if (woken)
+        portYIELD_FROM_ISR();
+}
+
+void powerWaitLoop(uint32_t timeoutMs)
+{
+    if (timeoutMs > POWER_MAX_WAIT_MS)
+        timeoutMs = POWER_MAX_WAIT_MS;
+
+    // Always give up the CPU for at least a tick so lower-priority tasks run
+    TickType_t ticks = pdMS_TO_TICKS(timeoutMs);
+    if (ticks == 0)
+        ticks = 1;
+    if (loopEvent)
+        xSemaphoreTake(loopEvent, ticks);
+    else
+        vTaskDelay(ticks);
+}
+
+void powerSetRadioActive(bool on)
+{
+    portENTER_CRITICAL(&residencyMux);
+    if (on != radioActive)
+    {
+        settle(esp_timer_get_time());
+        radioActive = on;
+    }
+    portEXIT_CRITICAL(&residencyMux);
+}
+
+void powerNoteLightSleep(uint64_t sleptUs)
+{
+    portENTER_CRITICAL_SAFE(&residencyMux);
+    lightSleepUs += sleptUs;
+    lightSinceMarkUs += sleptUs;
+    residency.lightSleeps++;
+    portEXIT_CRITICAL_SAFE(&residencyMux);
+}
+
+PowerResidency getPowerResidency()
+{
+    portENTER_CRITICAL(&residencyMux);
+    settle(esp_timer_get_time());
+    PowerResidency r = residency;
+    r.activeMs = activeUs / 1000;
+    r.modemSleepMs = modemSleepUs / 1000;
+    r.lightSleepMs = lightSleepUs / 1000;
+    portEXIT_CRITICAL(&residencyMux);
+    return r;
+}
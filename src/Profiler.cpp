@@ -0,0 +1,48 @@
+#include "Profiler.h"
+
+#if PROFILER_ENABLED
+
+static const char *const slotNames[PROF_SLOT_COUNT] = {
+    "bsec", "display", "log", "web", "ble", "touch"};
+
+// Slots are recorded from the loop, the sensor task and the log writer
+static Histogram slots[PROF_SLOT_COUNT];
+static portMUX_TYPE profileMux = portMUX_INITIALIZER_UNLOCKED;
+
+void profileRecord(ProfileSlot slot, uint32_t cycles)
+{
+    portENTER_CRITICAL(&profileMux);
+    slots[slot].add(cycles);
+    portEXIT_CRITICAL(&profileMux);
+}
+
+ProfileStats getProfileStats(ProfileSlot slot)
+{
+    ProfileStats s;
+    portENTER_CRITICAL(&profileMux);
+    s.cycles = slots[slot];
+    portEXIT_CRITICAL(&profileMux);
+
+    uint32_t mhz = getCpuFrequencyMhz();
+    if (!mhz)
+        mhz = 1;
+    s.name = slotNames[slot];
+    s.calls = s.cycles.count;
+    s.totalUs = s.cycles.total / mhz;
+    s.maxUs = s.cycles.max / mhz;
+    s.meanUs = s.cycles.mean() / mhz;
+    s.p50Us = s.cycles.percentile(50) / mhz;
+    s.p90Us = s.cycles.percentile(90) / mhz;
+    s.p99Us = s.cycles.percentile(99) / mhz;
+    return s;
+}
+
+void resetProfileStats()
+{
+    portENTER_CRITICAL(&profileMux);
+    for (int i = 0; i < PROF_SLOT_COUNT; i++)
+        slots[i].reset();
+    portEXIT_CRITICAL(&profileMux);
+}
+
+#endif
@@ -0,0 +1,533 @@
+#include "SensorTask.h"
+#include "I2CBus.h"
+#include "LogWriter.h"
+#include "LogStaging.h"
+#include "LogStorage.h"
+#include "LogManifest.h"
+#include "TaskMonitor.h"
+#include "PowerManager.h"
+#include "Profiler.h"
+#include "Hal.h"
+#include "Battery.h"
+#include "LogReplay.h"
+#include <bsec2.h>
+#include <LittleFS.h>
+#include <esp_task_wdt.h>
+
+#define SENSOR_TASK_STACK 8192
+#define SENSOR_TASK_PRIORITY 2 // Above the Arduino loop and the log writer
+#define SENSOR_POLL_MS 10      // How often BSEC is polled around a measurement
+#define SENSOR_SETTLE_MS 500   // Keep polling this long after the last sensor I/O
+#define SENSOR_MAX_WAIT_MS 5000 // Longest block between cycles (task watchdog)
+#define SENSOR_READINGS_DEPTH 8
+#define SENSOR_COMMAND_DEPTH 4
+#define SENSOR_COMMAND_WAIT_MS 100 // Queue-full wait for sensorSend()
+
+#define STATE_SAVE_PERIOD 1800000
+
+#define BSEC_STATE_FILE "/bsec_state.bin"
+
+static Bsec2 envSensor;
+static uint8_t envSensorAddr = BME68X_I2C_ADDR_LOW; // intfPtr for the I2CBus callbacks
+static uint8_t bsecState[BSEC_MAX_STATE_BLOB_SIZE];
+
+static TaskHandle_t sensorTaskHandle = nullptr;
+static QueueHandle_t readingsQueue = nullptr;
+static QueueHandle_t commandQueue = nullptr;
+
+// Latest outputs, owned by the task
+static SensorReadings latest;
+
+// Bsec2::begin() callbacks on the shared bus. intfPtr points at the
+// sensor's 7-bit address.
+static BME68X_INTF_RET_TYPE bsecRead(uint8_t regAddr, uint8_t *regData, uint32_t length, void *intfPtr)
+{
+    return i2cSensorReadRegs(*(uint8_t *)intfPtr, regAddr, regData, length) ? BME68X_INTF_RET_SUCCESS : BME68X_E_COM_FAIL;
+}
+
+static BME68X_INTF_RET_TYPE bsecWrite(uint8_t regAddr, const uint8_t *regData, uint32_t length, void *intfPtr)
+{
+    return i2cSensorWriteRegs(*(uint8_t *)intfPtr, regAddr, regData, length) ? BME68X_INTF_RET_SUCCESS : BME68X_E_COM_FAIL;
+}
+
+// Measurement waits sleep without holding the bus
+static void bsecDelay(uint32_t periodUs, void *intfPtr)
+{
+    (void)intfPtr;
+    if (periodUs >= 1000)
+        delay(periodUs / 1000);
+    delayMicroseconds(periodUs % 1000);
+}
+
+// Demo mode playback, owned by the task
+static LogReplay replay;
+
+static SensorStatus status;
+static volatile uint32_t samplePeriodMs = 3000; // From the subscribed rate
+static portMUX_TYPE statusMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Opens the next /log_NNN file, for a new recording or the next segment
+static void startLogFile()
+{
+    // Make room for a full segment before starting it
+    logStorageEnforceQuota(LOG_SEGMENT_SIZE);
+
+    // Generate filename
+    char buf[32];
+    if (sysConfig.logFormat == LOG_FORMAT_BIN)
+        sprintf(buf, "/log_%03d.hlg", sysConfig.nextLogIndex);
+    else
+        sprintf(buf, "/log_%03d.csv", sysConfig.nextLogIndex);
+    snprintf(currentLogFileName, sizeof(currentLogFileName), "%s", buf);
+    publishRecordingState();
+
+    sysConfig.nextLogIndex++;
+    saveConfig(); // Save next index
+
+    logSessionBegin(currentLogFileName, sysConfig.nextLogIndex - 1);
+    logManifestAdd(currentLogFileName);
+}
+
+// Sampled with every reading, so it follows the BSEC rate in every mode
+static void readBattery(SensorReadings &r)
+{
+    r.voltage = halBatteryMilliVolts() / 1000.0f;
+    r.batteryPercent = batteryPercent(r.voltage);
+}
+
+static void logSample(const SensorReadings &r)
+{
+    LogData sample;
+    sample.timestamp = millis();
+    sample.iaq = r.iaq;
+    sample.co2 = r.co2;
+    sample.temp = r.temp;
+    sample.hum = r.hum;
+
+    // Roll over to a new segment once the current file is full
+    if (logStorageSegmentFull())
+    {
+        logStageDrain();
+        logWriterFlush(true);
+        startLogFile();
+    }
+
+    if (sysConfig.opMode == MODE_ECO)
+    {
+        // Stage in RTC memory; flash is only touched when nearly full
+        if (logStagePush(sample, sysConfig.nextLogIndex - 1))
+            logStageDrain();
+    }
+    else
+    {
+        // Keep ordering when leaving ECO mode with samples still staged
+        logStageDrain();
+
+        // Buffers are handed to the writer task automatically when full or
+        // when a power-safe batch is complete
+        logWriterPush(sample);
+    }
+}
+
+// Everything downstream of a new reading, live or replayed
+static void publishReading(SensorReadings &r)
+{
+    readBattery(r);
+
+    if (isRecording)
+        logSample(r);
+
+    // Latest-value readers take a snapshot; the queue delivers every sample.
+    // The sensor task is the only writer, so this is the snapshot's seq.
+    r.seq = currentReadings.sequence() + 1;
+    currentReadings.write(r);
+    bool dropped = xQueueSend(readingsQueue, &r, 0) != pdTRUE;
+    powerSignalLoop();
+
+    if (dropped)
+    {
+        portENTER_CRITICAL(&statusMux);
+        status.droppedReadings++;
+        portEXIT_CRITICAL(&statusMux);
+    }
+}
+
+static void newDataCallback(const bme68xData data, const bsecOutputs outputs, Bsec2 capture)
+{
+    if (!outputs.nOutputs)
+        return;
+
+    for (uint8_t i = 0; i < outputs.nOutputs; i++)
+    {
+        const bsecData output = outputs.output[i];
+        switch (output.sensor_id)
+        {
+        case BSEC_OUTPUT_RAW_TEMPERATURE:
+            latest.temp = output.signal;
+            break;
+        case BSEC_OUTPUT_RAW_PRESSURE:
+            latest.press = output.signal;
+            break;
+        case BSEC_OUTPUT_RAW_HUMIDITY:
+            latest.hum = output.signal;
+            break;
+        case BSEC_OUTPUT_IAQ:
+            latest.iaq = output.signal;
+            latest.accuracy = output.accuracy;
+            break;
+        case BSEC_OUTPUT_CO2_EQUIVALENT:
+            latest.co2 = output.signal;
+            break;
+        }
+    }
+
+    portENTER_CRITICAL(&statusMux);
+    status.lastRunMs = millis();
+    if (status.isSaving && !status.stateLoaded)
+        status.stateLoaded = true;
+    portEXIT_CRITICAL(&statusMux);
+
+    // Demo mode: BSEC keeps running, the replay feeds the pipeline
+    if (replay.active)
+        return;
+    publishReading(latest);
+}
+
+static void loadBsecState()
+{
+    if (LittleFS.exists(BSEC_STATE_FILE))
+    {
+        File file = LittleFS.open(BSEC_STATE_FILE, "r");
+        if (file)
+        {
+            if (file.size() < BSEC_MAX_STATE_BLOB_SIZE)
+            {
+                file.close();
+                LittleFS.remove(BSEC_STATE_FILE);
+                return;
+            }
+            file.read(bsecState, BSEC_MAX_STATE_BLOB_SIZE);
+            file.close();
+            if (envSensor.setState(bsecState))
+            {
+                status.stateLoaded = true;
+                status.lastStateSaveMs = millis();
+            }
+            else
+            {
+                LittleFS.remove(BSEC_STATE_FILE);
+            }
+        }
+    }
+}
+
+static void setSaving(bool saving)
+{
+    portENTER_CRITICAL(&statusMux);
+    status.isSaving = saving;
+    if (saving)
+    {
+        status.stateLoaded = true;
+        status.hasSavedSinceBoot = true;
+    }
+    portEXIT_CRITICAL(&statusMux);
+}
+
+static bool updateBsecState(bool force)
+{
+    bool success = false;
+
+    if (force || (millis() - status.lastStateSaveMs > STATE_SAVE_PERIOD))
+    {
+        if (latest.accuracy >= 1)
+        {
+            if (envSensor.getState(bsecState))
+            {
+                File file = LittleFS.open(BSEC_STATE_FILE, "w");
+                if (file)
+                {
+                    file.write(bsecState, BSEC_MAX_STATE_BLOB_SIZE);
+                    file.close();
+                    setSaving(true);
+                    success = true;
+                }
+            }
+        }
+        if (success || !force)
+        {
+            portENTER_CRITICAL(&statusMux);
+            status.lastStateSaveMs = millis();
+            portEXIT_CRITICAL(&statusMux);
+        }
+        if (status.isSaving)
+        {
+            delay(100);
+            setSaving(false);
+        }
+    }
+    return success;
+}
+
+static void setRate(float sampleRate)
+{
+    bsecSensor allSensors[] = {
+        BSEC_OUTPUT_IAQ, BSEC_OUTPUT_CO2_EQUIVALENT,
+        BSEC_OUTPUT_RAW_TEMPERATURE, BSEC_OUTPUT_RAW_PRESSURE,
+        BSEC_OUTPUT_RAW_HUMIDITY};
+    envSensor.updateSubscription(allSensors, ARRAY_LEN(allSensors), sampleRate);
+    samplePeriodMs = (uint32_t)(1000.0f / sampleRate);
+}
+
+static void updateReplayStatus()
+{
+    portENTER_CRITICAL(&statusMux);
+    status.replaying = replay.active;
+    status.replaySamples = replay.samples;
+    status.replayDueMs = logReplayDueMs(replay);
+    memcpy(status.replayFile, replay.path, sizeof(status.replayFile));
+    portEXIT_CRITICAL(&statusMux);
+}
+
+// Newest recording in the manifest other than the one being written
+static bool newestRecording(char *fileName, size_t len)
+{
+    LogManifestEntry entry;
+    int32_t best = -1;
+    for (int i = 0; logManifestGet(i, entry); i++)
+    {
+        char name[32];
+        logManifestFileName(entry, name, sizeof(name));
+        if (entry.samples == 0 || entry.index <= best || strcmp(name, currentLogFileName) == 0)
+            continue;
+        best = entry.index;
+        snprintf(fileName, len, "%s", name);
+    }
+    return best >= 0;
+}
+
+static bool startReplay(const SensorCommand &cmd)
+{
+    char fileName[32];
+    if (cmd.fileName[0])
+        snprintf(fileName, sizeof(fileName), "%s", cmd.fileName);
+    else if (!newestRecording(fileName, sizeof(fileName)))
+        return false;
+
+    float speed = cmd.sampleRate;
+    if (speed < 1.0f)
+        speed = 1.0f;
+    if (speed > SENSOR_REPLAY_MAX_SPEED)
+        speed = SENSOR_REPLAY_MAX_SPEED;
+
+    bool ok = logReplayOpen(replay, fileName, speed, true, millis());
+    updateReplayStatus();
+    return ok;
+}
+
+// Publish the replayed samples that are due, a few per pass so a fast
+// playback can't starve BSEC or overrun the readings queue
+static void serviceReplay()
+{
+    if (!replay.active)
+        return;
+
+    LogData sample;
+    for (int i = 0; i < SENSOR_REPLAY_BURST && logReplayNext(replay, millis(), sample); i++)
+    {
+        // Pressure, accuracy and battery aren't recorded; keep them live
+        SensorReadings r = latest;
+        logReplayApply(sample, r);
+        publishReading(r);
+    }
+    updateReplayStatus();
+}
+
+static bool handleCommand(const SensorCommand &cmd)
+{
+    switch (cmd.type)
+    {
+    case SENSOR_CMD_SET_RATE:
+        setRate(cmd.sampleRate);
+        return true;
+    case SENSOR_CMD_SAVE_STATE:
+        return updateBsecState(true);
+    case SENSOR_CMD_RECORD_START:
+        if (isRecording)
+            return true;
+        startLogFile();
+        isRecording = true;
+        publishRecordingState();
+        logWriterReset(); // Reset buffer
+        logStageDrain();  // Staged for a recording recovery couldn't resume
+        return true;
+    case SENSOR_CMD_RECORD_STOP:
+        if (!isRecording)
+            return true;
+        logStageDrain();
+        logWriterClose(); // Flush remaining data and close the file
+        logStageDrain();  // Releases the staged samples the close committed
+        logSessionEnd();
+        isRecording = false;
+        currentLogFileName[0] = '\0';
+        publishRecordingState();
+        return true;
+    case SENSOR_CMD_REPLAY_START:
+        return startReplay(cmd);
+    case SENSOR_CMD_REPLAY_STOP:
+        logReplayClose(replay);
+        updateReplayStatus();
+        return true;
+    }
+    return false;
+}
+
+// How long to block before polling BSEC again. Between cycles the task
+// sleeps until BSEC's next call so the idle task can scale down or sleep;
+// around a measurement, or before the schedule is known, it polls.
+static TickType_t nextPollTicks()
+{
+    uint32_t now = millis();
+    uint32_t dueMs;
+    int32_t untilMs;
+    if (!i2cBusNextSensorCycle(dueMs) || now - i2cBusLastSensorIoMs() < SENSOR_SETTLE_MS)
+        untilMs = SENSOR_POLL_MS;
+    else
+        untilMs = (int32_t)(dueMs - now);
+
+    // Demo mode: also wake for the next replayed sample
+    if (replay.active)
+    {
+        int32_t replayMs = (int32_t)(logReplayDueMs(replay) - now);
+        if (replayMs < untilMs)
+            untilMs = replayMs;
+    }
+
+    if (untilMs < SENSOR_POLL_MS)
+        untilMs = SENSOR_POLL_MS;
+    if (untilMs > SENSOR_MAX_WAIT_MS)
+        untilMs = SENSOR_MAX_WAIT_MS;
+    return pdMS_TO_TICKS(untilMs);
+}
+
+static void sensorTask(void *param)
+{
+    esp_task_wdt_add(NULL);
+    taskMonitorRegister(TASK_SLOT_SENSOR, "sensor");
+
+    for (;;)
+    {
+        // Commands wake the task early; otherwise BSEC is polled and decides
+        // itself whether a measurement cycle is due
+        SensorCommand cmd;
+        bool hasCommand = xQueueReceive(commandQueue, &cmd, nextPollTicks()) == pdTRUE;
+
+        taskMonitorBegin(TASK_SLOT_SENSOR);
+        esp_task_wdt_reset();
+
+        if (hasCommand)
+        {
+            bool result = handleCommand(cmd);
+            if (cmd.replyTo)
+                xTaskNotify(cmd.replyTo, result ? 1 : 0, eSetValueWithOverwrite);
+        }
+
+        {
+            PROFILE_SCOPE(PROF_BSEC);
+            envSensor.run();
+        }
+        portENTER_CRITICAL(&statusMux);
+        status.bsecStatus = envSensor.status;
+        status.sensorStatus = envSensor.sensorStatus;
+        portEXIT_CRITICAL(&statusMux);
+
+        serviceReplay();
+        updateBsecState(false);
+        taskMonitorEnd(TASK_SLOT_SENSOR);
+    }
+}
+
+bool initSensorTask()
+{
+    if (sensorTaskHandle)
+        return true;
+
+    // Sensor traffic goes through the bus scheduler instead of Wire directly
+    bool ok = envSensor.begin(BME68X_I2C_INTF, bsecRead, bsecWrite, bsecDelay, &envSensorAddr);
+    if (!ok)
+    {
+        envSensorAddr = BME68X_I2C_ADDR_HIGH;
+        ok = envSensor.begin(BME68X_I2C_INTF, bsecRead, bsecWrite, bsecDelay, &envSensorAddr);
+    }
+    status.bsecStatus = envSensor.status;
+    status.sensorStatus = envSensor.sensorStatus;
+
+    loadBsecState();
+    envSensor.attachCallback(newDataCallback);
+    status.lastRunMs = millis();
+
+    readingsQueue = xQueueCreate(SENSOR_READINGS_DEPTH, sizeof(SensorReadings));
+    commandQueue = xQueueCreate(SENSOR_COMMAND_DEPTH, sizeof(SensorCommand));
+    xTaskCreatePinnedToCore(sensorTask, "sensor", SENSOR_TASK_STACK, nullptr, SENSOR_TASK_PRIORITY, &sensorTaskHandle, SENSOR_TASK_CORE);
+    return ok;
+}
+
+bool sensorSend(SensorCommandType type, float sampleRate)
+{
+    if (!commandQueue)
+        return false;
+    SensorCommand cmd = {type, sampleRate, nullptr};
+    return xQueueSend(commandQueue, &cmd, pdMS_TO_TICKS(SENSOR_COMMAND_WAIT_MS)) == pdTRUE;
+}
+
+bool sensorReplay(const char *fileName, float speed)
+{
+    if (!commandQueue)
+        return false;
+    SensorCommand cmd = {SENSOR_CMD_REPLAY_START, speed, nullptr};
+    snprintf(cmd.fileName, sizeof(cmd.fileName), "%s", fileName ? fileName : "");
+    return xQueueSend(commandQueue, &cmd, pdMS_TO_TICKS(SENSOR_COMMAND_WAIT_MS)) == pdTRUE;
+}
+
+bool sensorRequest(SensorCommandType type, uint32_t timeoutMs)
+{
+    if (!commandQueue)
+        return false;
+
+    // Clear a stale reply from an earlier request that timed out
+    xTaskNotifyWait(0, 0xFFFFFFFF, nullptr, 0);
+
+    SensorCommand cmd = {type, 0, xTaskGetCurrentTaskHandle()};
+    if (xQueueSend(commandQueue, &cmd, pdMS_TO_TICKS(timeoutMs)) != pdTRUE)
+        return false;
+
+    uint32_t result = 0;
+    if (xTaskNotifyWait(0, 0xFFFFFFFF, &result, pdMS_TO_TICKS(timeoutMs)) != pdTRUE)
+        return false;
+    return result != 0;
+}
+
+bool sensorReceive(SensorReadings &out)
+{
+    if (!readingsQueue)
+        return false;
+    return xQueueReceive(readingsQueue, &out, 0) == pdTRUE;
+}
+
+SensorStatus getSensorStatus()
+{
+    portENTER_CRITICAL(&statusMux);
+    SensorStatus s = status;
+    portEXIT_CRITICAL(&statusMux);
+    return s;
+}
+
+uint32_t sensorNextCallMs()
+{
+    SensorStatus s = getSensorStatus();
+    uint32_t atMs;
+    if (!i2cBusNextSensorCycle(atMs))
+        atMs = s.lastRunMs + samplePeriodMs;
+    if (s.replaying && (int32_t)(s.replayDueMs - atMs) < 0)
+        atMs = s.replayDueMs;
+    return atMs;
+}
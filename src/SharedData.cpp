@@ -1,8 +1,34 @@
 #include "SharedData.h"
+#include <stdio.h>
 
 // Global instances
-volatile SensorReadings currentData;
+Seqlock<SensorReadings> currentReadings;
 Stats sysStats;
 SystemConfig sysConfig;
 bool isRecording = false;
 char currentLogFileName[32] = "";
+static Seqlock<RecordingState> recordingState;
+
+SensorReadings readingsSnapshot(uint32_t *seq)
+{
+    SensorReadings r;
+    uint32_t n = currentReadings.read(r);
+    if (seq)
+        *seq = n;
+    return r;
+}
+
+void publishRecordingState()
+{
+    RecordingState s;
+    s.active = isRecording;
+    snprintf(s.fileName, sizeof(s.fileName), "%s", currentLogFileName);
+    recordingState.write(s);
+}
+
+RecordingState recordingSnapshot()
+{
+    RecordingState s;
+    recordingState.read(s);
+    return s;
+}
@@ -0,0 +1,98 @@
+#include "SseStream.h"
+#include "ApiJson.h"
+#include <string.h>
+
+static void dropClient(SseStream &s, int slot)
+{
+    s.link.close(slot);
+    s.open[slot] = false;
+    s.dropped++;
+}
+
+static void sendAll(SseStream &s, const char *msg, size_t len, uint32_t nowMs)
+{
+    for (int i = 0; i < SSE_MAX_CLIENTS; i++)
+    {
+        if (!s.open[i])
+            continue;
+        // A partial event would corrupt the stream, so a short write ends it
+        if (!s.link.connected(i) || s.link.write(i, (const uint8_t *)msg, len) != len)
+            dropClient(s, i);
+    }
+    s.lastWriteMs = nowMs;
+}
+
+void sseInit(SseStream &s, const SseLink &link, uint32_t nowMs)
+{
+    s = SseStream();
+    s.link = link;
+    s.lastWriteMs = nowMs;
+}
+
+int sseDataEvent(char *msg, size_t len, const SensorReadings &r, uint32_t seq,
+                 uint32_t uptimeMs, bool recording, const char *recFile)
+{
+    memcpy(msg, "data: ", 6);
+    int n = 6;
+    n += apiDataJson(msg + n, len - n - 2, r, seq, uptimeMs, recording, recFile);
+    msg[n++] = '\n';
+    msg[n++] = '\n';
+    return n;
+}
+
+int sseFreeSlot(SseStream &s)
+{
+    for (int i = 0; i < SSE_MAX_CLIENTS; i++)
+    {
+        if (!s.open[i])
+            return i;
+    }
+    for (int i = 0; i < SSE_MAX_CLIENTS; i++)
+    {
+        if (!s.link.connected(i))
+        {
+            dropClient(s, i);
+            return i;
+        }
+    }
+    return -1;
+}
+
+void sseAttach(SseStream &s, int slot)
+{
+    s.open[slot] = true;
+}
+
+void ssePublish(SseStream &s, const char *msg, size_t len, uint32_t nowMs)
+{
+    sendAll(s, msg, len, nowMs);
+    s.events++;
+}
+
+void ssePoll(SseStream &s, uint32_t nowMs)
+{
+    if (nowMs - s.lastWriteMs > SSE_KEEPALIVE_MS)
+    {
+        // Comment line: ignored by EventSource, detects dropped clients
+        sendAll(s, ": ka\n\n", 6, nowMs);
+        s.keepalives++;
+    }
+}
+
+int sseClientCount(const SseStream &s)
+{
+    int n = 0;
+    for (int i = 0; i < SSE_MAX_CLIENTS; i++)
+        n += s.open[i];
+    return n;
+}
+
+void sseCloseAll(SseStream &s)
+{
+    for (int i = 0; i < SSE_MAX_CLIENTS; i++)
+    {
+        if (s.open[i])
+            s.link.close(i);
+        s.open[i] = false;
+    }
+}
@@ -0,0 +1,68 @@
+#include "TaskMonitor.h"
+#include <esp_timer.h>
+
+struct TaskSlotState
+{
+    TaskLoad load;
+    TaskHandle_t handle;
+    int64_t busyStartUs;
+    int64_t windowStartUs;
+    uint64_t windowBusyUs;
+};
+
+static TaskSlotState slots[TASK_SLOT_COUNT];
+static portMUX_TYPE monitorMux = portMUX_INITIALIZER_UNLOCKED;
+
+void taskMonitorRegister(TaskSlot slot, const char *name)
+{
+    TaskSlotState &s = slots[slot];
+    s.handle = xTaskGetCurrentTaskHandle();
+    s.windowStartUs = esp_timer_get_time();
+
+    portENTER_CRITICAL(&monitorMux);
+    s.load.name = name;
+    s.load.registered = true;
+    s.load.core = xPortGetCoreID();
+    portEXIT_CRITICAL(&monitorMux);
+}
+
+void taskMonitorBegin(TaskSlot slot)
+{
+    slots[slot].busyStartUs = esp_timer_get_time();
+}
+
+// Only the owning task writes its slot; the lock keeps readers consistent
+void taskMonitorEnd(TaskSlot slot)
+{
+    TaskSlotState &s = slots[slot];
+    int64_t now = esp_timer_get_time();
+    uint32_t busyUs = (uint32_t)(now - s.busyStartUs);
+    s.windowBusyUs += busyUs;
+
+    portENTER_CRITICAL(&monitorMux);
+    s.load.core = xPortGetCoreID();
+    if (busyUs > s.load.maxBusyUs)
+        s.load.maxBusyUs = busyUs;
+
+    int64_t windowUs = now - s.windowStartUs;
+    if (windowUs >= (int64_t)TASK_LOAD_WINDOW_MS * 1000)
+    {
+        s.load.loadPermille = (uint16_t)(s.windowBusyUs * 1000 / windowUs);
+        s.windowBusyUs = 0;
+        s.windowStartUs = now;
+    }
+    portEXIT_CRITICAL(&monitorMux);
+}
+
+TaskLoad getTaskLoad(TaskSlot slot)
+{
+    portENTER_CRITICAL(&monitorMux);
+    TaskLoad load = slots[slot].load;
+    TaskHandle_t handle = slots[slot].handle;
+    portEXIT_CRITICAL(&monitorMux);
+
+    // ESP-IDF reports stack in bytes
+    if (handle)
+        load.stackFreeBytes = uxTaskGetStackHighWaterMark(handle);
+    return load;
+}
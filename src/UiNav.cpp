@@ -0,0 +1,77 @@
+#include "UiNav.h"
+
+UiCommand uiClick(UiNav &nav, const UiLayout &layout)
+{
+    if (nav.state == GRAPH)
+    {
+        // Cycle channels; after the last one move on to the next time span
+        nav.activeGraph++;
+        if (nav.activeGraph >= layout.graphChannels)
+        {
+            nav.activeGraph = 0;
+            nav.activeSpan++;
+            if (nav.activeSpan >= layout.graphSpans)
+                nav.activeSpan = 0;
+        }
+        return UI_CMD_NONE;
+    }
+
+    if (nav.state == STATS)
+    {
+        // Cycle stats pages, then back to the dashboard
+        nav.statsPage++;
+        if (nav.statsPage >= layout.statsPages)
+        {
+            nav.statsPage = 0;
+            nav.state = DASHBOARD;
+        }
+        return UI_CMD_NONE;
+    }
+
+    if (nav.state == CONFIRM_RESET)
+        return UI_CMD_RESET_STATE;
+
+    if (nav.state == DASHBOARD)
+    {
+        nav.state = MENU;
+        nav.selectedItem = 0;
+        nav.menuScrollOffset = 0;
+    }
+    else if (nav.state == MENU)
+    {
+        nav.selectedItem++;
+        if (nav.selectedItem >= layout.menuLength)
+            nav.selectedItem = 0;
+        if (nav.selectedItem >= nav.menuScrollOffset + UI_MENU_ROWS)
+        {
+            nav.menuScrollOffset = nav.selectedItem - (UI_MENU_ROWS - 1);
+        }
+        else if (nav.selectedItem < nav.menuScrollOffset)
+        {
+            nav.menuScrollOffset = nav.selectedItem;
+        }
+    }
+    return UI_CMD_NONE;
+}
+
+UiCommand uiLongPress(UiNav &nav)
+{
+    if (nav.state == GRAPH || nav.state == STATS)
+    {
+        nav.state = DASHBOARD;
+        return UI_CMD_NONE;
+    }
+
+    if (nav.state == CONFIRM_RESET)
+    {
+        nav.state = MENU; // Cancel
+        return UI_CMD_NONE;
+    }
+
+    if (nav.state == MENU)
+        return UI_CMD_RUN_ITEM;
+
+    if (nav.state == DASHBOARD)
+        nav.state = MENU;
+    return UI_CMD_NONE;
+}
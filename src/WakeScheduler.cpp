@@ -0,0 +1,102 @@
+#include "WakeScheduler.h"
+
+struct WakeDeadline
+{
+    bool armed;
+    uint8_t kind;
+    uint32_t atMs;
+};
+
+static WakeDeadline deadlines[WAKE_SOURCE_COUNT];
+static WakeStats stats;
+
+static const char *const sourceNames[WAKE_SOURCE_COUNT] = {
+    "sensor", "led", "ble", "input", "display", "web", "ui"};
+
+void wakeAt(WakeSource src, uint32_t atMs, WakeKind kind)
+{
+    deadlines[src].armed = true;
+    deadlines[src].kind = kind;
+    deadlines[src].atMs = atMs;
+}
+
+void wakeClear(WakeSource src)
+{
+    deadlines[src].armed = false;
+}
+
+void wakeClearAll()
+{
+    for (int i = 0; i < WAKE_SOURCE_COUNT; i++)
+        deadlines[i].armed = false;
+}
+
+bool wakeNextDeadline(uint32_t nowMs, uint32_t &atMs, WakeSource &src, WakeKind kind)
+{
+    bool found = false;
+    int32_t best = 0;
+    for (int i = 0; i < WAKE_SOURCE_COUNT; i++)
+    {
+        if (!deadlines[i].armed || !(deadlines[i].kind & kind))
+            continue;
+        int32_t until = (int32_t)(deadlines[i].atMs - nowMs);
+        if (!found || until < best)
+        {
+            best = until;
+            atMs = deadlines[i].atMs;
+            src = (WakeSource)i;
+            found = true;
+        }
+    }
+    return found;
+}
+
+uint32_t wakePlanWait(uint32_t nowMs, uint32_t maxMs)
+{
+    uint32_t atMs;
+    WakeSource src;
+    if (!wakeNextDeadline(nowMs, atMs, src, WAKE_FROM_WAIT))
+        return maxMs;
+
+    int32_t until = (int32_t)(atMs - nowMs);
+    if (until <= 0)
+        return 0;
+    return (uint32_t)until < maxMs ? (uint32_t)until : maxMs;
+}
+
+uint32_t wakePlanSleep(uint32_t nowMs, WakeSource &src)
+{
+    uint32_t atMs;
+    if (!wakeNextDeadline(nowMs, atMs, src, WAKE_FROM_SLEEP))
+        return 0;
+
+    int32_t until = (int32_t)(atMs - nowMs) - WAKE_LEAD_MS;
+    if (until < WAKE_MIN_SLEEP_MS)
+        return 0;
+    return (uint32_t)until;
+}
+
+void wakeNoteSleep(WakeSource src, uint32_t sleptMs, bool external)
+{
+    stats.sleeps++;
+    stats.sleptMs += sleptMs;
+    if (external)
+        stats.externalWakeups++;
+    else
+        stats.timerWakeups[src]++;
+}
+
+WakeStats getWakeStats()
+{
+    return stats;
+}
+
+void resetWakeStats()
+{
+    stats = WakeStats();
+}
+
+const char *wakeSourceName(WakeSource src)
+{
+    return src < WAKE_SOURCE_COUNT ? sourceNames[src] : "?";
+}
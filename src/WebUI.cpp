@@ -1,8 +1,122 @@
 #include "WebUI.h"
 #include "SharedData.h"
+#include "LogStorage.h"
+#include "LogManifest.h"
+#include "GraphHistory.h"
+#include "TaskMonitor.h"
+#include "SensorTask.h"
+#include "PowerManager.h"
+#include "WakeScheduler.h"
+#include "Profiler.h"
+#include "LatencyMonitor.h"
+#include "ApiJson.h"
+#include "FixedFormat.h"
+#include "SseStream.h"
+#include <lwip/sockets.h>
 
-// Helper to list files
-// Helper to list files
+// Server-Sent Events clients of /api/stream (SseStream.h), one socket per slot
+static WiFiClient sseClients[SSE_MAX_CLIENTS];
+static SseStream sse;
+
+// /api/data: the latest readings
+static int buildDataJson(char *json, size_t len)
+{
+    uint32_t seq;
+    SensorReadings cur = readingsSnapshot(&seq);
+    RecordingState rec = recordingSnapshot();
+    return apiDataJson(json, len, cur, seq, millis(), rec.active, rec.fileName);
+}
+
+// Straight to the socket without waiting: WiFiClient::write() retries for
+// seconds while a client that stopped reading has a full send buffer.
+// Whatever doesn't fit comes back as a short count and SseStream drops it.
+static size_t sseWrite(int slot, const uint8_t *data, size_t len)
+{
+    int fd = sseClients[slot].fd();
+    if (fd < 0)
+        return 0;
+    int n = send(fd, data, len, MSG_DONTWAIT);
+    return n > 0 ? (size_t)n : 0;
+}
+
+static bool sseConnected(int slot)
+{
+    return sseClients[slot].connected();
+}
+
+static void sseClose(int slot)
+{
+    sseClients[slot].stop();
+    sseClients[slot] = WiFiClient();
+}
+
+static int buildDataEvent(char *msg, size_t len, const SensorReadings &r, uint32_t nowMs)
+{
+    RecordingState rec = recordingSnapshot();
+    return sseDataEvent(msg, len, r, r.seq, nowMs, rec.active, rec.fileName);
+}
+
+void publishWebUI(const SensorReadings &r, uint32_t nowMs)
+{
+    char msg[SSE_EVENT_MAX];
+    int len = buildDataEvent(msg, sizeof(msg), r, nowMs);
+    ssePublish(sse, msg, len, millis());
+}
+
+void handleWebUIStream()
+{
+    ssePoll(sse, millis());
+}
+
+// Decimal KB, nothing else (String::toInt() takes signs and trailing junk)
+static bool parseQuotaKB(const char *s, uint32_t &kb)
+{
+    uint32_t v = 0;
+    int digits = 0;
+    for (; *s; s++, digits++)
+    {
+        if (*s < '0' || *s > '9' || digits == 9)
+            return false;
+        v = v * 10 + (*s - '0');
+    }
+    kb = v;
+    return digits > 0;
+}
+
+static void sendStorageReport(WebServer &server)
+{
+    LogStorageReport r = getLogStorageReport();
+    char perSample[48];
+    fmtFixedTo(perSample, sizeof(perSample), r.bytesPerSample, 2);
+    char json[384];
+    snprintf(json, sizeof(json),
+        "{\"total\":%lu,\"used\":%lu,\"free\":%lu,\"quota\":%lu,\"logBytes\":%lu,\"segments\":%d,\"segmentSize\":%lu,\"oldest\":%d,\"bytesPerSample\":%s,\"remainingSec\":%lu,\"mode\":%d}",
+        (unsigned long)r.totalBytes,
+        (unsigned long)r.usedBytes,
+        (unsigned long)r.freeBytes,
+        (unsigned long)r.quotaBytes,
+        (unsigned long)r.logBytes,
+        r.segments,
+        (unsigned long)LOG_SEGMENT_SIZE,
+        r.oldestIndex,
+        perSample,
+        (unsigned long)r.remainingSec,
+        (int)sysConfig.opMode
+    );
+    server.send(200, "application/json", json);
+}
+
+static void sendReplayStatus(WebServer &server, bool requested)
+{
+    SensorStatus s = getSensorStatus();
+    char json[160];
+    snprintf(json, sizeof(json), "{\"requested\":%s,\"replaying\":%s,\"file\":\"%s\",\"samples\":%lu}",
+        requested ? "true" : "false",
+        s.replaying ? "true" : "false",
+        s.replaying ? s.replayFile : "",
+        (unsigned long)s.replaySamples);
+    server.send(200, "application/json", json);
+}
 
 const char *html_head = R"rawliteral(
 <!DOCTYPE html>
@@ -28,6 +142,8 @@ const char *html_head = R"rawliteral(
         .fname { font-size: 0.9rem; }
         .actions { display: flex; }
         .footer { margin-top: 20px; font-size: 0.8rem; opacity: 0.5; }
+        canvas { width: 100%; height: 160px; }
+        select { background: var(--bg); color: var(--text); border: 1px solid #333; border-radius: 6px; padding: 4px; }
     </style>
 </head>
 <body>
@@ -35,8 +151,59 @@ const char *html_head = R"rawliteral(
 
 const char *html_foot = R"rawliteral(
     <script>
-        function update() {
-            fetch('/api/data').then(r => r.json()).then(d => {
+        // History chart: seeded from /api/history, extended by live samples
+        const hist = { t: [], v: [[], [], [], [], []] };
+        const keys = ['iaq', 'co2', 'temp', 'hum', 'press'];
+        function draw() {
+            const c = document.getElementById('chart');
+            const ch = +document.getElementById('chan').value;
+            const w = c.width = c.clientWidth, h = c.height = c.clientHeight;
+            const g = c.getContext('2d'), v = hist.v[ch], t = hist.t;
+            g.clearRect(0, 0, w, h);
+            if (v.length < 2) return;
+            const lo = Math.min(...v), hi = Math.max(...v), span = (hi - lo) || 1;
+            const t0 = t[0], tspan = (t[t.length - 1] - t0) || 1;
+            g.strokeStyle = '#bb86fc';
+            g.beginPath();
+            v.forEach((y, i) => {
+                const px = (t[i] - t0) / tspan * (w - 1), py = h - 12 - (y - lo) / span * (h - 24);
+                i ? g.lineTo(px, py) : g.moveTo(px, py);
+            });
+            g.stroke();
+            g.fillStyle = '#e0e0e0';
+            g.fillText(hi.toFixed(1), 2, 10);
+            g.fillText(lo.toFixed(1), 2, h - 2);
+            g.fillText(Math.round(tspan / 1000) + 's', w - 40, h - 2);
+        }
+        function addSample(t, vals) {
+            hist.t.push(t);
+            vals.forEach((x, i) => hist.v[i].push(x));
+            if (hist.t.length > 100) { hist.t.shift(); hist.v.forEach(a => a.shift()); }
+        }
+        // Live samples are charted once each, in time order after the seed.
+        // Until the seed is in they wait, so the two can't interleave.
+        let lastSeq = 0, seeded = false;
+        const early = [];
+        function plot(d) {
+            const last = hist.t.length ? hist.t[hist.t.length - 1] : -1;
+            if (d.seq < lastSeq && d.uptime < last) {
+                // Device restarted: seq and uptime start over
+                hist.t = [];
+                hist.v.forEach(a => a.length = 0);
+            } else if (d.seq <= lastSeq || d.uptime <= last) {
+                return;
+            }
+            lastSeq = d.seq;
+            addSample(d.uptime, keys.map(k => d[k]));
+        }
+        fetch('/api/history').then(r => r.json()).then(h => {
+            h.rows.forEach(r => addSample(r[0], r.slice(1)));
+        }).catch(() => {}).then(() => {
+            seeded = true;
+            early.splice(0).forEach(plot);
+            draw();
+        });
+        function show(d) {
                 document.getElementById('iaq').innerText = d.iaq.toFixed(0);
                 document.getElementById('co2').innerText = d.co2.toFixed(0);
                 document.getElementById('temp').innerText = d.temp.toFixed(1);
@@ -47,13 +214,31 @@ const char *html_foot = R"rawliteral(
                 document.getElementById('uptime').innerText = Math.floor(d.uptime/1000) + 's';
                 document.getElementById('recStatus').innerText = d.isRec ? "RECORDING (" + d.recFile + ")" : "IDLE";
                 document.getElementById('recStatus').style.color = d.isRec ? "#cf6679" : "#e0e0e0";
-            });
+        }
+        function live(d) {
+            show(d);
+            if (!seeded) {
+                early.push(d);
+                return;
+            }
+            plot(d);
+            draw();
+        }
+        function update() {
+            fetch('/api/data').then(r => r.json()).then(show);
         }
         function del(file) {
             if(confirm('Delete ' + file + '?')) location.href='/delete?file=' + file;
         }
-        setInterval(update, 2000);
         update();
+        // Pushed by the device whenever a new sample arrives; poll only as a fallback
+        if (window.EventSource) {
+            const es = new EventSource('/api/stream');
+            es.onmessage = e => live(JSON.parse(e.data));
+            es.addEventListener('now', e => show(JSON.parse(e.data)));
+        } else {
+            setInterval(update, 2000);
+        }
     </script>
 </body>
 </html>
@@ -61,6 +246,12 @@ const char *html_foot = R"rawliteral(
 
 void setupWebUI(WebServer &server)
 {
+    SseLink link;
+    link.write = sseWrite;
+    link.connected = sseConnected;
+    link.close = sseClose;
+    sseInit(sse, link, millis());
+
     server.on("/", HTTP_GET, [&server]()
               {
                   server.setContentLength(CONTENT_LENGTH_UNKNOWN);
@@ -82,40 +273,43 @@ void setupWebUI(WebServer &server)
                   server.sendContent(F("<div style='margin-top:10px; font-size:0.9rem;'>Accuracy: <span id='acc'>0</span>/3</div>"));
                   server.sendContent(F("</div>"));
 
+                  // History Card
+                  server.sendContent(F("<div class='card'><h3>History</h3>"
+                                       "<select id='chan' onchange='draw()'><option value='0'>IAQ</option><option value='1'>CO2</option>"
+                                       "<option value='2'>Temp</option><option value='3'>Humidity</option><option value='4'>Pressure</option></select>"
+                                       "<canvas id='chart'></canvas></div>"));
+
                   // File List Card
                   server.sendContent("<div class='card'><h3>Recordings</h3>");
 
-                  File root = LittleFS.open("/");
-                  if (!root || !root.isDirectory())
+                  // Served from the manifest, no directory walk
+                  LogManifestEntry entry;
+                  int count = 0;
+                  for (; logManifestGet(count, entry); count++)
                   {
-                      server.sendContent("<div>Failed to open dir</div>");
+                      char name[32];
+                      logManifestFileName(entry, name, sizeof(name));
+
+                      char buf[384];
+                      snprintf(buf, sizeof(buf),
+                               "<div class='file-row'><span class='fname'>%s (%lu b, %lu pts)</span>"
+                               "<div class='actions'><a href='%s' download><button class='btn-sm'>DL</button></a>"
+                               "<button class='btn-sm danger' onclick=\"del('%s')\">X</button></div></div>",
+                               name, (unsigned long)entry.size, (unsigned long)entry.samples, name, name);
+                      server.sendContent(buf);
                   }
-                  else
+                  if (count == 0)
                   {
-                      File file = root.openNextFile();
-                      bool found = false;
-                      while (file)
-                      {
-                          String name = String(file.name());
-                          // Check if it's a log file (relaxed check for leading slash)
-                          if (name.endsWith(".csv"))
-                          { // Added filter for CSV to be cleaner
-                              found = true;
-
-                              char buf[384];
-                              snprintf(buf, sizeof(buf),
-                                       "<div class='file-row'><span class='fname'>%s (%lu b)</span>"
-                                       "<div class='actions'><a href='%s' download><button class='btn-sm'>DL</button></a>"
-                                       "<button class='btn-sm danger' onclick=\"del('%s')\">X</button></div></div>",
-                                       name.c_str(), (unsigned long)file.size(), name.c_str(), name.c_str());
-                              server.sendContent(buf);
-                          }
-                          file = root.openNextFile();
-                      }
-                      if (!found)
-                      {
-                          server.sendContent("<div style='opacity:0.6; padding:10px;'>No recordings found.</div>");
-                      }
+                      server.sendContent("<div style='opacity:0.6; padding:10px;'>No recordings found.</div>");
+                  }
+                  {
+                      LogStorageReport r = getLogStorageReport();
+                      char buf[160];
+                      snprintf(buf, sizeof(buf),
+                               "<div class='footer'>%lu / %lu KB used by logs, ~%lu h left at this mode</div>",
+                               (unsigned long)(r.logBytes / 1024), (unsigned long)(r.quotaBytes / 1024),
+                               (unsigned long)(r.remainingSec / 3600));
+                      server.sendContent(buf);
                   }
                   server.sendContent("</div>");
 
@@ -127,28 +321,268 @@ void setupWebUI(WebServer &server)
     server.on("/api/data", HTTP_GET, [&server]()
               {
         char json[512];
-        snprintf(json, sizeof(json), 
-            "{\"iaq\":%.2f,\"co2\":%.2f,\"temp\":%.2f,\"hum\":%.2f,\"press\":%.2f,\"volt\":%.2f,\"acc\":%d,\"uptime\":%lu,\"isRec\":%s,\"recFile\":\"%s\"}",
-            currentData.iaq,
-            currentData.co2,
-            currentData.temp,
-            currentData.hum,
-            currentData.press,
-            currentData.voltage,
-            currentData.accuracy,
-            millis(),
-            isRecording ? "true" : "false",
-            currentLogFileName
-        );
+        buildDataJson(json, sizeof(json));
+        server.send(200, "application/json", json); });
+
+    server.on("/api/history", HTTP_GET, [&server]()
+              {
+        // Graph ring buffers, oldest first: rows of [t_ms, iaq, co2, temp, hum, press]
+        server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        server.send(200, "application/json", "");
+
+        char buf[160];
+        snprintf(buf, sizeof(buf), "{\"now\":%lu,\"channels\":[\"iaq\",\"co2\",\"temp\",\"hum\",\"press\"],\"rows\":[", millis());
+        server.sendContent(buf);
+
+        // Batch rows to keep the number of TCP writes down
+        char chunk[1024];
+        int fill = 0;
+        int count = graphHistoryCount();
+        for (int i = 0; i < count; i++)
+        {
+            int idx = graphHistoryIndex(i);
+            FmtBuf row;
+            fmtInit(row, buf, sizeof(buf));
+            fmtStr(row, i ? ",[" : "[");
+            fmtUint(row, graphTimes[idx]);
+            for (int ch = 0; ch < 5; ch++)
+            {
+                fmtChar(row, ',');
+                fmtFixed(row, graphBuffers[ch][idx], 2);
+            }
+            fmtChar(row, ']');
+            int len = fmtEnd(row);
+            if (fill + len >= (int)sizeof(chunk))
+            {
+                server.sendContent(chunk, fill);
+                fill = 0;
+            }
+            memcpy(chunk + fill, buf, len);
+            fill += len;
+        }
+        if (fill > 0)
+            server.sendContent(chunk, fill);
+        server.sendContent("]}");
+        server.sendContent(""); // Terminate chunked transfer
+    });
+
+    server.on("/api/stream", HTTP_GET, [&server]()
+              {
+        int slot = sseFreeSlot(sse);
+        if (slot < 0)
+        {
+            server.send(503, "text/plain", "Too many stream clients");
+            return;
+        }
+
+        // Raw headers: no Content-Length, the connection stays open and
+        // publishWebUI() writes events to it directly
+        WiFiClient client = server.client();
+        client.setNoDelay(true);
+        client.print("HTTP/1.1 200 OK\r\n"
+                     "Content-Type: text/event-stream\r\n"
+                     "Cache-Control: no-cache\r\n"
+                     "Connection: keep-alive\r\n\r\n"
+                     "retry: 3000\n\n"
+                     "event: now\n");
+        // Current values right away as a "now" event (shown, not charted:
+        // it repeats a sample), then one message per new sample
+        char msg[SSE_EVENT_MAX];
+        int len = buildDataEvent(msg, sizeof(msg), readingsSnapshot(), millis());
+        client.write((const uint8_t *)msg, len);
+        sseClients[slot] = client;
+        sseAttach(sse, slot); });
+
+    server.on("/api/storage", HTTP_GET, [&server]()
+              { sendStorageReport(server); });
+
+    server.on("/api/storage", HTTP_POST, [&server]()
+              {
+        // quota=<KB> sets the recording quota (0 = default share)
+        uint32_t kb;
+        if (!server.hasArg("quota") || !parseQuotaKB(server.arg("quota").c_str(), kb)) {
+            server.send(400, "text/plain", "quota must be a number of KB");
+            return;
+        }
+        sysConfig.logQuotaKB = logStorageClampQuotaKB(kb);
+        saveConfig();
+        sendStorageReport(server); });
+
+    server.on("/api/replay", HTTP_GET, [&server]()
+              { sendReplayStatus(server, false); });
+
+    server.on("/api/replay", HTTP_POST, [&server]()
+              {
+        // Demo mode: file=/log_NNN.csv&speed=S starts (file defaults to the
+        // newest recording, speed to real time), stop=1 stops. The sensor
+        // task applies the command asynchronously.
+        bool requested = false;
+        if (server.hasArg("stop"))
+            requested = sensorSend(SENSOR_CMD_REPLAY_STOP);
+        else if (server.hasArg("file") || server.hasArg("speed"))
+            requested = sensorReplay(server.arg("file").c_str(), server.hasArg("speed") ? server.arg("speed").toFloat() : 1.0f);
+        sendReplayStatus(server, requested); });
+
+    server.on("/api/tasks", HTTP_GET, [&server]()
+              {
+        // Per-task CPU share (last TASK_LOAD_WINDOW_MS) and stack headroom
+        char json[512];
+        int n = snprintf(json, sizeof(json), "{\"windowMs\":%d,\"tasks\":[", TASK_LOAD_WINDOW_MS);
+        for (int t = 0; t < TASK_SLOT_COUNT; t++) {
+            TaskLoad load = getTaskLoad((TaskSlot)t);
+            char loadPct[48];
+            fmtFixedTo(loadPct, sizeof(loadPct), load.loadPermille / 10.0f, 1);
+            n += snprintf(json + n, sizeof(json) - n,
+                "%s{\"name\":\"%s\",\"core\":%d,\"load\":%s,\"maxBusyUs\":%lu,\"stackFree\":%lu}",
+                t ? "," : "",
+                load.name,
+                load.core,
+                loadPct,
+                (unsigned long)load.maxBusyUs,
+                (unsigned long)load.stackFreeBytes);
+        }
+        snprintf(json + n, sizeof(json) - n, "],\"droppedReadings\":%lu}", (unsigned long)getSensorStatus().droppedReadings);
+        server.send(200, "application/json", json); });
+
+    server.on("/api/power", HTTP_GET, [&server]()
+              {
+        // Power-state residency since boot and what ended each light sleep
+        PowerResidency pr = getPowerResidency();
+        WakeStats ws = getWakeStats();
+        char json[512];
+        int n = snprintf(json, sizeof(json),
+            "{\"activeMs\":%llu,\"modemSleepMs\":%llu,\"lightSleepMs\":%llu,\"lightSleeps\":%lu,"
+            "\"dfs\":%s,\"minMhz\":%u,\"maxMhz\":%u,\"cpuMhz\":%lu,\"autoLightSleep\":%s,\"wakeups\":{",
+            (unsigned long long)pr.activeMs,
+            (unsigned long long)pr.modemSleepMs,
+            (unsigned long long)pr.lightSleepMs,
+            (unsigned long)pr.lightSleeps,
+            pr.dfs ? "true" : "false",
+            pr.minMhz,
+            pr.maxMhz,
+            (unsigned long)getCpuFrequencyMhz(),
+            pr.autoLightSleep ? "true" : "false");
+        for (int s = 0; s < WAKE_SOURCE_COUNT; s++)
+            n += snprintf(json + n, sizeof(json) - n, "\"%s\":%lu,", wakeSourceName((WakeSource)s), (unsigned long)ws.timerWakeups[s]);
+        snprintf(json + n, sizeof(json) - n, "\"external\":%lu}}", (unsigned long)ws.externalWakeups);
+        server.send(200, "application/json", json); });
+
+    server.on("/api/metrics", HTTP_GET, [&server]()
+              {
+        // Per-subsystem time since boot; hist is [upper bound us, calls] per bucket
+#if PROFILER_ENABLED
+        server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        server.send(200, "application/json", "");
+
+        uint32_t mhz = getCpuFrequencyMhz();
+        char buf[384];
+        snprintf(buf, sizeof(buf), "{\"enabled\":true,\"cpuMhz\":%lu,\"uptimeMs\":%lu,\"subsystems\":[",
+                 (unsigned long)mhz, (unsigned long)millis());
+        server.sendContent(buf);
+
+        for (int s = 0; s < PROF_SLOT_COUNT; s++)
+        {
+            ProfileStats ps = getProfileStats((ProfileSlot)s);
+            int n = snprintf(buf, sizeof(buf),
+                "%s{\"name\":\"%s\",\"calls\":%lu,\"totalUs\":%llu,\"meanUs\":%lu,\"p50Us\":%lu,\"p90Us\":%lu,\"p99Us\":%lu,\"maxUs\":%lu,\"hist\":",
+                s ? "," : "",
+                ps.name,
+                (unsigned long)ps.calls,
+                (unsigned long long)ps.totalUs,
+                (unsigned long)ps.meanUs,
+                (unsigned long)ps.p50Us,
+                (unsigned long)ps.p90Us,
+                (unsigned long)ps.p99Us,
+                (unsigned long)ps.maxUs);
+            n += apiHistJson(buf + n, sizeof(buf) - n, ps.cycles, mhz);
+            snprintf(buf + n, sizeof(buf) - n, "}");
+            server.sendContent(buf);
+        }
+        server.sendContent("]}");
+#else
+        server.send(200, "application/json", "{\"enabled\":false}");
+#endif
+    });
+
+    server.on("/api/latency", HTTP_GET, [&server]()
+              {
+        // Loop pass busy time and press -> panel latency, in us
+        const LatencyStats &ls = getLatencyStats();
+        const Histogram *hists[2] = {&ls.loopUs, &ls.inputToPixelUs};
+        static const char *names[2] = {"loop", "inputToPixel"};
+        char json[1024];
+        int n = snprintf(json, sizeof(json), "{");
+        for (int i = 0; i < 2; i++)
+        {
+            const Histogram &h = *hists[i];
+            n += snprintf(json + n, sizeof(json) - n,
+                "\"%s\":{\"count\":%lu,\"meanUs\":%lu,\"p50Us\":%lu,\"p99Us\":%lu,\"maxUs\":%lu,\"hist\":",
+                names[i],
+                (unsigned long)h.count,
+                (unsigned long)h.mean(),
+                (unsigned long)h.percentile(50),
+                (unsigned long)h.percentile(99),
+                (unsigned long)h.max);
+            n += apiHistJson(json + n, sizeof(json) - n, h, 1);
+            n += snprintf(json + n, sizeof(json) - n, "},");
+        }
+        snprintf(json + n, sizeof(json) - n, "\"inputsIgnored\":%lu}", (unsigned long)ls.inputsIgnored);
         server.send(200, "application/json", json); });
 
+    server.on("/api/files", HTTP_GET, [&server]()
+              {
+        // Paginated: ?offset=N&limit=M (limit capped at 32)
+        int offset = server.hasArg("offset") ? server.arg("offset").toInt() : 0;
+        int limit = server.hasArg("limit") ? server.arg("limit").toInt() : 16;
+        if (offset < 0)
+            offset = 0;
+        if (limit <= 0 || limit > 32)
+            limit = 32;
+
+        int total = logManifestCount();
+        RecordingState rec = recordingSnapshot();
+        server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        server.send(200, "application/json", "");
+
+        char buf[256];
+        snprintf(buf, sizeof(buf), "{\"total\":%d,\"offset\":%d,\"files\":[", total, offset);
+        server.sendContent(buf);
+
+        LogManifestEntry entry;
+        for (int i = offset; i < offset + limit && logManifestGet(i, entry); i++)
+        {
+            char name[32];
+            logManifestFileName(entry, name, sizeof(name));
+            snprintf(buf, sizeof(buf),
+                "%s{\"name\":\"%s\",\"size\":%lu,\"samples\":%lu,\"start\":%lu,\"end\":%lu,\"format\":\"%s\",\"schema\":%u,\"active\":%s}",
+                i > offset ? "," : "",
+                name,
+                (unsigned long)entry.size,
+                (unsigned long)entry.samples,
+                (unsigned long)entry.startMs,
+                (unsigned long)entry.endMs,
+                entry.format == LOG_FORMAT_BIN ? "bin" : "csv",
+                entry.schema,
+                (rec.active && strcmp(name, rec.fileName) == 0) ? "true" : "false");
+            server.sendContent(buf);
+        }
+        server.sendContent("]}");
+        server.sendContent(""); // Terminate chunked transfer
+    });
+
+    server.on("/api/files/rebuild", HTTP_GET, [&server]()
+              {
+        logManifestRebuild();
+        server.sendHeader("Location", "/");
+        server.send(303); });
+
     // Handle file downloads dynamically
     server.onNotFound([&server]()
                       {
         String path = server.uri();
-        if (path.endsWith(".csv") && LittleFS.exists(path)) {
+        if ((path.endsWith(".csv") || path.endsWith(".hlg")) && LittleFS.exists(path)) {
             File file = LittleFS.open(path, "r");
-            server.streamFile(file, "text/csv");
+            server.streamFile(file, path.endsWith(".hlg") ? "application/octet-stream" : "text/csv");
             file.close();
         } else {
             server.send(404, "text/plain", "File not found");
@@ -158,10 +592,13 @@ void setupWebUI(WebServer &server)
               {
         if (server.hasArg("file")) {
             String file = server.arg("file");
-            if (LittleFS.exists(file)) {
+            if (!file.startsWith("/"))
+                file = "/" + file;
+            // Never delete the recording in progress
+            RecordingState rec = recordingSnapshot();
+            if (!(rec.active && file == rec.fileName) && LittleFS.exists(file)) {
                 LittleFS.remove(file);
-            } else if (LittleFS.exists("/" + file)) {
-                LittleFS.remove("/" + file);
+                logManifestRemove(file.c_str());
             }
         }
         server.sendHeader("Location", "/");
@@ -172,5 +609,6 @@ void setupWebUI(WebServer &server)
 
 void stopWebUI(WebServer &server)
 {
+    sseCloseAll(sse);
     server.stop();
 }
@@ -9,14 +9,32 @@
 #include "SharedData.h"
 #include "WebUI.h"
 #include "BLEHandler.h"
+#include "BleFileXfer.h"
 #include "LEDHandler.h"
+#include "LogWriter.h"
+#include "LogStaging.h"
+#include "LogManifest.h"
+#include "GraphHistory.h"
+#include "DisplayDiff.h"
+#include "I2CBus.h"
+#include "SensorTask.h"
+#include "TaskMonitor.h"
+#include "WakeScheduler.h"
+#include "PowerManager.h"
+#include "Profiler.h"
+#include "LatencyMonitor.h"
+#include "Board.h"
+#include "Hal.h"
+#include "UiNav.h"
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
 #include <LittleFS.h>
 #include <OneButton.h>
 #include <esp_task_wdt.h>
+#include <esp_timer.h>
 #include <driver/rtc_io.h>
 #include <driver/touch_pad.h>
+#include <hal/gpio_ll.h>
 
 // RTC Memory - Persistent across Deep Sleep
 RTC_DATA_ATTR struct
@@ -31,13 +49,6 @@ const char *password = "170525ANee";
 const char *ota_hostname = "handheldlogger";
 const char *ota_password = "6767";
 
-#define BATTERY_PIN 9 // GPIO 9 on deneyapkart1Av2 (ESP32-S3)
-#define GPKEY_PIN 0
-#define TOUCH_PIN 10 // GPIO 10 on deneyapkart1Av2 (ESP32-S3)
-#define VOLT_DIVIDER_RATIO 2.0
-
-#define I2C_SDA 47 // GPIO 47 on deneyapkart1Av2 (ESP32-S3)
-#define I2C_SCL 21 // GPIO 21 on deneyapkart1Av2 (ESP32-S3)
 #define SCREEN_WIDTH 128
 #define SCREEN_HEIGHT 64
 // ESP32-S3 touch triggers when value RISES above threshold (inverted from ESP32)
@@ -47,25 +58,12 @@ const char *ota_password = "6767";
 #define WDT_TIMEOUT 30
 
 /* --- GRAPH CONFIG --- */
-#define GRAPH_WIDTH 100
 #define GRAPH_HEIGHT 40
 #define GRAPH_X_START 26
 #define GRAPH_Y_START 20
-#define GRAPH_COUNT 5
 
 /* --- LOGGING CONFIG --- */
-#define LOG_BUFFER_SIZE 300
-struct LogData
-{
-  unsigned long timestamp;
-  float iaq;
-  float co2;
-  float temp;
-  float hum;
-};
-LogData logBuffer[LOG_BUFFER_SIZE];
-int logHead = 0;
-bool isFlushing = false;
+// LogData buffers and the CSV writer task live in LogWriter.cpp
 
 #ifndef BSEC_SAMPLE_RATE_CONT
 #define BSEC_SAMPLE_RATE_CONT 1.0f
@@ -77,8 +75,8 @@ bool isFlushing = false;
 #define BSEC_SAMPLE_RATE_ULP 0.003333f
 #endif
 
-Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, -1);
-Bsec2 envSensor;
+// Keep the driver's own transfers at the shared bus clock (see I2CBus.h)
+Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, -1, I2C_BUS_CLOCK, I2C_BUS_CLOCK);
 OneButton btn = OneButton(GPKEY_PIN, true, true);
 WebServer server(80); // [NEW] Web Server on Port 80
 
@@ -86,17 +84,11 @@ WebServer server(80); // [NEW] Web Server on Port 80
 // OpMode and SystemConfig moved to SharedData.h
 
 // --- STATE VARIABLES ---
-#define STATE_SAVE_PERIOD 1800000
-uint8_t bsecState[BSEC_MAX_STATE_BLOB_SIZE];
-uint32_t lastStateSave = 0;
-bool isSaving = false;
-bool stateLoaded = false;
-bool hasSavedSinceBoot = false;
+// BSEC state save bookkeeping lives in SensorTask.cpp (getSensorStatus())
 
 unsigned long lastActivityTime = 0;
 unsigned long stayAwakeUntil = 0;
 unsigned long ignoreInputUntil = 0;
-uint32_t lastBsecRun = 0;
 bool isScreenOn = true;
 bool ignoreNextRelease = false;
 bool ecoModeDeepSleep = false; // Track if eco mode is in deep sleep (screen off)
@@ -106,26 +98,44 @@ unsigned long touchStartTime = 0;
 bool isTouching = false;
 bool touchHandled = false;
 
-// Graph Data
-// 0: IAQ, 1: CO2, 2: Temp, 3: Hum, 4: Press
-float graphBuffers[GRAPH_COUNT][GRAPH_WIDTH];
-int graphHead = 0;
-bool graphFilled = false;
-int activeGraph = 0;
-const char *graphLabels[] = {"IAQ", "CO2", "TEMP", "HUM", "PRESS"};
-const char *graphUnits[] = {"", "ppm", "C", "%", "Pa"};
+// Stats screen pages
+#if PROFILER_ENABLED
+#define STATS_PAGE_COUNT 6
+#else
+#define STATS_PAGE_COUNT 5
+#endif
 
 // Structs moved to SharedData.h and instantiated in SharedData.cpp
 
-enum UiState
+// Screen, menu cursor and graph / stats selection (UiNav.h).
+// Graph ring buffers live in GraphHistory.cpp.
+UiNav ui;
+
+// Redraw-on-change: anything that alters what a screen shows marks it dirty,
+// and the render step is skipped while the current screen is clean.
+#define UI_DIRTY_DASHBOARD 0x01
+#define UI_DIRTY_MENU 0x02
+#define UI_DIRTY_GRAPH 0x04
+#define UI_DIRTY_STATS 0x08
+#define UI_DIRTY_CONFIRM 0x10
+#define UI_DIRTY_ALL 0x1F
+#define UI_BLINK_MS 500       // WiFi "connecting" icon
+#define UI_LIVE_STATS_MS 1000 // Uptime / touch / frame time on STATS
+#define UI_POLL_MS 250        // Status icons fed by other tasks (writer busy, state save)
+#define INPUT_POLL_MS 10      // OneButton / touch while a gesture is in progress
+#define WEB_POLL_MS 10        // Web server and OTA while WiFi is up
+uint8_t uiDirty = UI_DIRTY_ALL;
+
+// Frames rendered vs. skipped, rolled over once a minute
+struct UiFrameStats
 {
-  DASHBOARD,
-  MENU,
-  GRAPH,
-  STATS,
-  CONFIRM_RESET
+  uint32_t rendered = 0;
+  uint32_t skipped = 0;
+  uint32_t renderedPerMin = 0;
+  uint32_t skippedPerMin = 0;
+  unsigned long windowStart = 0;
 };
-UiState appState = DASHBOARD;
+UiFrameStats uiFrames;
 
 // Async WiFi
 bool wifiConnectRequested = false;
@@ -143,12 +153,15 @@ void act_ForceSave();
 void act_ToggleWiFi();
 void act_ToggleBLE();
 void act_ToggleRecord();
+void act_ToggleFormat();
+void act_ToggleDemo();
 void act_ChangeMode();
 void act_ChangeTimeout();
 void act_ResetCalib()
 {
-  appState = CONFIRM_RESET;
+  ui.state = CONFIRM_RESET;
 };
+void act_ResetTiming();
 void act_Reboot();
 void act_PowerOff();
 void act_Exit();
@@ -156,10 +169,11 @@ void act_Exit();
 const char *get_WiFiLabel();
 const char *get_BLELabel();
 const char *get_RecordLabel();
+const char *get_FormatLabel();
+const char *get_DemoLabel();
 const char *get_ModeLabel();
 const char *get_TimeoutLabel();
 
-int getBatteryPercentage(float voltage);
 
 struct MenuItem
 {
@@ -173,98 +187,74 @@ MenuItem menuItems[] = {
     {"Show Stats", NULL, act_EnterStats},
     {"Force Save", NULL, act_ForceSave},
     {NULL, get_RecordLabel, act_ToggleRecord},
+    {NULL, get_FormatLabel, act_ToggleFormat},
+    {NULL, get_DemoLabel, act_ToggleDemo},
     {NULL, get_WiFiLabel, act_ToggleWiFi},
     {NULL, get_BLELabel, act_ToggleBLE},
     {NULL, get_ModeLabel, act_ChangeMode},
     {NULL, get_TimeoutLabel, act_ChangeTimeout},
     {"Reset Calibration", NULL, act_ResetCalib},
+    {"Reset Timing", NULL, act_ResetTiming},
     {"Reboot", NULL, act_Reboot},
     {"Power Off", NULL, act_PowerOff},
     {"Exit", NULL, act_Exit}};
 
 const int menuLength = sizeof(menuItems) / sizeof(MenuItem);
-int selectedItem = 0;
-int menuScrollOffset = 0;
+const UiLayout uiLayout = {menuLength, GRAPH_COUNT, GRAPH_SPAN_COUNT, STATS_PAGE_COUNT};
 
 /* --- PROTOTYPES --- */
-void newDataCallback(const bme68xData data, const bsecOutputs outputs, Bsec2 capture);
-void checkBsecStatus(Bsec2 bsec);
+void handleNewReadings(const SensorReadings &r);
+void checkBsecStatus(int status);
 void setupOTA();
 
 // void setupWebServer(); // Moved to WebUI.cpp
-float getBatteryVoltage();
-void loadBsecState();
-bool updateBsecState(bool force = false);
-void flushLog();
 void loadConfig();
 void saveConfig();
 void applyConfigMode();
 void drawDashboard();
 void drawMenu();
+void drawBufferStat();
 void drawGraph();
 void drawStats();
+void drawDisplayStats();
+void drawTaskStats();
+void drawPowerStats();
+void drawLatencyStats();
+void drawProfileStats();
 void drawConfirmation();
-void updateAllGraphBuffers();
+void markDirty(uint8_t screens);
+uint8_t screenDirtyBit(UiState state);
+void checkUiChanges();
+void updateAllGraphBuffers(const SensorReadings &r, uint32_t nowMs);
 void wakeUpScreen();
 void checkTouchInput();
 void handleWiFiLogic();
 void setupSleepWakeup();
-void dummyTouchCallback() {};
+void armWakeDeadlines();
+void IRAM_ATTR touchISR();
+void IRAM_ATTR buttonISR();
+void onWiFiEvent(arduino_event_id_t event);
 
 // --- INPUT HANDLERS ---
 void handleClick()
 {
   if ((long)(millis() - ignoreInputUntil) < 0)
     return;
+  latencyInputHandled();
   wakeUpScreen();
   stayAwakeUntil = millis() + 1000;
+  markDirty(UI_DIRTY_ALL);
 
-  if (appState == GRAPH)
-  {
-    activeGraph++;
-    if (activeGraph >= GRAPH_COUNT)
-      activeGraph = 0;
-    return;
-  }
-
-  if (appState == STATS)
-  {
-    appState = DASHBOARD;
-    return;
-  }
-
-  if (appState == CONFIRM_RESET)
+  if (uiClick(ui, uiLayout) == UI_CMD_RESET_STATE)
   {
     // Execute Reset
     display.clearDisplay();
     display.setCursor(0, 25);
     display.println("Deleting State...");
-    display.display();
-    LittleFS.remove("/bsec_state.bin");
+    displayPush();
+    halFileRemove("/bsec_state.bin");
     delay(1000);
     ESP.restart();
-    return;
-  }
-
-  if (appState == DASHBOARD)
-  {
-    appState = MENU;
-    selectedItem = 0;
-    menuScrollOffset = 0;
-  }
-  else if (appState == MENU)
-  {
-    selectedItem++;
-    if (selectedItem >= menuLength)
-      selectedItem = 0;
-    if (selectedItem >= menuScrollOffset + 5)
-    {
-      menuScrollOffset = selectedItem - 4;
-    }
-    else if (selectedItem < menuScrollOffset)
-    {
-      menuScrollOffset = selectedItem;
-    }
   }
 }
 
@@ -278,31 +268,14 @@ void handleLongPressStop()
     return;
   }
 
+  latencyInputHandled();
   wakeUpScreen();
   stayAwakeUntil = millis() + 1000;
+  markDirty(UI_DIRTY_ALL);
 
-  if (appState == GRAPH || appState == STATS)
+  if (uiLongPress(ui) == UI_CMD_RUN_ITEM && menuItems[ui.selectedItem].action != NULL)
   {
-    appState = DASHBOARD;
-    return;
-  }
-
-  if (appState == CONFIRM_RESET)
-  {
-    appState = MENU; // Cancel
-    return;
-  }
-
-  if (appState == MENU)
-  {
-    if (menuItems[selectedItem].action != NULL)
-    {
-      menuItems[selectedItem].action();
-    }
-  }
-  else if (appState == DASHBOARD)
-  {
-    appState = MENU;
+    menuItems[ui.selectedItem].action();
   }
 }
 
@@ -338,19 +311,35 @@ void setup()
     // Serial.println("FS Fail");
   }
   loadConfig();
+  initLogManifest();
+
+  // Resume a recording interrupted by a reset or power loss
+  LogRecovery recovered = recoverLogSession(sysConfig.nextLogIndex - 1, currentLogFileName, sizeof(currentLogFileName));
+  if (recovered == LOG_RECOVER_RESUME)
+  {
+    isRecording = true;
+  }
+  publishRecordingState();
+  initLogWriter();
+
+  // Commit ECO samples staged in RTC memory before the reset. If the file
+  // couldn't be resumed they go into the new segment started below.
+  initLogStaging(recovered != LOG_RECOVER_NONE ? sysConfig.nextLogIndex - 1 : -1);
+  if (isRecording)
+    logStageDrain();
 
   btn.setPressMs(200);
   btn.attachClick(handleClick);
   btn.attachLongPressStop(handleLongPressStop);
 
-  touchAttachInterrupt(TOUCH_PIN, dummyTouchCallback, TOUCH_WAKE_THRESHOLD);
+  touchAttachInterrupt(TOUCH_PIN, touchISR, TOUCH_WAKE_THRESHOLD);
 
-  Wire.begin(I2C_SDA, I2C_SCL);
-  Wire.setClock(100000);
+  initI2CBus(I2C_SDA, I2C_SCL);
 
   if (!display.begin(SSD1306_SWITCHCAPVCC, 0x3C))
     for (;;)
       ;
+  initDisplayDiff(display.getBuffer(), 0x3C);
 
   // display.invertDisplay(true);
 
@@ -361,19 +350,20 @@ void setup()
   display.setTextSize(1);
   display.setCursor(0, 0);
   display.println(F("System Ready"));
-  display.display();
+  displayPush();
 
   WiFi.mode(WIFI_OFF);
+  WiFi.onEvent(onWiFiEvent);
 
-  if (!envSensor.begin(BME68X_I2C_ADDR_LOW, Wire))
-  {
-    if (!envSensor.begin(BME68X_I2C_ADDR_HIGH, Wire))
-      checkBsecStatus(envSensor);
-  }
+  // Frequency scaling and the loop's wake-up event, before anything signals it
+  initPower();
 
-  loadBsecState();
+  // BSEC and the logging pipeline run on their own task from here on
+  if (!initSensorTask())
+    checkBsecStatus(getSensorStatus().bsecStatus);
+  if (recovered == LOG_RECOVER_NEW_SEGMENT)
+    sensorSend(SENSOR_CMD_RECORD_START);
   applyConfigMode();
-  envSensor.attachCallback(newDataCallback);
 
   // Configure sleep wakeup sources once (optimization)
   setupSleepWakeup();
@@ -383,10 +373,105 @@ void setup()
   setLEDState(LED_IDLE);
 
   lastActivityTime = millis();
-  lastBsecRun = millis();
   stayAwakeUntil = millis() + 2000;
 }
 
+// --- LOOP EVENTS ---
+// Interrupts and other tasks only signal the loop; the work happens there
+
+// Level-triggered so the same setting wakes the chip from light sleep.
+// Disarmed until the gesture is over, or it would fire continuously.
+static volatile bool buttonIrqArmed = false;
+
+// Press edge for the input-to-pixel histogram, handed over at the next pass
+static volatile uint32_t inputEdgeUs = 0;
+static volatile bool inputEdgePending = false;
+
+static void IRAM_ATTR stampInputEdge()
+{
+  if (!inputEdgePending)
+  {
+    inputEdgeUs = (uint32_t)esp_timer_get_time();
+    inputEdgePending = true;
+  }
+}
+
+void IRAM_ATTR buttonISR()
+{
+  // The HAL call is inline, so it is safe while the flash cache is off
+  gpio_ll_intr_disable(&GPIO, (gpio_num_t)GPKEY_PIN);
+  buttonIrqArmed = false;
+  stampInputEdge();
+  powerSignalLoopFromISR();
+}
+
+void IRAM_ATTR touchISR()
+{
+  stampInputEdge();
+  powerSignalLoopFromISR();
+}
+
+void onWiFiEvent(arduino_event_id_t event)
+{
+  powerSignalLoop();
+}
+
+// Collects every subsystem's next deadline for the wait / sleep scheduler.
+// The UI deadline is armed by the drawing logic, which knows the frame timing.
+void armWakeDeadlines()
+{
+  unsigned long now = millis();
+
+  // The sensor task keeps its own schedule; it only constrains light sleep
+  wakeAt(WAKE_SENSOR, sensorNextCallMs(), WAKE_FROM_SLEEP);
+
+  uint32_t ledAt;
+  bool ledMustWake;
+  if (ledNextDeadline(ledAt, ledMustWake))
+    wakeAt(WAKE_LED, ledAt, ledMustWake ? WAKE_FROM_BOTH : WAKE_FROM_WAIT);
+  else
+    wakeClear(WAKE_LED);
+
+  // [BLE OPTIMIZATION]
+  // Log download: pump the notifications every XFER_POLL_MS
+  // Connected: 50ms max sleep for responsiveness
+  // Advertising: 500ms max sleep to save power while maintaining visibility
+  if (isBLETransferActive())
+    wakeAt(WAKE_BLE, now + XFER_POLL_MS, WAKE_FROM_BOTH);
+  else if (halBleActive())
+    wakeAt(WAKE_BLE, now + (isBLEConnected() ? 50 : 500), WAKE_FROM_SLEEP);
+  else
+    wakeClear(WAKE_BLE);
+
+  // Button and touch interrupts signal the loop; only a gesture that is
+  // still being decoded needs polling
+  if (halButtonDown() || !btn.isIdle() || isTouching)
+  {
+    wakeAt(WAKE_INPUT, now + INPUT_POLL_MS);
+  }
+  else
+  {
+    wakeClear(WAKE_INPUT);
+    latencyInputIdle();
+    if (!buttonIrqArmed)
+    {
+      buttonIrqArmed = true;
+      gpio_intr_enable((gpio_num_t)GPKEY_PIN);
+    }
+  }
+
+  if (displayPending())
+    wakeAt(WAKE_DISPLAY, now);
+  else
+    wakeClear(WAKE_DISPLAY);
+
+  // The web server, OTA and the async connect are polled, not interrupt driven
+  if (halWiFiConnected() || wifiConnectRequested)
+    wakeAt(WAKE_WEB, now + WEB_POLL_MS);
+  else
+    wakeClear(WAKE_WEB);
+}
+
 // --- SLEEP WAKEUP CONFIGURATION (called once in setup) ---
 void setupSleepWakeup()
 {
@@ -396,6 +481,9 @@ void setupSleepWakeup()
   // For Light Sleep: Use gpio_wakeup (faster, supports any GPIO)
   gpio_wakeup_enable((gpio_num_t)GPKEY_PIN, GPIO_INTR_LOW_LEVEL);
   esp_sleep_enable_gpio_wakeup();
+  // Same level while awake, so a press ends the loop's wait
+  attachInterrupt(GPKEY_PIN, buttonISR, ONLOW);
+  buttonIrqArmed = true;
 
   // For Deep Sleep: configured in act_PowerOff
 
@@ -403,27 +491,40 @@ void setupSleepWakeup()
   // Already configured via touchAttachInterrupt in setup()
   esp_sleep_enable_touchpad_wakeup();
 
-  // 3. Power Management (Optional)
-  // esp_pm_config_esp32s3_t pm_config = {
-  //     .max_freq_mhz = 80,
-  //     .min_freq_mhz = 20, // Lower freq when idle
-  //     .light_sleep_enable = true
-  // };
-  // esp_pm_configure(&pm_config);
+  // 3. Power Management: frequency scaling is set up in initPower()
 }
 
 void loop()
 {
+  static bool monitorRegistered = false;
+  if (!monitorRegistered)
+  {
+    taskMonitorRegister(TASK_SLOT_UI, "ui");
+    monitorRegistered = true;
+  }
+  taskMonitorBegin(TASK_SLOT_UI);
+  uint32_t passStartUs = micros();
+
+  if (inputEdgePending)
+  {
+    latencyInputEdge(inputEdgeUs);
+    inputEdgePending = false;
+  }
+
   esp_task_wdt_reset();
 
   handleWiFiLogic();
 
-  if (WiFi.status() == WL_CONNECTED)
+  if (halWiFiConnected())
   {
     if (otaStarted)
       ArduinoOTA.handle();
     if (webServerStarted)
+    {
+      PROFILE_SCOPE(PROF_WEB);
       server.handleClient(); // [NEW] Handle Web Clients
+      handleWebUIStream();
+    }
   }
 
   btn.tick();
@@ -432,24 +533,40 @@ void loop()
   static unsigned long lastTouchCheck = 0;
   if (millis() - lastTouchCheck > 20)
   {
+    PROFILE_SCOPE(PROF_TOUCH);
     checkTouchInput();
     lastTouchCheck = millis();
   }
 
-  if (!envSensor.run())
-    checkBsecStatus(envSensor);
+  // Readings published by the sensor task since the last pass
+  SensorReadings reading;
+  while (halSensorReceive(reading))
+    handleNewReadings(reading);
+
+  {
+    PROFILE_SCOPE(PROF_BLE);
+    serviceBLE();
+  }
+
+  static int lastBsecStatus = BSEC_OK;
+  int bsecStatus = getSensorStatus().bsecStatus;
+  if (bsecStatus != lastBsecStatus)
+  {
+    checkBsecStatus(bsecStatus);
+    lastBsecStatus = bsecStatus;
+  }
 
   // --- LED STATUS UPDATE ---
   // Priority: Recording > Low Battery > WiFi > BLE > Idle
-  if (isRecording)
+  if (recordingSnapshot().active)
   {
     setLEDState(LED_RECORDING);
   }
-  else if (currentData.batteryPercent < 15)
+  else if (readingsSnapshot().batteryPercent < 15)
   {
     setLEDState(LED_LOW_BATTERY);
   }
-  else if (WiFi.status() == WL_CONNECTED)
+  else if (halWiFiConnected())
   {
     setLEDState(LED_WIFI_ACTIVE);
   }
@@ -462,7 +579,6 @@ void loop()
     setLEDState(LED_IDLE);
   }
   updateLED(); // Handle LED animations
-  updateBsecState(false);
 
   // --- TIMEOUT LOGIC ---
   unsigned long timeoutLimit = 15000;
@@ -476,12 +592,11 @@ void loop()
   if (isScreenOn && (millis() - lastActivityTime > timeoutLimit))
   {
     isScreenOn = false;
-    isScreenOn = false;
-    display.ssd1306_command(SSD1306_DISPLAYOFF);
+    displayPower(false);
 
     // Force Dashboard on timeout
-    if (appState == MENU || appState == CONFIRM_RESET)
-      appState = DASHBOARD;
+    if (ui.state == MENU || ui.state == CONFIRM_RESET)
+      ui.state = DASHBOARD;
 
     // Switch to deep eco mode if in eco mode
     if (sysConfig.opMode == MODE_ECO && !ecoModeDeepSleep)
@@ -494,96 +609,107 @@ void loop()
   // --- DRAWING LOGIC ---
   if (isScreenOn)
   {
-    bool shouldDraw = false;
     static unsigned long lastDraw = 0;
     unsigned long refreshRate = (sysConfig.opMode == MODE_REALTIME) ? 33 : 100;
 
-    if (millis() - lastDraw > refreshRate)
-      shouldDraw = true;
+    // Finish a frame that was held back for a sensor cycle
+    if (displayPending())
+      displayPush();
 
-    if (shouldDraw)
+    // Frame interval caps the rate; the dirty mask decides whether to draw
+    if (millis() - lastDraw > refreshRate)
     {
-      if (sysConfig.opMode == MODE_REALTIME)
+      checkUiChanges();
+      uint8_t bit = screenDirtyBit(ui.state);
+      if (uiDirty & bit)
       {
-        static unsigned long lastBatCheck = 0;
-        if (millis() - lastBatCheck > 1000)
+        uiDirty &= ~bit;
+        uiFrames.rendered++;
+
+        display.clearDisplay();
+        if (ui.state == DASHBOARD)
+          drawDashboard();
+        else if (ui.state == MENU)
+          drawMenu();
+        else if (ui.state == GRAPH)
+          drawGraph();
+        else if (ui.state == STATS)
+          drawStats();
+        else if (ui.state == CONFIRM_RESET)
+          drawConfirmation();
+
+        if (isLogWriterBusy() && ui.state != MENU)
         {
-          currentData.voltage = getBatteryVoltage();
-          lastBatCheck = millis();
+          display.fillRect(10, 50, 108, 14, SSD1306_BLACK);
+          display.drawRect(10, 50, 108, 14, SSD1306_WHITE);
+          display.setCursor(15, 53);
+          display.print("SAVING LOG...");
         }
-      }
 
-      display.clearDisplay();
-      if (appState == DASHBOARD)
-        drawDashboard();
-      else if (appState == MENU)
-        drawMenu();
-      else if (appState == GRAPH)
-        drawGraph();
-      else if (appState == STATS)
-        drawStats();
-      else if (appState == CONFIRM_RESET)
-        drawConfirmation();
-
-      if (isFlushing)
+        displayPush();
+      }
+      else
       {
-        display.fillRect(10, 50, 108, 14, SSD1306_BLACK);
-        display.drawRect(10, 50, 108, 14, SSD1306_WHITE);
-        display.setCursor(15, 53);
-        display.print("SAVING CSV...");
+        uiFrames.skipped++;
       }
-
-      display.display();
       lastDraw = millis();
     }
+
+    // Next time the screen can need the loop: a frame slot if something is
+    // already dirty, otherwise the icon poll; and the screen timeout
+    unsigned long now = millis();
+    unsigned long uiAt = (uiDirty & screenDirtyBit(ui.state)) ? lastDraw + refreshRate + 1 : lastDraw + UI_POLL_MS;
+    unsigned long timeoutAt = lastActivityTime + timeoutLimit + 1;
+    if ((long)(timeoutAt - uiAt) < 0)
+      uiAt = timeoutAt;
+    if ((long)(now - stayAwakeUntil) < 0 && (long)(stayAwakeUntil - uiAt) < 0)
+      uiAt = stayAwakeUntil;
+    wakeAt(WAKE_UI, uiAt, WAKE_FROM_WAIT);
+
+    if (millis() - uiFrames.windowStart >= 60000)
+    {
+      uiFrames.renderedPerMin = uiFrames.rendered;
+      uiFrames.skippedPerMin = uiFrames.skipped;
+      uiFrames.rendered = 0;
+      uiFrames.skipped = 0;
+      uiFrames.windowStart = millis();
+    }
   }
+  else
+  {
+    wakeClear(WAKE_UI);
+  }
+
+  taskMonitorEnd(TASK_SLOT_UI);
+  latencyLoopPass(micros() - passStartUs);
+
+  // --- WAIT / SLEEP LOGIC ---
+  // The loop blocks until the earliest deadline or an event. Interactive
+  // screens and REALTIME stay out of light sleep; otherwise it lasts until
+  // the earliest deadline that has to interrupt it (BSEC, LED, BLE, input, web).
+  armWakeDeadlines();
+  powerSetRadioActive(halWiFiConnected() || wifiConnectRequested || halBleActive());
 
-  // --- SLEEP LOGIC ---
-  bool preventSleep = (WiFi.status() == WL_CONNECTED) ||
-                      (wifiConnectRequested) ||
-                      (appState == MENU) ||
-                      (appState == GRAPH) ||
-                      (appState == STATS) ||
-                      (appState == CONFIRM_RESET) ||
+  bool slept = false;
+  bool preventSleep = (ui.state == MENU) ||
+                      (ui.state == GRAPH) ||
+                      (ui.state == STATS) ||
+                      (ui.state == CONFIRM_RESET) ||
                       ((long)(millis() - stayAwakeUntil) < 0) ||
-                      (digitalRead(GPKEY_PIN) == LOW) ||
-                      (isTouching) ||
                       (sysConfig.opMode == MODE_REALTIME);
+  powerHoldAwake(preventSleep);
 
-  if (!preventSleep)
+  // With tickless idle the wait below sleeps by itself
+  if (!preventSleep && !powerAutoLightSleep())
   {
-    long periodMs = 3000;
-    // In eco mode with screen off, use 5-minute intervals
-    if (sysConfig.opMode == MODE_ECO && ecoModeDeepSleep)
-      periodMs = 300000;
-
-    long timeSinceLast = (long)(millis() - lastBsecRun);
-    long timeUntilNext = periodMs - timeSinceLast;
+    WakeSource wakeSource;
+    uint32_t sleepMs = wakePlanSleep(millis(), wakeSource);
 
-    if (timeUntilNext > 200 && timeUntilNext <= periodMs)
+    if (sleepMs > 0)
     {
-      uint64_t sleepUs = (timeUntilNext - 10) * 1000;
-
-      // [BLE OPTIMIZATION]
-      // Connected: 50ms max sleep for responsiveness
-      // Advertising: 500ms max sleep to save power while maintaining visibility
-      if (isBLEActive())
-      {
-        if (isBLEConnected())
-        {
-          if (sleepUs > 50000)
-            sleepUs = 50000;
-        }
-        else
-        {
-          if (sleepUs > 500000)
-            sleepUs = 500000;
-        }
-      }
-
       // Wakeup sources (gpio, touch) configured once in setup
       // Only timer changes each cycle
-      esp_sleep_enable_timer_wakeup(sleepUs);
+      esp_sleep_enable_timer_wakeup((uint64_t)sleepMs * 1000);
 
       // Flush Serial before sleep to ensure all prints are sent
       // Serial.flush();
@@ -591,12 +717,21 @@ void loop()
       // Optional: Disable Serial for power saving (uncomment if not debugging)
       // Serial.end();
 
+      // Light sleep stalls both cores: never cut a sensor-task I2C
+      // transaction in half
+      int64_t sleepStartUs = esp_timer_get_time();
+      i2cBusLock();
       esp_light_sleep_start();
+      i2cBusUnlock();
+      slept = true;
+      uint64_t sleptUs = esp_timer_get_time() - sleepStartUs;
+      powerNoteLightSleep(sleptUs);
 
       // Optional: Re-enable Serial after sleep
       // Serial.begin(115200);
 
       esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
+      wakeNoteSleep(wakeSource, sleptUs / 1000, cause != ESP_SLEEP_WAKEUP_TIMER);
       if (cause == ESP_SLEEP_WAKEUP_GPIO || cause == ESP_SLEEP_WAKEUP_TOUCHPAD || cause == ESP_SLEEP_WAKEUP_EXT1)
       {
         wakeUpScreen();
@@ -610,6 +745,11 @@ void loop()
       }
     }
   }
+
+  // Block until the next deadline or an event instead of spinning, so the
+  // idle task can scale the CPU down (and sleep, with tickless idle)
+  if (!slept)
+    powerWaitLoop(wakePlanWait(millis(), POWER_MAX_WAIT_MS));
 }
 
 // --- ASYNC WIFI LOGIC ---
@@ -618,14 +758,14 @@ void handleWiFiLogic()
   if (!wifiConnectRequested)
     return;
 
-  if (millis() - wifiConnectionStart > 10000 && WiFi.status() != WL_CONNECTED)
+  if (millis() - wifiConnectionStart > 10000 && !halWiFiConnected())
   {
     wifiConnectRequested = false;
     WiFi.disconnect(true);
     WiFi.mode(WIFI_OFF);
   }
 
-  if (WiFi.status() == WL_CONNECTED)
+  if (halWiFiConnected())
   {
     if (!otaStarted)
     {
@@ -650,12 +790,13 @@ void handleWiFiLogic()
 // --- MENU ACTIONS ---
 void act_EnterGraph()
 {
-  appState = GRAPH;
+  ui.state = GRAPH;
 }
 
 void act_EnterStats()
 {
-  appState = STATS;
+  ui.state = STATS;
+  ui.statsPage = 0;
 }
 
 void act_ForceSave()
@@ -665,10 +806,10 @@ void act_ForceSave()
   display.println(F("BSEC STATE SAVE"));
   display.println(F("----------------"));
   display.println(F("Querying Algo..."));
-  display.display();
+  displayPush();
 
-  // Attempt save with force=true
-  bool success = updateBsecState(true);
+  // Attempt save with force=true (runs on the sensor task)
+  bool success = sensorRequest(SENSOR_CMD_SAVE_STATE, 5000);
 
   display.setCursor(0, 30);
   if (success)
@@ -686,19 +827,19 @@ void act_ForceSave()
     display.println(F("Too Low (<1)"));
   }
 
-  display.display();
+  displayPush();
   delay(2500);
-  appState = DASHBOARD;
+  ui.state = DASHBOARD;
 }
 
 void act_ToggleWiFi()
 {
   display.clearDisplay();
   display.setCursor(0, 0);
-  if (WiFi.status() == WL_CONNECTED)
+  if (halWiFiConnected())
   {
     display.println(F("Stopping WiFi..."));
-    display.display();
+    displayPush();
     WiFi.disconnect(true);
     WiFi.mode(WIFI_OFF);
     otaStarted = false;
@@ -710,14 +851,14 @@ void act_ToggleWiFi()
   else
   {
     display.println(F("Connecting..."));
-    display.display();
+    displayPush();
     WiFi.mode(WIFI_STA);
     // WiFi.config(local_IP, gateway, subnet, primaryDNS);
     WiFi.begin(ssid, password);
     wifiConnectRequested = true;
     wifiConnectionStart = millis();
   }
-  appState = DASHBOARD;
+  ui.state = DASHBOARD;
 }
 
 void act_ToggleBLE()
@@ -725,20 +866,20 @@ void act_ToggleBLE()
   display.clearDisplay();
   display.setCursor(0, 0);
 
-  if (isBLEActive())
+  if (halBleActive())
   {
     display.println(F("Stopping BLE..."));
-    display.display();
+    displayPush();
     stopBLE();
   }
   else
   {
     display.println(F("Starting BLE..."));
-    display.display();
+    displayPush();
     setupBLE();
   }
   delay(500);
-  appState = DASHBOARD;
+  ui.state = DASHBOARD;
 }
 
 const char *get_BLELabel()
@@ -748,34 +889,19 @@ const char *get_BLELabel()
 
 void act_ToggleRecord()
 {
-  if (isRecording)
-  {
-    // Stop Recording
-    flushLog(); // Flush remaining data
-    isRecording = false;
-    currentLogFileName[0] = '\0';
-  }
+  // The logging pipeline belongs to the sensor task; wait so the menu and
+  // icons show the new state. Stopping flushes and closes the file.
+  if (recordingSnapshot().active)
+    sensorRequest(SENSOR_CMD_RECORD_STOP, 10000);
   else
-  {
-    // Start Recording
-    // Generate filename
-    char buf[32];
-    sprintf(buf, "/log_%03d.csv", sysConfig.nextLogIndex);
-    snprintf(currentLogFileName, sizeof(currentLogFileName), "%s", buf);
-
-    sysConfig.nextLogIndex++;
-    saveConfig(); // Save next index
-
-    isRecording = true;
-    logHead = 0; // Reset buffer
-  }
-  appState = DASHBOARD;
+    sensorRequest(SENSOR_CMD_RECORD_START, 10000);
+  ui.state = DASHBOARD;
 }
 
 const char *get_RecordLabel()
 {
   static char buf[32];
-  if (isRecording)
+  if (recordingSnapshot().active)
   {
     snprintf(buf, sizeof(buf), "Stop Rec (%d)", sysConfig.nextLogIndex - 1);
     return buf;
@@ -783,6 +909,54 @@ const char *get_RecordLabel()
   return "Start Rec";
 }
 
+void act_ToggleFormat()
+{
+  // Format is fixed for the duration of a recording
+  if (recordingSnapshot().active)
+    return;
+
+  if (sysConfig.logFormat == LOG_FORMAT_CSV)
+    sysConfig.logFormat = LOG_FORMAT_BIN;
+  else
+    sysConfig.logFormat = LOG_FORMAT_CSV;
+  saveConfig();
+}
+
+void act_ToggleDemo()
+{
+  display.clearDisplay();
+  display.setCursor(0, 0);
+  if (getSensorStatus().replaying)
+  {
+    sensorSend(SENSOR_CMD_REPLAY_STOP);
+    display.println(F("Demo stopped."));
+  }
+  else if (sensorReplay("", 1.0f))
+  {
+    // The sensor task picks the newest recording and loops it
+    display.println(F("Demo mode:"));
+    display.println(F("Replaying the last"));
+    display.println(F("recording..."));
+  }
+  else
+  {
+    display.println(F("Demo failed."));
+  }
+  displayPush();
+  delay(1000);
+  ui.state = DASHBOARD;
+}
+
+const char *get_DemoLabel()
+{
+  return getSensorStatus().replaying ? "Stop Demo" : "Demo Mode";
+}
+
+const char *get_FormatLabel()
+{
+  return (sysConfig.logFormat == LOG_FORMAT_BIN) ? "Fmt: BIN" : "Fmt: CSV";
+}
+
 void act_ChangeMode()
 {
   if (sysConfig.opMode == MODE_REALTIME)
@@ -793,7 +967,7 @@ void act_ChangeMode()
     sysConfig.opMode = MODE_REALTIME;
   saveConfig();
   applyConfigMode();
-  appState = DASHBOARD;
+  ui.state = DASHBOARD;
 }
 
 void act_ChangeTimeout()
@@ -812,18 +986,28 @@ void act_ChangeTimeout()
     display.print("15s");
   else
     display.print("None");
-  display.display();
+  displayPush();
   delay(1000);
 }
 
 // act_ResetCalib moved to use CONFIRM_RESET state
 
+// Clears the latency histograms (and the profiler) for a fresh measurement
+void act_ResetTiming()
+{
+  resetLatencyStats();
+#if PROFILER_ENABLED
+  resetProfileStats();
+#endif
+  flashLED(0, 255, 0, 100);
+}
+
 void act_Reboot()
 {
   display.clearDisplay();
   display.setCursor(0, 25);
   display.println("Rebooting...");
-  display.display();
+  displayPush();
   delay(500);
   ESP.restart();
 }
@@ -833,11 +1017,11 @@ void act_PowerOff()
   display.clearDisplay();
   display.setCursor(0, 25);
   display.println("Powering Off...");
-  display.display();
+  displayPush();
   delay(1000);
 
   // Turn off display
-  display.ssd1306_command(SSD1306_DISPLAYOFF);
+  displayPower(false);
 
   // Isolate GPIOs to prevent leakage during Deep Sleep
   // I2C Pins should be isolated or held high if they have pull-ups
@@ -863,14 +1047,14 @@ void act_PowerOff()
 
 void act_Exit()
 {
-  appState = DASHBOARD;
+  ui.state = DASHBOARD;
 }
 
 // Dynamic Label Getters
 const char *get_WiFiLabel()
 {
   static char buf[32];
-  if (WiFi.status() == WL_CONNECTED)
+  if (halWiFiConnected())
   {
     IPAddress ip = WiFi.localIP();
     snprintf(buf, sizeof(buf), "WiFi: %d.%d.%d.%d", ip[0], ip[1], ip[2], ip[3]);
@@ -906,7 +1090,7 @@ void checkTouchInput()
 {
   int val = 0;
   for (int i = 0; i < 4; i++)
-    val += touchRead(TOUCH_PIN);
+    val += halTouchRead();
   val /= 4;
 
   unsigned long now = millis();
@@ -919,6 +1103,7 @@ void checkTouchInput()
       isTouching = true;
       touchStartTime = now;
       touchHandled = false;
+      latencyInputEdge(micros()); // Below the wake threshold: no interrupt stamp
     }
   }
   // 2. Touch Release
@@ -946,62 +1131,54 @@ void checkTouchInput()
 
 void applyConfigMode()
 {
-  bsecSensor physicalSensors[] = {
-      BSEC_OUTPUT_RAW_TEMPERATURE, BSEC_OUTPUT_RAW_PRESSURE, BSEC_OUTPUT_RAW_HUMIDITY};
-  bsecSensor gasSensors[] = {
-      BSEC_OUTPUT_IAQ, BSEC_OUTPUT_CO2_EQUIVALENT, BSEC_OUTPUT_BREATH_VOC_EQUIVALENT};
-
+  float sampleRate = BSEC_SAMPLE_RATE_LP;
   if (sysConfig.opMode == MODE_REALTIME)
+    sampleRate = BSEC_SAMPLE_RATE_CONT;
+  else if (sysConfig.opMode == MODE_ECO && ecoModeDeepSleep)
+    sampleRate = BSEC_SAMPLE_RATE_ULP; // Screen off: 5-minute intervals
+
+  // The subscription itself is changed on the sensor task
+  sensorSend(SENSOR_CMD_SET_RATE, sampleRate);
+
+  // Lets the display scheduler keep clear of the next measurement
+  i2cBusSetSensorPeriod((uint32_t)(1000.0f / sampleRate));
+
+  // Bound what a power loss can take: ~30 s of REALTIME, ~60 s of NORMAL.
+  // ECO batches in RTC memory (LogStaging) and commits each drain itself.
+  if (sysConfig.opMode == MODE_ECO)
   {
-    bsecSensor allSensors[] = {
-        BSEC_OUTPUT_IAQ, BSEC_OUTPUT_CO2_EQUIVALENT,
-        BSEC_OUTPUT_RAW_TEMPERATURE, BSEC_OUTPUT_RAW_PRESSURE,
-        BSEC_OUTPUT_RAW_HUMIDITY};
-    envSensor.updateSubscription(allSensors, ARRAY_LEN(allSensors), BSEC_SAMPLE_RATE_CONT);
-  }
-  else if (sysConfig.opMode == MODE_NORMAL)
-  {
-    bsecSensor allSensors[] = {
-        BSEC_OUTPUT_IAQ, BSEC_OUTPUT_CO2_EQUIVALENT,
-        BSEC_OUTPUT_RAW_TEMPERATURE, BSEC_OUTPUT_RAW_PRESSURE,
-        BSEC_OUTPUT_RAW_HUMIDITY};
-    envSensor.updateSubscription(allSensors, ARRAY_LEN(allSensors), BSEC_SAMPLE_RATE_LP);
+    logWriterSetCommitInterval(900000);
+    logWriterSetSyncBatch(0);
   }
-  else if (sysConfig.opMode == MODE_ECO)
+  else
   {
-    if (ecoModeDeepSleep)
-    {
-      // Screen off: use ULP for everything (5-minute intervals)
-      bsecSensor allSensors[] = {
-          BSEC_OUTPUT_IAQ, BSEC_OUTPUT_CO2_EQUIVALENT,
-          BSEC_OUTPUT_RAW_TEMPERATURE, BSEC_OUTPUT_RAW_PRESSURE,
-          BSEC_OUTPUT_RAW_HUMIDITY};
-      envSensor.updateSubscription(allSensors, ARRAY_LEN(allSensors), BSEC_SAMPLE_RATE_ULP);
-    }
-    else
-    {
-      // Screen on: behave like normal mode (3-second intervals)
-      bsecSensor allSensors[] = {
-          BSEC_OUTPUT_IAQ, BSEC_OUTPUT_CO2_EQUIVALENT,
-          BSEC_OUTPUT_RAW_TEMPERATURE, BSEC_OUTPUT_RAW_PRESSURE,
-          BSEC_OUTPUT_RAW_HUMIDITY};
-      envSensor.updateSubscription(allSensors, ARRAY_LEN(allSensors), BSEC_SAMPLE_RATE_LP);
-    }
+    logWriterSetCommitInterval(LOG_COMMIT_INTERVAL_MS);
+    logWriterSetSyncBatch(sysConfig.opMode == MODE_REALTIME ? 30 : 20);
   }
 }
 
+// The loop and the sensor task (next log index) both save the config
+static SemaphoreHandle_t configMutex = nullptr;
+
 void saveConfig()
 {
+  if (configMutex)
+    xSemaphoreTake(configMutex, portMAX_DELAY);
+  SystemConfig copy = sysConfig;
   File file = LittleFS.open("/sys_config.bin", "w");
   if (file)
   {
-    file.write((uint8_t *)&sysConfig, sizeof(SystemConfig));
+    file.write((uint8_t *)&copy, sizeof(SystemConfig));
     file.close();
   }
+  if (configMutex)
+    xSemaphoreGive(configMutex);
 }
 
 void loadConfig()
 {
+  if (!configMutex)
+    configMutex = xSemaphoreCreateMutex();
   if (LittleFS.exists("/sys_config.bin"))
   {
     File file = LittleFS.open("/sys_config.bin", "r");
@@ -1013,195 +1190,161 @@ void loadConfig()
   }
 }
 
-void wakeUpScreen()
+void markDirty(uint8_t screens)
 {
-  lastActivityTime = millis();
-  if (!isScreenOn)
-  {
-    isScreenOn = true;
-    display.ssd1306_command(SSD1306_DISPLAYON);
-    ignoreInputUntil = millis() + 500;
-    // Exit deep eco mode if in eco mode
-    if (sysConfig.opMode == MODE_ECO && ecoModeDeepSleep)
-    {
-      ecoModeDeepSleep = false;
-      applyConfigMode();
-    }
-  }
+  uiDirty |= screens;
 }
 
-void newDataCallback(const bme68xData data, const bsecOutputs outputs, Bsec2 capture)
+uint8_t screenDirtyBit(UiState state)
 {
-  if (!outputs.nOutputs)
-    return;
-  lastBsecRun = millis();
+  switch (state)
+  {
+  case DASHBOARD:
+    return UI_DIRTY_DASHBOARD;
+  case MENU:
+    return UI_DIRTY_MENU;
+  case GRAPH:
+    return UI_DIRTY_GRAPH;
+  case STATS:
+    return UI_DIRTY_STATS;
+  case CONFIRM_RESET:
+    return UI_DIRTY_CONFIRM;
+  }
+  return UI_DIRTY_ALL;
+}
 
-  for (uint8_t i = 0; i < outputs.nOutputs; i++)
+// Polls state that has no event of its own: status icons, menu labels,
+// the save overlay and time-driven content
+void checkUiChanges()
+{
+  static uint32_t lastIcons = 0xFFFFFFFF;
+  static UiState lastState = DASHBOARD;
+  static unsigned long lastBlink = 0;
+  static unsigned long lastLive = 0;
+  static long lastSaveMins = -1;
+
+  bool wifiUp = halWiFiConnected();
+  int rssiBars = 0;
+  if (wifiUp)
   {
-    const bsecData output = outputs.output[i];
-    switch (output.sensor_id)
-    {
-    case BSEC_OUTPUT_RAW_TEMPERATURE:
-      currentData.temp = output.signal;
-      if (output.signal > sysStats.maxTemp)
-        sysStats.maxTemp = output.signal;
-      break;
-    case BSEC_OUTPUT_RAW_PRESSURE:
-      currentData.press = output.signal;
-      break;
-    case BSEC_OUTPUT_RAW_HUMIDITY:
-      currentData.hum = output.signal;
-      break;
-    case BSEC_OUTPUT_IAQ:
-      currentData.iaq = output.signal;
-      currentData.accuracy = output.accuracy;
-      break;
-    case BSEC_OUTPUT_CO2_EQUIVALENT:
-      currentData.co2 = output.signal;
-      if (output.signal > sysStats.maxCO2)
-        sysStats.maxCO2 = output.signal;
-      break;
-    }
+    int rssi = WiFi.RSSI();
+    rssiBars = (rssi > -90) + (rssi > -80) + (rssi > -70);
   }
 
-  updateAllGraphBuffers();
-  updateBLEData(currentData.temp, currentData.hum, currentData.press, currentData.iaq, currentData.co2);
-
-  // [LOGGING] Fill Buffer
-  if (isRecording)
+  SensorStatus sensor = getSensorStatus();
+  uint32_t icons = (wifiUp ? 0x01 : 0) |
+                   (wifiConnectRequested ? 0x02 : 0) |
+                   (halBleActive() ? 0x04 : 0) |
+                   (isBLEConnected() ? 0x08 : 0) |
+                   (recordingSnapshot().active ? 0x10 : 0) |
+                   (isLogWriterBusy() ? 0x20 : 0) |
+                   (sensor.isSaving ? 0x40 : 0) |
+                   (sensor.replaying ? 0x80 : 0) |
+                   (rssiBars << 8);
+  if (icons != lastIcons)
   {
-    logBuffer[logHead].timestamp = millis();
-    logBuffer[logHead].iaq = currentData.iaq;
-    logBuffer[logHead].co2 = currentData.co2;
-    logBuffer[logHead].temp = currentData.temp;
-    logBuffer[logHead].hum = currentData.hum;
-    logHead++;
-
-    // [LOGGING] Trigger Flush if full
-    if (logHead >= LOG_BUFFER_SIZE)
-    {
-      flushLog();
-    }
-    else if (sysConfig.opMode == MODE_ECO && logHead >= 1)
-    {
-      flushLog();
-    }
+    markDirty(UI_DIRTY_ALL);
+    lastIcons = icons;
   }
 
-  if (sysConfig.opMode != MODE_REALTIME)
-    currentData.voltage = getBatteryVoltage();
-
-  if (isSaving && !stateLoaded)
-    stateLoaded = true;
-
-  /*
-  if (appState == DASHBOARD && isScreenOn)
+  // Modal actions change ui.state without going through the input handlers
+  if (ui.state != lastState)
   {
-    display.clearDisplay();
-    drawDashboard();
-    display.display();
+    markDirty(screenDirtyBit(ui.state));
+    lastState = ui.state;
   }
-    */
-}
-
-// --- FLUSH BUFFER TO CSV ---
-void flushLog()
-{
-  isFlushing = true;
 
-  if (isScreenOn && appState != MENU)
+  if (wifiConnectRequested && millis() - lastBlink >= UI_BLINK_MS)
   {
-    display.fillRect(10, 50, 108, 14, SSD1306_BLACK);
-    display.drawRect(10, 50, 108, 14, SSD1306_WHITE);
-    display.setCursor(15, 53);
-    display.print("SAVING CSV...");
-    display.display();
+    markDirty(UI_DIRTY_DASHBOARD);
+    lastBlink = millis();
   }
 
-  if (currentLogFileName[0] == '\0')
+  if (ui.state == STATS && millis() - lastLive >= UI_LIVE_STATS_MS)
   {
-    isFlushing = false;
-    return;
+    markDirty(UI_DIRTY_STATS);
+    lastLive = millis();
   }
 
-  File file = LittleFS.open(currentLogFileName, "a");
-  if (file)
+  // Menu header shows minutes since the last BSEC state save
+  long saveMins = (millis() - sensor.lastStateSaveMs) / 60000;
+  if (saveMins != lastSaveMins)
   {
-    if (file.size() == 0)
-    {
-      file.println("Time(ms),IAQ,CO2,Temp,Hum");
-    }
-
-    // [OPTIMIZATION] Buffer writes to reduce filesystem overhead
-    // Instead of calling file.print() for every line, we accumulate
-    // lines into a larger buffer and write in chunks.
-    const int BUF_SIZE = 1024;
-    char writeBuffer[BUF_SIZE];
-    int writeOffset = 0;
+    markDirty(UI_DIRTY_MENU);
+    lastSaveMins = saveMins;
+  }
+}
 
-    for (int i = 0; i < logHead; i++)
+void wakeUpScreen()
+{
+  lastActivityTime = millis();
+  if (!isScreenOn)
+  {
+    isScreenOn = true;
+    displayPower(true);
+    markDirty(UI_DIRTY_ALL);
+    ignoreInputUntil = millis() + 500;
+    // Exit deep eco mode if in eco mode
+    if (sysConfig.opMode == MODE_ECO && ecoModeDeepSleep)
     {
-      esp_task_wdt_reset();
-      char lineBuf[128];
-      int len = snprintf(lineBuf, sizeof(lineBuf), "%lu,%.2f,%.2f,%.2f,%.2f\n",
-                         logBuffer[i].timestamp,
-                         logBuffer[i].iaq,
-                         logBuffer[i].co2,
-                         logBuffer[i].temp,
-                         logBuffer[i].hum);
-
-      // If adding this line would overflow, flush the buffer first
-      if (writeOffset + len >= BUF_SIZE)
-      {
-        file.write((uint8_t *)writeBuffer, writeOffset);
-        writeOffset = 0;
-      }
-
-      memcpy(writeBuffer + writeOffset, lineBuf, len);
-      writeOffset += len;
+      ecoModeDeepSleep = false;
+      applyConfigMode();
     }
+  }
+}
 
-    // Flush remaining data
-    if (writeOffset > 0)
-    {
-      file.write((uint8_t *)writeBuffer, writeOffset);
-    }
+// Loop side of a new sample; logging already happened on the sensor task
+// and the latest values are readable through readingsSnapshot()
+void handleNewReadings(const SensorReadings &r)
+{
+  if (r.temp > sysStats.maxTemp)
+    sysStats.maxTemp = r.temp;
+  if (r.co2 > sysStats.maxCO2)
+    sysStats.maxCO2 = r.co2;
 
-    file.close();
+  // One timestamp for the graph and the stream, so the dashboard can match
+  // live samples against /api/history
+  uint32_t now = millis();
+  updateAllGraphBuffers(r, now);
+  {
+    PROFILE_SCOPE(PROF_BLE);
+    updateBLEData(r);
   }
 
-  logHead = 0;
-  isFlushing = false;
+  // Push to /api/stream clients as soon as the sample is complete
+  if (webServerStarted)
+    publishWebUI(r, now);
+
+  // New readings and buffer fill show on every screen but the confirm prompt
+  markDirty(UI_DIRTY_DASHBOARD | UI_DIRTY_MENU | UI_DIRTY_GRAPH | UI_DIRTY_STATS);
 }
 
 // --- MULTI-GRAPH BUFFER UPDATE ---
-void updateAllGraphBuffers()
+void updateAllGraphBuffers(const SensorReadings &r, uint32_t nowMs)
 {
-  graphBuffers[0][graphHead] = currentData.iaq;
-  graphBuffers[1][graphHead] = currentData.co2;
-  graphBuffers[2][graphHead] = currentData.temp;
-  graphBuffers[3][graphHead] = currentData.hum;
-  graphBuffers[4][graphHead] = currentData.press; // Display in Pa
-
-  graphHead++;
-  if (graphHead >= GRAPH_WIDTH)
-  {
-    graphHead = 0;
-    graphFilled = true;
-  }
+  float values[GRAPH_COUNT] = {
+      r.iaq,
+      r.co2,
+      r.temp,
+      r.hum,
+      r.press}; // Display in Pa
+
+  graphHistoryAdd(nowMs, values);
 }
 
 void drawDashboard()
 {
+  SensorReadings cur = readingsSnapshot();
+
   display.setCursor(0, 0);
   display.print("IAQ:");
-  display.print((int)currentData.iaq);
+  display.print((int)cur.iaq);
   display.setCursor(75, 0);
-  display.print(currentData.voltage, 3);
+  display.print(cur.voltage, 3);
   display.print("V");
 
-  static bool dotState = false;
-  dotState = !dotState;
+  // Blink phase comes from the clock so it doesn't depend on the redraw rate
+  bool dotState = (millis() / UI_BLINK_MS) & 1;
 
   // --- ICONS ---
   // Start from right edge
@@ -1209,14 +1352,22 @@ void drawDashboard()
   int iconY = 0;
 
   // 1. Recording Icon (if active)
-  if (isRecording)
+  if (recordingSnapshot().active)
   {
     display.fillCircle(iconX - 2, iconY + 4, 3, SSD1306_WHITE);
     iconX -= 10;
   }
 
+  // Demo mode: readings are replayed from a recording
+  if (getSensorStatus().replaying)
+  {
+    display.setCursor(iconX - 4, iconY);
+    display.print('D');
+    iconX -= 10;
+  }
+
   // 2. WiFi Icon (if connected or connecting)
-  if (WiFi.status() == WL_CONNECTED)
+  if (halWiFiConnected())
   {
     int rssi = WiFi.RSSI();
     display.drawLine(iconX, iconY + 6, iconX, iconY + 6, SSD1306_WHITE);
@@ -1236,7 +1387,7 @@ void drawDashboard()
   }
 
   // 3. BLE Icon (if active)
-  if (isBLEActive())
+  if (halBleActive())
   {
     display.drawLine(iconX, iconY, iconX + 4, iconY + 4, SSD1306_WHITE);
     display.drawLine(iconX + 4, iconY + 4, iconX + 2, iconY + 6, SSD1306_WHITE);
@@ -1254,16 +1405,16 @@ void drawDashboard()
 
   display.setCursor(0, 14);
   display.print("T: ");
-  display.print(currentData.temp, 2);
+  display.print(cur.temp, 2);
   display.println(" C");
   display.print("H: ");
-  display.print(currentData.hum, 2);
+  display.print(cur.hum, 2);
   display.println(" %");
   display.print("P: ");
-  display.print(currentData.press, 2);
+  display.print(cur.press, 2);
   display.println(" Pa");
   display.print("CO2: ");
-  display.print(currentData.co2, 0);
+  display.print(cur.co2, 0);
   display.println(" ppm");
 
   display.setCursor(0, 54);
@@ -1275,20 +1426,35 @@ void drawDashboard()
     display.print("Eco");
 
   display.setCursor(35, 54);
-  display.print(currentData.batteryPercent);
+  display.print(cur.batteryPercent);
   display.print("%");
 
   display.setCursor(75, 54);
   display.print("Acc:");
-  display.print(currentData.accuracy);
+  display.print(cur.accuracy);
 
-  if (isSaving)
+  if (getSensorStatus().isSaving)
   {
     display.setCursor(118, 54);
     display.print("S");
   }
 }
 
+// "B:" indicator: RAM buffer fill, or samples staged in RTC memory ("R")
+void drawBufferStat()
+{
+  display.print("B:");
+  if (logStageCount() > 0 || (recordingSnapshot().active && sysConfig.opMode == MODE_ECO))
+  {
+    display.print(logStageCount());
+    display.print("R");
+    return;
+  }
+  int pct = (logWriterPending() * 100) / LOG_BUFFER_SIZE;
+  display.print(pct);
+  display.print("%");
+}
+
 void drawMenu()
 {
   display.setCursor(0, 0);
@@ -1296,9 +1462,10 @@ void drawMenu()
 
   // RESTORED SAVE TIMER + BUFFER
   display.setCursor(60, 0);
-  if (stateLoaded || hasSavedSinceBoot)
+  SensorStatus sensor = getSensorStatus();
+  if (sensor.stateLoaded || sensor.hasSavedSinceBoot)
   {
-    long mins = (millis() - lastStateSave) / 60000;
+    long mins = (millis() - sensor.lastStateSaveMs) / 60000;
     display.print("S:");
     display.print(mins);
     display.print("m ");
@@ -1309,23 +1476,20 @@ void drawMenu()
   }
 
   // Buffer Stat
-  int pct = (logHead * 100) / LOG_BUFFER_SIZE;
-  display.print("B:");
-  display.print(pct);
-  display.print("%");
+  drawBufferStat();
 
   display.drawLine(0, 10, 128, 10, SSD1306_WHITE);
 
   int startY = 15;
-  for (int i = 0; i < 5; i++)
+  for (int i = 0; i < UI_MENU_ROWS; i++)
   {
-    int itemIndex = i + menuScrollOffset;
+    int itemIndex = i + ui.menuScrollOffset;
     if (itemIndex >= menuLength)
       break;
 
     int lineY = startY + (i * 10);
 
-    if (itemIndex == selectedItem)
+    if (itemIndex == ui.selectedItem)
     {
       display.setCursor(0, lineY);
       display.print("> ");
@@ -1352,99 +1516,63 @@ void drawGraph()
 {
   display.clearDisplay();
 
-  float *currentBuffer = graphBuffers[activeGraph];
-
   // Header
   display.setCursor(0, 0);
-  display.print(graphLabels[activeGraph]);
+  display.print(graphLabels[ui.activeGraph]);
 
+  SensorReadings cur = readingsSnapshot();
   float curVal = 0;
-  if (activeGraph == 0)
-    curVal = currentData.iaq;
-  else if (activeGraph == 1)
-    curVal = currentData.co2;
-  else if (activeGraph == 2)
-    curVal = currentData.temp;
-  else if (activeGraph == 3)
-    curVal = currentData.hum;
-  else if (activeGraph == 4)
-    curVal = currentData.press; // Display in Pa
+  if (ui.activeGraph == 0)
+    curVal = cur.iaq;
+  else if (ui.activeGraph == 1)
+    curVal = cur.co2;
+  else if (ui.activeGraph == 2)
+    curVal = cur.temp;
+  else if (ui.activeGraph == 3)
+    curVal = cur.hum;
+  else if (ui.activeGraph == 4)
+    curVal = cur.press; // Display in Pa
 
   display.print(" ");
   display.print((int)curVal);
-  display.print(graphUnits[activeGraph]);
+  display.print(graphUnits[ui.activeGraph]);
 
   // Buffer Status in Corner
   display.setCursor(90, 0);
-  int pct = (logHead * 100) / LOG_BUFFER_SIZE;
-  display.print("B:");
-  display.print(pct);
-  display.print("%");
+  drawBufferStat();
 
   display.drawLine(0, 10, 128, 10, SSD1306_WHITE);
 
-  float minVal = 100000;
-  float maxVal = -100000;
+  // Plot rows are only recomputed when a sample arrives or the view changes;
+  // redraws for icons or the overlay reuse them
+  static GraphColumns cols;
+  graphSpanColumns(ui.activeSpan, ui.activeGraph, GRAPH_Y_START, GRAPH_Y_START + GRAPH_HEIGHT, cols);
 
-  int limit = graphFilled ? GRAPH_WIDTH : graphHead;
-  if (limit == 0)
+  if (cols.count == 0)
   {
     display.setCursor(10, 30);
     display.print("No Data");
     return;
   }
 
-  for (int i = 0; i < limit; i++)
-  {
-    if (currentBuffer[i] < minVal)
-      minVal = currentBuffer[i];
-    if (currentBuffer[i] > maxVal)
-      maxVal = currentBuffer[i];
-  }
-
-  if (maxVal - minVal < 2)
-  {
-    maxVal += 1;
-    minVal -= 1;
-  }
-
   display.setTextSize(1);
   display.setCursor(0, 20);
-  display.print((int)maxVal);
+  display.print((int)cols.maxV);
   display.setCursor(0, 56);
-  display.print((int)minVal);
+  display.print((int)cols.minV);
 
-  int idx = graphFilled ? graphHead : 0;
+  // Time per point, between the axis labels
+  display.setCursor(0, 38);
+  display.print(graphSpanLabel(ui.activeSpan));
 
-  for (int x = 0; x < GRAPH_WIDTH - 1; x++)
+  for (int x = 0; x < cols.count; x++)
   {
-    float val = currentBuffer[idx];
-
-    int y = 60 - ((val - minVal) / (maxVal - minVal)) * GRAPH_HEIGHT;
-    if (y < 20)
-      y = 20;
-    if (y > 60)
-      y = 60;
+    // Aggregated spans: min/max envelope behind the mean line
+    if (ui.activeSpan > 0 && cols.yBottom[x] > cols.yTop[x])
+      display.drawFastVLine(GRAPH_X_START + x, cols.yTop[x], cols.yBottom[x] - cols.yTop[x] + 1, SSD1306_WHITE);
 
-    int nextIdx = idx + 1;
-    if (nextIdx >= GRAPH_WIDTH)
-      nextIdx = 0;
-
-    if (x < limit - 1)
-    {
-      float nextVal = currentBuffer[nextIdx];
-      int nextY = 60 - ((nextVal - minVal) / (maxVal - minVal)) * GRAPH_HEIGHT;
-      if (nextY < 20)
-        nextY = 20;
-      if (nextY > 60)
-        nextY = 60;
-
-      display.drawLine(GRAPH_X_START + x, y, GRAPH_X_START + x + 1, nextY, SSD1306_WHITE);
-    }
-
-    idx++;
-    if (idx >= GRAPH_WIDTH)
-      idx = 0;
+    if (x < cols.count - 1)
+      display.drawLine(GRAPH_X_START + x, cols.yMean[x], GRAPH_X_START + x + 1, cols.yMean[x + 1], SSD1306_WHITE);
   }
 }
 
@@ -1454,8 +1582,40 @@ void drawStats()
   display.clearDisplay();
   display.setCursor(0, 0);
   display.println(F("-- STATS --"));
+  display.setCursor(104, 0);
+  display.print(ui.statsPage + 1);
+  display.print("/");
+  display.print(STATS_PAGE_COUNT);
   display.drawLine(0, 10, 128, 10, SSD1306_WHITE);
 
+  if (ui.statsPage == 1)
+  {
+    drawDisplayStats();
+    return;
+  }
+  if (ui.statsPage == 2)
+  {
+    drawTaskStats();
+    return;
+  }
+  if (ui.statsPage == 3)
+  {
+    drawPowerStats();
+    return;
+  }
+  if (ui.statsPage == 4)
+  {
+    drawLatencyStats();
+    return;
+  }
+#if PROFILER_ENABLED
+  if (ui.statsPage == 5)
+  {
+    drawProfileStats();
+    return;
+  }
+#endif
+
   unsigned long uptimeSec = (millis() - sysStats.bootTime) / 1000;
   unsigned long hours = uptimeSec / 3600;
   unsigned long mins = (uptimeSec % 3600) / 60;
@@ -1476,124 +1636,157 @@ void drawStats()
 
   display.setCursor(0, 51);
   display.print(F("Touch:"));
-  display.print(touchRead(TOUCH_PIN));
+  display.print(halTouchRead());
   display.print(F(" | V:"));
-  display.print(currentData.voltage, 2);
+  display.print(readingsSnapshot().voltage, 2);
 }
 
-void drawConfirmation()
+// Stats page 2: display pipeline cost
+void drawDisplayStats()
 {
-  display.clearDisplay();
-  display.setCursor(0, 0);
-  display.println(F("RESET CALIBRATION?"));
-  display.drawLine(0, 10, 128, 10, SSD1306_WHITE);
+  DisplayStats ds = getDisplayStats();
 
-  display.setCursor(0, 25);
-  display.println(F("Click: YES (Reboot)"));
+  display.setCursor(0, 15);
+  display.print(F("Frame:"));
+  display.print(ds.lastFrameUs);
+  display.print(F("us M:"));
+  display.print(ds.maxFrameUs);
+  display.setCursor(0, 27);
+  display.print(F("Bus:"));
+  display.print(ds.lastFrameBytes);
+  display.print(F("B Avg:"));
+  display.print(ds.frames ? ds.bytesOnBus / ds.frames : 0);
 
-  display.setCursor(0, 45);
-  display.println(F("Hold: NO (Cancel)"));
+  // Previous full minute of the redraw-on-change loop
+  display.setCursor(0, 39);
+  display.print(F("Drawn/min: "));
+  display.print(uiFrames.renderedPerMin);
+  display.setCursor(0, 51);
+  display.print(F("Skip/min: "));
+  display.print(uiFrames.skippedPerMin);
 }
 
-void loadBsecState()
+// Stats page 3: per-task CPU share and stack headroom
+void drawTaskStats()
 {
-  if (LittleFS.exists("/bsec_state.bin"))
+  static const char *tags[TASK_SLOT_COUNT] = {"UI ", "SNS", "LOG"};
+
+  for (int t = 0; t < TASK_SLOT_COUNT; t++)
   {
-    File file = LittleFS.open("/bsec_state.bin", "r");
-    if (file)
+    TaskLoad load = getTaskLoad((TaskSlot)t);
+    display.setCursor(0, 15 + t * 12);
+    display.print(tags[t]);
+    if (!load.registered)
     {
-      if (file.size() < BSEC_MAX_STATE_BLOB_SIZE)
-      {
-        file.close();
-        LittleFS.remove("/bsec_state.bin");
-        return;
-      }
-      file.read(bsecState, BSEC_MAX_STATE_BLOB_SIZE);
-      file.close();
-      if (envSensor.setState(bsecState))
-      {
-        stateLoaded = true;
-        lastStateSave = millis();
-      }
-      else
-      {
-        LittleFS.remove("/bsec_state.bin");
-      }
+      display.print(F(" --"));
+      continue;
     }
+    display.print(F(" c"));
+    display.print(load.core);
+    display.print(" ");
+    display.print(load.loadPermille / 10.0f, 1);
+    display.print(F("% "));
+    display.print(load.stackFreeBytes);
+    display.print(F("B"));
   }
+
+  display.setCursor(0, 51);
+  display.print(F("Drop: "));
+  display.print(getSensorStatus().droppedReadings);
 }
 
-bool updateBsecState(bool force)
+// Stats page 4: power-state residency since boot
+void drawPowerStats()
 {
-  bool success = false;
+  PowerResidency pr = getPowerResidency();
+  uint64_t total = pr.activeMs + pr.modemSleepMs + pr.lightSleepMs;
+  if (total == 0)
+    total = 1;
+
+  display.setCursor(0, 15);
+  display.print(F("Active: "));
+  display.print(100.0f * pr.activeMs / total, 1);
+  display.print(F("%"));
+  display.setCursor(0, 27);
+  display.print(F("Modem:  "));
+  display.print(100.0f * pr.modemSleepMs / total, 1);
+  display.print(F("%"));
+  display.setCursor(0, 39);
+  display.print(F("Light:  "));
+  display.print(100.0f * pr.lightSleepMs / total, 1);
+  display.print(F("% "));
+  display.print(pr.lightSleeps);
 
-  if (force || (millis() - lastStateSave > STATE_SAVE_PERIOD))
+  display.setCursor(0, 51);
+  if (pr.dfs)
   {
-    if (currentData.accuracy >= 1)
-    {
-      if (envSensor.getState(bsecState))
-      {
-        File file = LittleFS.open("/bsec_state.bin", "w");
-        if (file)
-        {
-          file.write(bsecState, BSEC_MAX_STATE_BLOB_SIZE);
-          file.close();
-          isSaving = true;
-          stateLoaded = true;
-          hasSavedSinceBoot = true;
-          success = true;
-        }
-      }
-    }
-    if (success || !force)
-    {
-      lastStateSave = millis();
-    }
-    if (isSaving)
-    {
-      delay(100);
-      isSaving = false;
-    }
+    display.print(F("CPU "));
+    display.print(pr.minMhz);
+    display.print(F("-"));
+    display.print(pr.maxMhz);
+    display.print(F("MHz "));
+  }
+  else
+  {
+    display.print(F("CPU fixed "));
   }
-  return success;
+  display.print(pr.autoLightSleep ? F("auto") : F("loop"));
 }
 
-int getBatteryPercentage(float voltage)
+// Stats page 5: loop pass and press -> panel latency (p50 / p99 / max)
+void drawLatencyStats()
 {
-  // LUT: Voltage -> Percentage
-  const float volts[] = {4.20, 4.10, 4.00, 3.90, 3.80, 3.70, 3.60, 3.50, 3.00};
-  const int percents[] = {100, 90, 80, 70, 60, 50, 15, 5, 0};
+  const LatencyStats &ls = getLatencyStats();
+  const Histogram *hists[2] = {&ls.loopUs, &ls.inputToPixelUs};
+  static const char *titles[2] = {"Loop ms 50/99/max", "Input ms 50/99/max"};
+
+  for (int i = 0; i < 2; i++)
+  {
+    const Histogram &h = *hists[i];
+    display.setCursor(0, 15 + i * 24);
+    display.print(titles[i]);
+    display.setCursor(0, 27 + i * 24);
+    display.print(h.percentile(50) / 1000.0f, 1);
+    display.print(" ");
+    display.print(h.percentile(99) / 1000.0f, 1);
+    display.print(" ");
+    display.print(h.max / 1000.0f, 1);
+  }
+  display.print(F(" n"));
+  display.print(ls.inputToPixelUs.count);
+}
 
-  if (voltage >= volts[0])
-    return 100;
-  if (voltage <= volts[8])
-    return 0;
+// Stats page 6: time per subsystem since boot, and its p99 per call
+void drawProfileStats()
+{
+#if PROFILER_ENABLED
+  static const char *tags[PROF_SLOT_COUNT] = {"BSE", "DSP", "LOG", "WEB", "BLE", "TCH"};
 
-  for (int i = 0; i < 8; i++)
+  for (int s = 0; s < PROF_SLOT_COUNT; s++)
   {
-    if (voltage <= volts[i] && voltage > volts[i + 1])
-    {
-      // Linear interpolation
-      float range = volts[i] - volts[i + 1];
-      float delta = voltage - volts[i + 1];
-      float factor = delta / range;
-      int pRange = percents[i] - percents[i + 1];
-      return percents[i + 1] + (int)(factor * pRange);
-    }
+    ProfileStats ps = getProfileStats((ProfileSlot)s);
+    display.setCursor(0, 13 + s * 8);
+    display.print(tags[s]);
+    display.print(" ");
+    display.print((unsigned long)(ps.totalUs / 1000));
+    display.print(F("ms p99:"));
+    display.print(ps.p99Us);
   }
-  return 0;
+#endif
 }
 
-float getBatteryVoltage()
+void drawConfirmation()
 {
-  uint32_t rawMv = 0;
-  for (int i = 0; i < 8; i++)
-  {
-    rawMv += analogReadMilliVolts(BATTERY_PIN);
-  }
-  float v = ((rawMv / 8.0) * VOLT_DIVIDER_RATIO) / 1000.0;
-  currentData.batteryPercent = getBatteryPercentage(v);
-  return v;
+  display.clearDisplay();
+  display.setCursor(0, 0);
+  display.println(F("RESET CALIBRATION?"));
+  display.drawLine(0, 10, 128, 10, SSD1306_WHITE);
+
+  display.setCursor(0, 25);
+  display.println(F("Click: YES (Reboot)"));
+
+  display.setCursor(0, 45);
+  display.println(F("Hold: NO (Cancel)"));
 }
 
 void setupOTA()
@@ -1603,14 +1796,14 @@ void setupOTA()
   ArduinoOTA.begin();
 }
 
-void checkBsecStatus(Bsec2 bsec)
+void checkBsecStatus(int status)
 {
-  if (bsec.status < BSEC_OK)
+  if (status < BSEC_OK)
   {
     display.clearDisplay();
     display.setCursor(0, 0);
     display.println(F("ERR!"));
-    display.print(bsec.status);
-    display.display();
+    display.print(status);
+    displayPush();
   }
 }
\ No newline at end of file
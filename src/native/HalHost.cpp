@@ -0,0 +1,297 @@
+// Host side of Hal.h for the native build: real clock, files under a
+// directory on the host, a framebuffer nobody looks at, an I2C bus that
+// acks everything, and a synthetic sensor. There is no button, touch pad
+// or radio. HalHost.h lets the test suites take over the clock, the file
+// writes and the bus.
+#include "Hal.h"
+#include "HalHost.h"
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define HOST_FS_ROOT_DEFAULT ".pio/native_fs"
+#define HOST_SAMPLE_MS 3000 // NORMAL mode rate
+#define HOST_BATTERY_MV 3900
+#define HOST_FRAME_MAX (128 * 64 / 8)
+
+static std::chrono::steady_clock::time_point clockStart = std::chrono::steady_clock::now();
+static bool manualClock = false;
+static uint64_t manualUs = 0;
+
+static std::mutex halMutex;
+static std::mutex i2cMutex;
+static HalHostFileHook fileHook = nullptr;
+static HalHostI2cSink i2cSink = nullptr;
+
+static uint64_t nowUs()
+{
+    if (manualClock)
+        return manualUs;
+    auto dt = std::chrono::steady_clock::now() - clockStart;
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(dt).count();
+}
+
+uint32_t halMillis()
+{
+    return (uint32_t)(nowUs() / 1000);
+}
+
+uint32_t halMicros()
+{
+    return (uint32_t)nowUs();
+}
+
+void halDelay(uint32_t ms)
+{
+    if (manualClock)
+        manualUs += (uint64_t)ms * 1000;
+    else
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void halHostManualClock(uint32_t startUs)
+{
+    manualClock = true;
+    manualUs = startUs;
+}
+
+void halHostAdvanceUs(uint32_t us)
+{
+    manualUs += us;
+}
+
+void halLock()
+{
+    halMutex.lock();
+}
+
+void halUnlock()
+{
+    halMutex.unlock();
+}
+
+// LittleFS path -> host path under HAL_FS_ROOT (created on first use)
+static void hostPath(char *out, size_t len, const char *path)
+{
+    static bool rootReady = false;
+    const char *root = getenv("HAL_FS_ROOT");
+    if (!root || !*root)
+        root = HOST_FS_ROOT_DEFAULT;
+
+    if (!rootReady)
+    {
+        // mkdir -p
+        char dir[256];
+        snprintf(dir, sizeof(dir), "%s", root);
+        for (char *p = dir + 1; *p; p++)
+        {
+            if (*p != '/')
+                continue;
+            *p = '\0';
+            mkdir(dir, 0755);
+            *p = '/';
+        }
+        mkdir(dir, 0755);
+        rootReady = true;
+    }
+    snprintf(out, len, "%s%s%s", root, path[0] == '/' ? "" : "/", path);
+}
+
+size_t halFileWrite(const char *path, const uint8_t *data, size_t len, bool append)
+{
+    char full[256];
+    hostPath(full, sizeof(full), path);
+    FILE *f = fopen(full, append ? "ab" : "wb");
+    if (!f)
+        return 0;
+    size_t n = fwrite(data, 1, len, f);
+    fclose(f);
+    return n;
+}
+
+size_t halFileRead(const char *path, uint32_t offset, uint8_t *buf, size_t len)
+{
+    char full[256];
+    hostPath(full, sizeof(full), path);
+    FILE *f = fopen(full, "rb");
+    if (!f)
+        return 0;
+    size_t n = 0;
+    if (fseek(f, offset, SEEK_SET) == 0)
+        n = fread(buf, 1, len, f);
+    fclose(f);
+    return n;
+}
+
+long halFileSize(const char *path)
+{
+    char full[256];
+    hostPath(full, sizeof(full), path);
+    struct stat st;
+    if (stat(full, &st) != 0)
+        return -1;
+    return (long)st.st_size;
+}
+
+bool halFileRemove(const char *path)
+{
+    char full[256];
+    hostPath(full, sizeof(full), path);
+    return remove(full) == 0;
+}
+
+bool halFileTruncate(const char *path, size_t size)
+{
+    if (fileHook && !fileHook(HAL_HOST_TRUNCATE, path, size, 0))
+        return false;
+    char full[256];
+    hostPath(full, sizeof(full), path);
+    return truncate(full, (off_t)size) == 0;
+}
+
+struct HalFile
+{
+    FILE *f;
+    char path[64];
+};
+
+HalFile *halFileOpenAppend(const char *path)
+{
+    char full[256];
+    hostPath(full, sizeof(full), path);
+    FILE *f = fopen(full, "ab");
+    if (!f)
+        return nullptr;
+    HalFile *file = new HalFile;
+    file->f = f;
+    snprintf(file->path, sizeof(file->path), "%s", path);
+    return file;
+}
+
+long halFileLength(HalFile *file)
+{
+    fseek(file->f, 0, SEEK_END);
+    return ftell(file->f);
+}
+
+size_t halFileAppend(HalFile *file, const uint8_t *data, size_t len)
+{
+    if (fileHook && !fileHook(HAL_HOST_APPEND, file->path, (size_t)halFileLength(file), len))
+        return 0;
+    return fwrite(data, 1, len, file->f);
+}
+
+bool halFileSync(HalFile *file)
+{
+    if (fileHook && !fileHook(HAL_HOST_SYNC, file->path, (size_t)halFileLength(file), 0))
+        return false;
+    return fflush(file->f) == 0;
+}
+
+void halFileClose(HalFile *file)
+{
+    fclose(file->f);
+    delete file;
+}
+
+void halHostSetFileHook(HalHostFileHook hook)
+{
+    fileHook = hook;
+}
+
+static uint8_t hostFrame[HOST_FRAME_MAX];
+
+void halDisplayFrame(const uint8_t *frame, int width, int height)
+{
+    size_t len = (size_t)width * height / 8;
+    if (len > sizeof(hostFrame))
+        len = sizeof(hostFrame);
+    memcpy(hostFrame, frame, len);
+}
+
+void halI2cBegin(int sda, int scl, uint32_t clockHz)
+{
+    (void)sda;
+    (void)scl;
+    (void)clockHz;
+}
+
+void halI2cTake()
+{
+    i2cMutex.lock();
+}
+
+void halI2cGive()
+{
+    i2cMutex.unlock();
+}
+
+bool halI2cWrite(uint8_t addr, const uint8_t *data, size_t len)
+{
+    return i2cSink ? i2cSink(addr, data, len, nullptr, 0) : true;
+}
+
+bool halI2cWriteRead(uint8_t addr, const uint8_t *wr, size_t wlen, uint8_t *rd, size_t rlen)
+{
+    memset(rd, 0, rlen);
+    return i2cSink ? i2cSink(addr, wr, wlen, rd, rlen) : true;
+}
+
+void halHostSetI2cSink(HalHostI2cSink sink)
+{
+    i2cSink = sink;
+}
+
+// Slow drifts around typical indoor values, one sample per HOST_SAMPLE_MS
+bool halSensorReceive(SensorReadings &out)
+{
+    static uint32_t nextMs = 0;
+    static uint32_t n = 0;
+    uint32_t now = halMillis();
+    if ((int32_t)(now - nextMs) < 0)
+        return false;
+    nextMs = now + HOST_SAMPLE_MS;
+
+    float t = n++ * 0.01f;
+    out.temp = 22.0f + 1.5f * sinf(t);
+    out.hum = 45.0f + 5.0f * sinf(t * 0.7f);
+    out.press = 101325.0f + 150.0f * sinf(t * 0.3f);
+    out.iaq = 60.0f + 40.0f * sinf(t * 1.3f);
+    out.co2 = 600.0f + 200.0f * sinf(t * 1.1f);
+    out.voltage = halBatteryMilliVolts() / 1000.0f;
+    out.batteryPercent = 0;
+    out.accuracy = 3;
+    out.seq = n;
+    return true;
+}
+
+uint32_t halBatteryMilliVolts()
+{
+    return HOST_BATTERY_MV;
+}
+
+bool halButtonDown()
+{
+    return false;
+}
+
+uint32_t halTouchRead()
+{
+    return 0;
+}
+
+bool halWiFiConnected()
+{
+    return false;
+}
+
+bool halBleActive()
+{
+    return false;
+}
@@ -0,0 +1,13 @@
+// Host side of the log writer task: there is no task, a wake-up runs the
+// writer pass right away on the caller's thread. Cadence commits happen
+// when the caller runs logWriterRun() itself after time has passed.
+#include "LogWriter.h"
+
+void logWriterStartTask()
+{
+}
+
+void logWriterWake()
+{
+    logWriterRun();
+}
@@ -0,0 +1,471 @@
+// Host benchmark suite for the hardware-independent parts of the firmware.
+//
+// Build and run (from the repo root):
+//   pio run -e native -t exec
+// or without PlatformIO, with the sources of env:native's build_src_filter:
+//   g++ -O2 -pthread -DPROFILER_ENABLED=0 -Iinclude src/native/*.cpp src/LogFormat.cpp
+//       src/FixedFormat.cpp src/LogReplay.cpp src/GraphHistory.cpp src/Battery.cpp
+//       src/ApiJson.cpp src/UiNav.cpp src/SharedData.cpp src/LogWriter.cpp src/I2CBus.cpp
+//       src/DisplayDiff.cpp src/LatencyMonitor.cpp src/WakeScheduler.cpp
+//       src/BleTelemetry.cpp src/BleFileXfer.cpp -o bench
+//
+// Usage:
+//   bench [scale]    scale multiplies every iteration count (default 1)
+//   bench --replay <file> [speed]
+//                    play a recording copied from the device (path under
+//                    HAL_FS_ROOT) through the pipeline; speed 0 (default)
+//                    runs as fast as possible, 1 is real time
+//
+// Each line is one workload: iterations, time per operation, and a
+// checksum so the optimizer can't drop the work. Compare runs on the same
+// machine before and after a change; absolute numbers say little about
+// the ESP32-S3.
+
+// The test runner (pio test -e native) links src/ with its own main()
+#ifndef PIO_UNIT_TESTING
+#include "Hal.h"
+#include "LogFormat.h"
+#include "GraphHistory.h"
+#include "Battery.h"
+#include "ApiJson.h"
+#include "UiNav.h"
+#include "LogReplay.h"
+#include "LogWriter.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Graph screen geometry (main.cpp)
+#define BENCH_SCREEN_WIDTH 128
+#define BENCH_SCREEN_HEIGHT 64
+#define BENCH_GRAPH_X_START 26
+#define BENCH_GRAPH_TOP 20
+#define BENCH_GRAPH_BOTTOM 60
+
+#define BENCH_MENU_LENGTH 15
+#define BENCH_STATS_PAGES 6
+
+static void report(const char *name, uint32_t ops, uint32_t elapsedUs, uint32_t checksum)
+{
+    double nsPerOp = ops ? elapsedUs * 1000.0 / ops : 0;
+    printf("%-22s %9lu ops  %10.1f ns/op  (sum %08lx)\n", name, (unsigned long)ops, nsPerOp, (unsigned long)checksum);
+}
+
+static void fillSamples(LogData *samples, int count, uint32_t startMs)
+{
+    for (int i = 0; i < count; i++)
+    {
+        samples[i].timestamp = startMs + i * 3000UL;
+        samples[i].iaq = 25.0f + (i % 400) * 0.37f;
+        samples[i].co2 = 450.0f + (i % 900) * 3.11f;
+        samples[i].temp = 21.5f + (i % 50) * 0.07f;
+        samples[i].hum = 40.0f + (i % 30) * 0.53f;
+    }
+}
+
+// --- LOG FLUSH ---
+// One writer-task pass over a full buffer, as in LogWriter.cpp: format
+// into a flash-block sized staging buffer, hand whole blocks to the file.
+struct BlockSink
+{
+    const char *path;
+    uint8_t buf[LOG_FLASH_BLOCK_SIZE];
+    size_t fill;
+    uint32_t written;
+};
+
+static void sinkAppend(BlockSink &s, const uint8_t *data, size_t len)
+{
+    while (len > 0)
+    {
+        size_t n = sizeof(s.buf) - s.fill;
+        if (n > len)
+            n = len;
+        memcpy(s.buf + s.fill, data, n);
+        s.fill += n;
+        data += n;
+        len -= n;
+        if (s.fill == sizeof(s.buf))
+        {
+            s.written += halFileWrite(s.path, s.buf, s.fill, true);
+            s.fill = 0;
+        }
+    }
+}
+
+static void sinkFlush(BlockSink &s)
+{
+    if (s.fill)
+        s.written += halFileWrite(s.path, s.buf, s.fill, true);
+    s.fill = 0;
+}
+
+static void sinkOpen(BlockSink &s, const char *path)
+{
+    s.path = path;
+    s.fill = 0;
+    s.written = 0;
+    halFileRemove(path);
+}
+
+static void benchLogFlush(int buffers)
+{
+    static LogData samples[LOG_BUFFER_SIZE];
+    fillSamples(samples, LOG_BUFFER_SIZE, 1000);
+
+    static BlockSink csv;
+    csv.path = "/bench_log.csv";
+    csv.fill = 0;
+    csv.written = 0;
+    halFileRemove(csv.path);
+
+    uint32_t t0 = halMicros();
+    for (int b = 0; b < buffers; b++)
+    {
+        for (int i = 0; i < LOG_BUFFER_SIZE; i++)
+        {
+            char line[128];
+            int len = logCsvFormatLine(line, sizeof(line), samples[i]);
+            sinkAppend(csv, (const uint8_t *)line, len);
+        }
+    }
+    uint32_t t1 = halMicros();
+    report("log buffer csv", buffers, t1 - t0, csv.written);
+
+    static BlockSink bin;
+    bin.path = "/bench_log.hlg";
+    bin.fill = 0;
+    bin.written = 0;
+    halFileRemove(bin.path);
+
+    uint16_t seq = 0;
+    t0 = halMicros();
+    for (int b = 0; b < buffers; b++)
+    {
+        uint8_t block[LOG_BIN_BLOCK_MAX_SIZE];
+        for (int i = 0; i < LOG_BUFFER_SIZE; i += LOG_BIN_BLOCK_MAX_RECORDS)
+        {
+            int n = LOG_BUFFER_SIZE - i;
+            if (n > LOG_BIN_BLOCK_MAX_RECORDS)
+                n = LOG_BIN_BLOCK_MAX_RECORDS;
+            size_t len = logBinEncodeBlock(block, sizeof(block), seq++, samples + i, n);
+            sinkAppend(bin, block, len);
+        }
+    }
+    t1 = halMicros();
+    report("log buffer bin", buffers, t1 - t0, bin.written);
+
+    halFileRemove(csv.path);
+    halFileRemove(bin.path);
+}
+
+// --- GRAPH RENDERING ---
+static uint8_t frame[BENCH_SCREEN_WIDTH * BENCH_SCREEN_HEIGHT / 8];
+
+static void setPixel(int x, int y)
+{
+    frame[x + (y / 8) * BENCH_SCREEN_WIDTH] |= 1 << (y & 7);
+}
+
+static void vline(int x, int y0, int y1)
+{
+    if (y0 > y1)
+    {
+        int t = y0;
+        y0 = y1;
+        y1 = t;
+    }
+    for (int y = y0; y <= y1; y++)
+        setPixel(x, y);
+}
+
+// Plot step of drawGraph(): envelope bars plus the joined mean line
+static void renderGraph(int span, int channel, GraphColumns &cols)
+{
+    memset(frame, 0, sizeof(frame));
+    graphSpanColumns(span, channel, BENCH_GRAPH_TOP, BENCH_GRAPH_BOTTOM, cols);
+    for (int x = 0; x < cols.count; x++)
+    {
+        if (span > 0 && cols.yBottom[x] > cols.yTop[x])
+            vline(BENCH_GRAPH_X_START + x, cols.yTop[x], cols.yBottom[x]);
+        if (x < cols.count - 1)
+            vline(BENCH_GRAPH_X_START + x, cols.yMean[x], cols.yMean[x + 1]);
+    }
+    halDisplayFrame(frame, BENCH_SCREEN_WIDTH, BENCH_SCREEN_HEIGHT);
+}
+
+static void benchGraph(int frames)
+{
+    // Enough 3 s samples to fill every tier
+    unsigned long t = 0;
+    float values[GRAPH_COUNT];
+    for (int i = 0; i < 120000; i++)
+    {
+        for (int g = 0; g < GRAPH_COUNT; g++)
+            values[g] = 400.0f + g * 50.0f + 40.0f * sinf(i * 0.05f);
+        graphHistoryAdd(t, values);
+        t += 3000;
+    }
+
+    static GraphColumns cols;
+    uint32_t sum = 0;
+    uint32_t t0 = halMicros();
+    for (int f = 0; f < frames; f++)
+    {
+        // New sample every frame: the columns are recomputed each time
+        for (int g = 0; g < GRAPH_COUNT; g++)
+            values[g] = 400.0f + g * 50.0f + 40.0f * sinf(f * 0.05f);
+        graphHistoryAdd(t, values);
+        t += 3000;
+        renderGraph(f % GRAPH_SPAN_COUNT, f % GRAPH_COUNT, cols);
+        sum += frame[f % sizeof(frame)];
+    }
+    uint32_t t1 = halMicros();
+    report("graph frame (new data)", frames, t1 - t0, sum);
+
+    t0 = halMicros();
+    for (int f = 0; f < frames; f++)
+    {
+        renderGraph(1, 0, cols);
+        sum += frame[f % sizeof(frame)];
+    }
+    t1 = halMicros();
+    report("graph frame (cached)", frames, t1 - t0, sum);
+}
+
+// --- BATTERY LUT ---
+static void benchBattery(int calls)
+{
+    uint32_t sum = 0;
+    uint32_t t0 = halMicros();
+    for (int i = 0; i < calls; i++)
+    {
+        // Sweep 2.90 .. 4.30 V
+        float v = 2.9f + (i % 1400) * 0.001f;
+        sum += batteryPercent(v);
+    }
+    uint32_t t1 = halMicros();
+    report("battery lut", calls, t1 - t0, sum);
+}
+
+// --- JSON ---
+static void benchJson(int calls)
+{
+    SensorReadings r;
+    r.temp = 22.37f;
+    r.press = 101325.0f;
+    r.hum = 41.2f;
+    r.iaq = 57.9f;
+    r.co2 = 612.5f;
+    r.voltage = 3.91f;
+    r.accuracy = 3;
+
+    char json[544];
+    uint32_t sum = 0;
+    uint32_t t0 = halMicros();
+    for (int i = 0; i < calls; i++)
+    {
+        r.iaq += 0.01f;
+        sum += apiDataJson(json, sizeof(json), r, i, i * 3000, true, "/log_007.csv");
+    }
+    uint32_t t1 = halMicros();
+    report("json /api/data", calls, t1 - t0, sum);
+
+    Histogram h;
+    for (uint32_t v = 1; v < 2000000; v = v * 5 / 4 + 1)
+        h.add(v);
+
+    char buf[768];
+    sum = 0;
+    t0 = halMicros();
+    for (int i = 0; i < calls; i++)
+        sum += apiHistJson(buf, sizeof(buf), h, 1);
+    t1 = halMicros();
+    report("json histogram", calls, t1 - t0, sum);
+}
+
+// --- REPLAY PIPELINE ---
+// The portable stages a reading passes through on the device: the
+// latest-value snapshot, the graph history, the web payload and the
+// recorder (CSV, as the default format). BLE and the panel are
+// board-only and not part of the host run.
+static char pipelineJson[544];
+static BlockSink pipelineRec;
+
+static uint32_t pipelineSample(const LogData &sample, SensorReadings &r)
+{
+    logReplayApply(sample, r);
+    r.batteryPercent = batteryPercent(r.voltage);
+    currentReadings.write(r);
+
+    float values[GRAPH_COUNT] = {r.iaq, r.co2, r.temp, r.hum, r.press};
+    graphHistoryAdd(sample.timestamp, values);
+
+    uint32_t seq = 0;
+    SensorReadings cur = readingsSnapshot(&seq);
+    int n = apiDataJson(pipelineJson, sizeof(pipelineJson), cur, seq, sample.timestamp, true, pipelineRec.path);
+
+    LogData rec = sample;
+    char line[128];
+    int len = logCsvFormatLine(line, sizeof(line), rec);
+    sinkAppend(pipelineRec, (const uint8_t *)line, len);
+    return n + len;
+}
+
+// Replays path through the pipeline. Returns the samples delivered.
+static uint32_t runReplay(const char *path, float speed, uint32_t &elapsedUs, uint32_t &sum)
+{
+    static LogReplay replay;
+    sinkOpen(pipelineRec, "/replay_out.csv");
+
+    SensorReadings r;
+    r.press = 101325.0f;
+    r.voltage = halBatteryMilliVolts() / 1000.0f;
+    r.accuracy = 3;
+
+    uint32_t t0 = halMicros();
+    if (!logReplayOpen(replay, path, speed, false, halMillis()))
+    {
+        elapsedUs = 0;
+        return 0;
+    }
+
+    LogData sample;
+    while (replay.active)
+    {
+        if (logReplayNext(replay, halMillis(), sample))
+        {
+            sum += pipelineSample(sample, r);
+            continue;
+        }
+        if (replay.active)
+        {
+            int32_t waitMs = (int32_t)(logReplayDueMs(replay) - halMillis());
+            if (waitMs > 0)
+                usleep(waitMs * 1000);
+        }
+    }
+    sinkFlush(pipelineRec);
+    elapsedUs = halMicros() - t0;
+    if (replay.skipped)
+        fprintf(stderr, "%s: %lu records skipped\n", path, (unsigned long)replay.skipped);
+    halFileRemove(pipelineRec.path);
+    return replay.samples;
+}
+
+static void reportReplay(const char *name, uint32_t samples, uint32_t elapsedUs, uint32_t sum)
+{
+    double perSec = elapsedUs ? samples * 1e6 / elapsedUs : 0;
+    printf("%-22s %9lu smp  %10.0f samples/s  (sum %08lx)\n", name, (unsigned long)samples, perSec, (unsigned long)sum);
+}
+
+// Writes a recording in both formats, then replays each unthrottled
+static void benchReplay(int samples)
+{
+    static LogData chunk[LOG_BIN_BLOCK_MAX_RECORDS];
+    static BlockSink csv;
+    static BlockSink bin;
+    sinkOpen(csv, "/bench_replay.csv");
+    sinkOpen(bin, "/bench_replay.hlg");
+
+    sinkAppend(csv, (const uint8_t *)LOG_CSV_HEADER, strlen(LOG_CSV_HEADER));
+    uint8_t block[LOG_BIN_BLOCK_MAX_SIZE];
+    size_t len = logBinEncodeHeader(block, 1000, 1);
+    sinkAppend(bin, block, len);
+
+    uint16_t seq = 0;
+    for (int i = 0; i < samples; i += LOG_BIN_BLOCK_MAX_RECORDS)
+    {
+        int n = samples - i < LOG_BIN_BLOCK_MAX_RECORDS ? samples - i : LOG_BIN_BLOCK_MAX_RECORDS;
+        fillSamples(chunk, n, 1000 + i * 3000UL);
+        for (int k = 0; k < n; k++)
+        {
+            char line[128];
+            int l = logCsvFormatLine(line, sizeof(line), chunk[k]);
+            sinkAppend(csv, (const uint8_t *)line, l);
+        }
+        len = logBinEncodeBlock(block, sizeof(block), seq++, chunk, n);
+        sinkAppend(bin, block, len);
+    }
+    sinkFlush(csv);
+    sinkFlush(bin);
+
+    uint32_t elapsedUs = 0;
+    uint32_t sum = 0;
+    uint32_t n = runReplay(csv.path, 0, elapsedUs, sum);
+    reportReplay("replay pipeline csv", n, elapsedUs, sum);
+    sum = 0;
+    n = runReplay(bin.path, 0, elapsedUs, sum);
+    reportReplay("replay pipeline bin", n, elapsedUs, sum);
+
+    halFileRemove(csv.path);
+    halFileRemove(bin.path);
+}
+
+// --- UI STATE MACHINE ---
+static void benchUi(int events)
+{
+    const UiLayout layout = {BENCH_MENU_LENGTH, GRAPH_COUNT, GRAPH_SPAN_COUNT, BENCH_STATS_PAGES};
+    UiNav nav;
+    uint32_t rng = 1;
+    uint32_t sum = 0;
+
+    uint32_t t0 = halMicros();
+    for (int i = 0; i < events; i++)
+    {
+        rng = rng * 1664525u + 1013904223u;
+        UiCommand cmd = (rng >> 28) < 12 ? uiClick(nav, layout) : uiLongPress(nav);
+        if (cmd == UI_CMD_RUN_ITEM)
+        {
+            // The first two items open the graph and stats screens; the
+            // rest are modal actions that end on the dashboard
+            if (nav.selectedItem == 0)
+                nav.state = GRAPH;
+            else if (nav.selectedItem == 1)
+            {
+                nav.state = STATS;
+                nav.statsPage = 0;
+            }
+            else
+                nav.state = DASHBOARD;
+        }
+        else if (cmd == UI_CMD_RESET_STATE)
+            nav.state = DASHBOARD;
+        sum += nav.state + nav.selectedItem + nav.statsPage + nav.activeGraph;
+    }
+    uint32_t t1 = halMicros();
+    report("ui events", events, t1 - t0, sum);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc >= 3 && strcmp(argv[1], "--replay") == 0)
+    {
+        float speed = argc >= 4 ? atof(argv[3]) : 0;
+        uint32_t elapsedUs = 0;
+        uint32_t sum = 0;
+        uint32_t n = runReplay(argv[2], speed, elapsedUs, sum);
+        if (n == 0)
+        {
+            fprintf(stderr, "%s: no samples (missing, empty or not a recording)\n", argv[2]);
+            return 1;
+        }
+        reportReplay(argv[2], n, elapsedUs, sum);
+        return 0;
+    }
+
+    int scale = argc >= 2 ? atoi(argv[1]) : 1;
+    if (scale < 1)
+        scale = 1;
+
+    benchLogFlush(200 * scale);
+    benchGraph(20000 * scale);
+    benchBattery(2000000 * scale);
+    benchJson(200000 * scale);
+    benchUi(2000000 * scale);
+    benchReplay(50000 * scale);
+    return 0;
+}
+#endif
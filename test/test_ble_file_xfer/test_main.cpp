@@ -0,0 +1,421 @@
+// Simulated-link check for the BLE log download protocol (BleFileXfer.h).
+//
+// Runs the device's state machine against a reference client over a model
+// of a BLE connection: connection events every interval, a few packets per
+// event (airtime-limited), a small notification queue on the device, lost
+// notifications and writes, and dropped connections that resume. Every
+// run lists the files, downloads one and compares it byte for byte with
+// the file on disk; the throughput printed is file bytes over the time
+// from the first request to the final ack, resumes included.
+//
+// Run: pio test -e native -f test_ble_file_xfer
+//
+// Files are created under HAL_FS_ROOT (default .pio/native_fs).
+#include "BleFileXfer.h"
+#include "Hal.h"
+#include <unity.h>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+// Link model
+#define TX_QUEUE_DEPTH 12       // Notifications NimBLE can hold (msys buffers)
+#define MAX_PACKETS_PER_EVENT 6 // Typical phone limit per connection event
+#define REWIND_RETRY_MS 300     // Client repeats an unanswered 'R'
+#define SIM_LIMIT_MS 3600000
+#define FILE_KB 256
+
+struct LinkConfig
+{
+    const char *name;
+    int mtu;
+    int intervalMs;  // Connection interval
+    int lossPct;     // Per packet, both directions
+    int dropEveryMs; // Connection drop period (0 = never)
+};
+
+static uint32_t rng = 2463534242u;
+static uint32_t xorshift()
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static bool lost(int pct)
+{
+    return (int)(xorshift() % 100) < pct;
+}
+
+// 1M PHY: 80 us preamble/header/MIC-less overhead + 8 us per byte incl.
+// L2CAP/ATT headers, plus the empty ack packet and two inter-frame spaces
+static int airtimeUs(size_t payload)
+{
+    return 80 + (int)(payload + 4 + 3) * 8 + 80 + 2 * 150;
+}
+
+// --- Test files, listed to the device like the manifest would ---
+static const char *files[] = {"/log_001.csv", "/log_002.hlg"};
+
+static bool listFiles(int index, char *name, size_t nameLen, uint32_t &size)
+{
+    if (index < 0 || index >= (int)(sizeof(files) / sizeof(files[0])))
+        return false;
+    snprintf(name, nameLen, "%s", files[index]);
+    long n = halFileSize(files[index]);
+    size = n < 0 ? 0 : (uint32_t)n;
+    return true;
+}
+
+static void makeFiles(size_t kb)
+{
+    std::string csv = "timestamp,iaq,co2,temp,hum\n";
+    for (unsigned long t = 0; csv.size() < kb * 1024; t += 3000)
+    {
+        char line[64];
+        snprintf(line, sizeof(line), "%lu,%.2f,%.2f,%.2f,%.2f\n", t, 25 + (t % 977) * 0.1, 450 + (t % 1313) * 0.7,
+                 21 + (t % 311) * 0.01, 40 + (t % 97) * 0.2);
+        csv += line;
+    }
+    halFileWrite(files[0], (const uint8_t *)csv.data(), csv.size(), false);
+
+    std::vector<uint8_t> bin(kb * 256);
+    for (size_t i = 0; i < bin.size(); i++)
+        bin[i] = (uint8_t)xorshift();
+    halFileWrite(files[1], bin.data(), bin.size(), false);
+}
+
+// --- Reference client (what a phone app implements) ---
+struct Client
+{
+    enum Phase
+    {
+        LISTING,
+        OPENING,
+        RECEIVING,
+        COMPLETE
+    } phase = LISTING;
+    std::string want;
+    std::vector<std::string> listed;
+    uint32_t size = 0;
+    std::vector<uint8_t> data;
+    uint32_t lastAck = 0;
+    bool rewindPending = false;
+    uint32_t rewindSentMs = 0;
+    uint32_t startMs = 0;
+    uint32_t doneMs = 0;
+    std::deque<std::vector<uint8_t>> writes;
+
+    void send(std::initializer_list<uint8_t> head, uint32_t v)
+    {
+        std::vector<uint8_t> w(head);
+        for (int i = 0; i < 4; i++)
+            w.push_back((uint8_t)(v >> (8 * i)));
+        writes.push_back(w);
+    }
+
+    void open()
+    {
+        std::vector<uint8_t> w = {XFER_CMD_OPEN};
+        w.insert(w.end(), want.begin(), want.end());
+        writes.push_back(w);
+        phase = OPENING;
+    }
+
+    void rewind(uint32_t nowMs)
+    {
+        send({XFER_CMD_READ}, (uint32_t)data.size());
+        rewindPending = true;
+        rewindSentMs = nowMs;
+    }
+
+    void connected()
+    {
+        writes.clear();
+        rewindPending = false;
+        if (phase == LISTING)
+            writes.push_back({XFER_CMD_LIST, 0, 0});
+        else if (phase != COMPLETE)
+            open(); // Resume: reopen, then 'R' with what we have
+    }
+
+    void receive(const uint8_t *p, size_t len, uint32_t nowMs)
+    {
+        uint32_t v = len >= 5 ? (uint32_t)p[1] | (p[2] << 8) | (p[3] << 16) | ((uint32_t)p[4] << 24) : 0;
+        switch (p[0])
+        {
+        case XFER_PKT_ENTRY:
+            listed.push_back(std::string((const char *)p + 9, len - 9));
+            break;
+        case XFER_PKT_LIST_END:
+            open();
+            break;
+        case XFER_PKT_OPENED:
+            if (p[1] != XFER_OPEN_OK)
+                return;
+            size = (uint32_t)p[2] | (p[3] << 8) | (p[4] << 16) | ((uint32_t)p[5] << 24);
+            if (!startMs)
+                startMs = nowMs;
+            phase = RECEIVING;
+            rewind(nowMs);
+            break;
+        case XFER_PKT_DATA:
+        {
+            uint32_t have = (uint32_t)data.size();
+            uint32_t n = (uint32_t)len - XFER_DATA_HEADER;
+            if (phase == RECEIVING && v <= have && v + n > have)
+            {
+                data.insert(data.end(), p + XFER_DATA_HEADER + (have - v), p + len);
+                rewindPending = false;
+                if (data.size() - lastAck >= XFER_WINDOW / 4)
+                {
+                    lastAck = (uint32_t)data.size();
+                    send({XFER_CMD_ACK}, lastAck);
+                }
+            }
+            else if (phase == RECEIVING && v > have && !rewindPending)
+            {
+                rewind(nowMs); // Gap: a notification was lost
+            }
+            break;
+        }
+        case XFER_PKT_END:
+            if (data.size() == size)
+            {
+                lastAck = size;
+                send({XFER_CMD_ACK}, size);
+                if (phase != COMPLETE)
+                    doneMs = nowMs;
+                phase = COMPLETE;
+            }
+            else if (!rewindPending)
+            {
+                rewind(nowMs);
+            }
+            break;
+        }
+    }
+
+    void tick(uint32_t nowMs)
+    {
+        if (rewindPending && nowMs - rewindSentMs > REWIND_RETRY_MS)
+            rewind(nowMs);
+    }
+};
+
+struct Result
+{
+    bool ok;
+    double kbps;
+    uint32_t resends; // Data bytes sent twice or more
+    uint32_t rewinds;
+    uint32_t drops;
+    uint32_t notifications;
+    uint32_t requeued; // Handed back by a full notification queue
+};
+
+static Result run(const LinkConfig &cfg, const char *file)
+{
+    XferServer *dev = new XferServer;
+    xferInit(*dev, listFiles);
+    Client client;
+    client.want = file;
+
+    std::deque<std::vector<uint8_t>> txQueue;
+    Result res = {false, 0, 0, 0, 0, 0, 0};
+    uint32_t sentBytes = 0;
+    bool up = true;
+    uint32_t downUntil = 0;
+    uint32_t nextDrop = cfg.dropEveryMs;
+
+    client.connected();
+    xferSetPacketSize(*dev, cfg.mtu - 3);
+
+    for (uint32_t now = 0; now < SIM_LIMIT_MS && client.phase != Client::COMPLETE; now++)
+    {
+        if (!up && now >= downUntil)
+        {
+            up = true;
+            client.connected();
+            xferSetPacketSize(*dev, cfg.mtu - 3);
+        }
+        if (up && cfg.dropEveryMs && now >= nextDrop)
+        {
+            // Connection lost: queues are gone, the client reconnects in 1 s
+            up = false;
+            downUntil = now + 1000;
+            nextDrop = now + cfg.dropEveryMs;
+            txQueue.clear();
+            xferDisconnected(*dev);
+            res.drops++;
+        }
+        if (!up)
+            continue;
+
+        // Device loop pass, as serviceBLE() does it: a notify that finds
+        // the buffers full hands its packet back
+        if (now % XFER_POLL_MS == 0)
+        {
+            uint8_t pkt[XFER_MAX_PACKET];
+            for (int i = 0; i < XFER_BURST; i++)
+            {
+                size_t n = xferNextPacket(*dev, pkt, sizeof(pkt), now);
+                if (n == 0)
+                    break;
+                if (txQueue.size() >= TX_QUEUE_DEPTH)
+                {
+                    xferUnsent(*dev, pkt, n);
+                    res.requeued++;
+                    break;
+                }
+                txQueue.push_back(std::vector<uint8_t>(pkt, pkt + n));
+            }
+        }
+
+        client.tick(now);
+
+        // Connection event: one client write each way, then notifications
+        // while the event's airtime lasts
+        if (now % cfg.intervalMs == 0)
+        {
+            int budgetUs = cfg.intervalMs * 1000 - 1250;
+            if (!client.writes.empty())
+            {
+                std::vector<uint8_t> w = client.writes.front();
+                client.writes.pop_front();
+                budgetUs -= airtimeUs(w.size());
+                if (!lost(cfg.lossPct))
+                    xferCommand(*dev, w.data(), w.size(), now);
+            }
+            for (int i = 0; i < MAX_PACKETS_PER_EVENT && !txQueue.empty(); i++)
+            {
+                int t = airtimeUs(txQueue.front().size());
+                if (t > budgetUs)
+                    break;
+                budgetUs -= t;
+                std::vector<uint8_t> pkt = txQueue.front();
+                txQueue.pop_front();
+                res.notifications++;
+                if (pkt[0] == XFER_PKT_DATA)
+                    sentBytes += pkt.size() - XFER_DATA_HEADER;
+                if (!lost(cfg.lossPct))
+                    client.receive(pkt.data(), pkt.size(), now);
+            }
+        }
+    }
+
+    // Compare with the file itself
+    long size = halFileSize(file);
+    std::vector<uint8_t> ref(size > 0 ? size : 0);
+    halFileRead(file, 0, ref.data(), ref.size());
+    res.ok = client.phase == Client::COMPLETE && client.data == ref && client.listed.size() == 2;
+    uint32_t ms = client.doneMs - client.startMs;
+    res.kbps = ms ? (client.data.size() / 1024.0) / (ms / 1000.0) : 0;
+    res.resends = sentBytes > ref.size() ? sentBytes - (uint32_t)ref.size() : 0;
+    res.rewinds = dev->rewinds;
+    delete dev;
+    return res;
+}
+
+static const LinkConfig links[] = {
+    {"default MTU", 23, 30, 0, 0},
+    {"MTU 185", 185, 30, 0, 0},
+    {"MTU 247", 247, 15, 0, 0},
+    {"MTU 247 1% loss", 247, 15, 1, 0},
+    {"MTU 247 5% loss", 247, 15, 5, 0},
+    {"MTU 247 drops/2s", 247, 15, 0, 2000},
+    {"MTU 185 2% + drops", 185, 30, 2, 8000},
+    {"MTU 23 5% + drops", 23, 30, 5, 20000},
+};
+
+void setUp() {}
+
+// The host filesystem is shared with the other suites
+void tearDown()
+{
+    for (const char *name : files)
+        halFileRemove(name);
+}
+
+// Every link delivers both files byte for byte
+static void test_links()
+{
+    makeFiles(FILE_KB);
+
+    int failures = 0;
+    printf("%-20s %-13s %8s %9s %8s %6s %6s %8s  %s\n", "link", "file", "KB/s", "resent", "rewinds", "drops", "notif", "requeued", "result");
+    for (const LinkConfig &cfg : links)
+    {
+        for (const char *file : files)
+        {
+            Result r = run(cfg, file);
+            printf("%-20s %-13s %8.1f %8.1f%% %8lu %6lu %6lu %8lu  %s\n", cfg.name, file, r.kbps,
+                   100.0 * r.resends / halFileSize(file), (unsigned long)r.rewinds, (unsigned long)r.drops,
+                   (unsigned long)r.notifications, (unsigned long)r.requeued, r.ok ? "ok" : "FAIL");
+            if (!r.ok)
+                failures++;
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(0, failures);
+}
+
+static void command(XferServer &dev, uint8_t op, uint32_t v, uint32_t nowMs)
+{
+    uint8_t cmd[5] = {op, (uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24)};
+    xferCommand(dev, cmd, sizeof(cmd), nowMs);
+}
+
+// Sends every data packet the window allows at nowMs
+static void pump(XferServer &dev, uint32_t nowMs)
+{
+    uint8_t pkt[XFER_MAX_PACKET];
+    while (xferNextPacket(dev, pkt, sizeof(pkt), nowMs) > 0 && pkt[0] == XFER_PKT_DATA)
+        ;
+}
+
+// A transfer always ends: on the final ack even before 'Z' went out, and
+// after XFER_MAX_STALLS timeouts when the client stops acking
+static void test_transfer_ends()
+{
+    makeFiles(4);
+    XferServer *dev = new XferServer;
+    xferInit(*dev, listFiles);
+    xferSetPacketSize(*dev, 244);
+    uint32_t size = (uint32_t)halFileSize(files[0]);
+    uint32_t now = 0;
+
+    // Everything acked before 'Z' is pulled
+    xferCommand(*dev, (const uint8_t *)"O/log_001.csv", 13, now);
+    uint8_t pkt[XFER_MAX_PACKET];
+    xferNextPacket(*dev, pkt, sizeof(pkt), now);
+    command(*dev, XFER_CMD_READ, 0, now);
+    pump(*dev, now);
+    command(*dev, XFER_CMD_ACK, size, now + 50);
+    TEST_ASSERT_EQUAL_INT(XFER_DONE, dev->state);
+    TEST_ASSERT_FALSE(xferBusy(*dev));
+
+    // No acks at all: a few rewinds, then the device stops
+    command(*dev, XFER_CMD_READ, 0, now);
+    for (; now < 60000 && xferBusy(*dev); now += XFER_POLL_MS)
+        pump(*dev, now);
+    TEST_ASSERT_FALSE(xferBusy(*dev));
+    TEST_ASSERT_EQUAL_INT(XFER_OPEN, dev->state);
+    TEST_ASSERT_EQUAL_UINT32(XFER_MAX_STALLS, dev->rewinds);
+    TEST_ASSERT_TRUE(now <= (XFER_MAX_STALLS + 1) * (XFER_ACK_TIMEOUT_MS + 2 * XFER_POLL_MS));
+
+    // The file stays open: 'R' resumes
+    command(*dev, XFER_CMD_READ, 1000, now);
+    TEST_ASSERT_TRUE(xferBusy(*dev));
+    delete dev;
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_links);
+    RUN_TEST(test_transfer_ends);
+    return UNITY_END();
+}
@@ -0,0 +1,171 @@
+// Check for the packed BLE telemetry packet (BleTelemetry.h), plus the
+// notification budget of the packed characteristic against the five
+// per-channel characteristics it replaces.
+//
+// Run: pio test -e native -f test_ble_telemetry
+//
+// The check encodes random readings across the sensor ranges and decodes
+// them again: every field must come back within half its resolution,
+// out-of-range values must clamp, and short or unknown-version packets
+// must be rejected.
+#include "BleTelemetry.h"
+#include "FixedFormat.h"
+#include <unity.h>
+#include <cmath>
+#include <cstdio>
+
+// Per notification on the air: ATT opcode + handle (3) and L2CAP header (4)
+#define NOTIFY_OVERHEAD 7
+#define SAMPLES 1000000
+
+static unsigned long failures = 0;
+
+static void expect(bool ok, const char *what, unsigned long i)
+{
+    if (!ok && failures++ < 10)
+        printf("FAIL %s (sample %lu)\n", what, i);
+}
+
+static uint32_t rng = 2463534242u;
+static float uniform(float lo, float hi)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return lo + (hi - lo) * (rng / 4294967296.0f);
+}
+
+static bool near(float got, float want, float resolution)
+{
+    return fabsf(got - want) <= resolution / 2 + fabsf(want) * 1e-6f;
+}
+
+static SensorReadings randomReading()
+{
+    SensorReadings r;
+    r.temp = uniform(-40.0f, 85.0f);
+    r.hum = uniform(0.0f, 100.0f);
+    r.press = uniform(300.0f, 110000.0f);
+    r.iaq = uniform(0.0f, 500.0f);
+    r.co2 = uniform(400.0f, 10000.0f);
+    r.accuracy = (uint8_t)uniform(0.0f, 4.0f);
+    r.batteryPercent = (int)uniform(-5.0f, 105.0f); // Clamped to 0..100
+    return r;
+}
+
+static void checkRoundTrip(long samples)
+{
+    for (long i = 0; i < samples; i++)
+    {
+        SensorReadings r = randomReading();
+        uint8_t flags = (i & 1 ? BLE_TELEMETRY_FLAG_RECORDING : 0) | (i & 2 ? BLE_TELEMETRY_FLAG_REPLAYING : 0);
+        BleTelemetry t = bleTelemetryFromReadings(r, (uint32_t)i, (uint32_t)(i * 3000), flags);
+
+        uint8_t packet[BLE_TELEMETRY_SIZE];
+        BleTelemetry d;
+        expect(bleTelemetryEncode(packet, sizeof(packet), t) == BLE_TELEMETRY_SIZE, "encode size", i);
+        expect(bleTelemetryDecode(packet, sizeof(packet), d), "decode", i);
+        expect(d.seq == (uint16_t)i, "seq", i);
+        expect(d.timestampMs == (uint32_t)(i * 3000), "timestamp", i);
+        expect(near(d.temp, r.temp, 0.01f), "temp", i);
+        expect(near(d.hum, r.hum, 0.01f), "hum", i);
+        expect(near(d.press, r.press, 0.1f), "press", i);
+        expect(near(d.iaq, r.iaq, 0.01f), "iaq", i);
+        expect(near(d.co2, r.co2, 0.01f), "co2", i);
+        expect(d.accuracy == r.accuracy, "accuracy", i);
+        expect(d.batteryPercent == (r.batteryPercent < 0 ? 0 : r.batteryPercent > 100 ? 100 : r.batteryPercent), "battery", i);
+        expect(d.flags == flags, "flags", i);
+    }
+}
+
+static void checkEdges()
+{
+    uint8_t packet[BLE_TELEMETRY_SIZE];
+    BleTelemetry t, d;
+
+    // Clamping at both ends of every field
+    t.temp = -400.0f;
+    t.hum = -1.0f;
+    t.press = 2e6f;
+    t.iaq = 1000.0f;
+    t.co2 = NAN;
+    t.accuracy = 7;
+    bleTelemetryEncode(packet, sizeof(packet), t);
+    bleTelemetryDecode(packet, sizeof(packet), d);
+    expect(d.temp == -327.68f, "temp clamp", 0);
+    expect(d.hum == 0.0f, "hum clamp", 0);
+    expect(d.press == 0xFFFFFF / 10.0f, "press clamp", 0);
+    expect(d.iaq == 655.35f, "iaq clamp", 0);
+    expect(d.co2 == 0.0f, "co2 nan", 0);
+    expect(d.accuracy == 3, "accuracy clamp", 0);
+
+    // Rejections
+    expect(bleTelemetryEncode(packet, BLE_TELEMETRY_SIZE - 1, t) == 0, "encode short buffer", 0);
+    expect(!bleTelemetryDecode(packet, BLE_TELEMETRY_SIZE - 1, d), "decode short packet", 0);
+    packet[0] = (uint8_t)((BLE_TELEMETRY_VERSION + 1) << 4);
+    expect(!bleTelemetryDecode(packet, sizeof(packet), d), "decode unknown version", 0);
+}
+
+// Notifications and bytes per hour at one sample rate; returns bytes saved
+static double budget(const char *mode, float samplesPerHour, long samples)
+{
+    // Previous updateBLEData(): temp, hum, press binary, IAQ / CO2 as "%.2f"
+    double legacyBytes = 0;
+    char buf[48];
+    for (long i = 0; i < samples; i++)
+    {
+        SensorReadings r = randomReading();
+        legacyBytes += 2 + 2 + 4;
+        legacyBytes += fmtFixedTo(buf, sizeof(buf), r.iaq, 2);
+        legacyBytes += fmtFixedTo(buf, sizeof(buf), r.co2, 2);
+    }
+    double legacyPayload = legacyBytes / samples;
+
+    double beforeNotify = 5 * samplesPerHour;
+    double beforeBytes = (legacyPayload + 5 * NOTIFY_OVERHEAD) * samplesPerHour;
+    double afterNotify = samplesPerHour;
+    double afterBytes = (BLE_TELEMETRY_SIZE + NOTIFY_OVERHEAD) * samplesPerHour;
+
+    printf("%-10s %9.0f %12.0f %9.0f %12.0f %7.1f%%\n", mode, beforeNotify, beforeBytes, afterNotify, afterBytes,
+           100.0 * (1.0 - afterBytes / beforeBytes));
+    return beforeBytes - afterBytes;
+}
+
+void setUp()
+{
+    failures = 0;
+}
+
+void tearDown() {}
+
+static void test_round_trip()
+{
+    checkRoundTrip(SAMPLES);
+    printf("%ld round trips, %lu failures\n", (long)SAMPLES, failures);
+    TEST_ASSERT_EQUAL_UINT32(0, failures);
+}
+
+static void test_clamping_and_rejects()
+{
+    checkEdges();
+    TEST_ASSERT_EQUAL_UINT32(0, failures);
+}
+
+static void test_notification_budget()
+{
+    // Sample rates of the BSEC modes (main.cpp); ECO with the screen on
+    // samples like NORMAL
+    printf("\nper hour     notifications / bytes before     after (packed only)   saved\n");
+    TEST_ASSERT_TRUE(budget("REALTIME", 3600.0f, 10000) > 0);
+    TEST_ASSERT_TRUE(budget("NORMAL", 1200.0f, 10000) > 0);
+    TEST_ASSERT_TRUE(budget("ECO off", 12.0f, 10000) > 0);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_clamping_and_rejects);
+    RUN_TEST(test_notification_budget);
+    return UNITY_END();
+}
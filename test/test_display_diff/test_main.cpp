@@ -0,0 +1,219 @@
+// Partial display refresh (DisplayDiff.h) against a fake SSD1306 on the
+// I2C sink: an unchanged frame sends nothing, changed regions go out as
+// one window command plus data chunks of at most 127 bytes (the 128-byte
+// Wire buffer less the control byte), and the modelled panel RAM always
+// ends up equal to the framebuffer.
+//
+// Run: pio test -e native -f test_display_diff
+#include "DisplayDiff.h"
+#include "I2CBus.h"
+#include "HalHost.h"
+#include <unity.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#define PANEL_ADDR 0x3C
+#define WIDTH 128
+#define PAGES 8
+#define CHUNK_MAX 127
+
+static uint8_t frame[WIDTH * PAGES];
+
+// --- Fake panel: horizontal addressing inside the last window ---
+static uint8_t gddram[WIDTH * PAGES];
+static int pageStart, pageEnd, colStart, colEnd, page, col;
+static bool panelOn = true;
+
+struct Transfer
+{
+    bool data;  // 0x40 data stream, else 0x00 command stream
+    size_t len; // Payload without the control byte
+};
+static std::vector<Transfer> transfers;
+
+static bool sink(uint8_t addr, const uint8_t *wr, size_t wlen, uint8_t *rd, size_t rlen)
+{
+    TEST_ASSERT_EQUAL_UINT8(PANEL_ADDR, addr);
+    TEST_ASSERT_TRUE(wlen >= 2 && wlen <= 1 + CHUNK_MAX);
+    transfers.push_back({wr[0] == 0x40, wlen - 1});
+
+    if (wr[0] == 0x40)
+    {
+        for (size_t i = 1; i < wlen; i++)
+        {
+            gddram[page * WIDTH + col] = wr[i];
+            if (++col > colEnd)
+            {
+                col = colStart;
+                page = page >= pageEnd ? pageStart : page + 1;
+            }
+        }
+        return true;
+    }
+
+    TEST_ASSERT_EQUAL_UINT8(0x00, wr[0]);
+    for (size_t i = 1; i < wlen; i++)
+    {
+        switch (wr[i])
+        {
+        case 0x22:
+            TEST_ASSERT_TRUE(i + 2 < wlen);
+            pageStart = page = wr[i + 1];
+            pageEnd = wr[i + 2];
+            i += 2;
+            break;
+        case 0x21:
+            TEST_ASSERT_TRUE(i + 2 < wlen);
+            colStart = col = wr[i + 1];
+            colEnd = wr[i + 2];
+            i += 2;
+            break;
+        case 0xAE:
+            panelOn = false;
+            break;
+        case 0xAF:
+            panelOn = true;
+            break;
+        default:
+            TEST_FAIL_MESSAGE("unexpected command");
+        }
+    }
+    return true;
+}
+
+static int count(bool data)
+{
+    int n = 0;
+    for (const Transfer &t : transfers)
+        n += t.data == data;
+    return n;
+}
+
+void setUp()
+{
+    halHostSetI2cSink(sink);
+    initI2CBus(0, 0);
+    memset(frame, 0, sizeof(frame));
+    memset(gddram, 0xA5, sizeof(gddram));
+    initDisplayDiff(frame, PANEL_ADDR);
+    transfers.clear();
+}
+
+void tearDown()
+{
+    halHostSetI2cSink(nullptr);
+}
+
+// The first push has no shadow: every page goes out in full, 127 + 1
+static void test_first_push_sends_full_frame()
+{
+    displayPush();
+    TEST_ASSERT_EQUAL_INT(PAGES, count(false));
+    TEST_ASSERT_EQUAL_INT(2 * PAGES, count(true));
+    for (size_t i = 0; i < transfers.size(); i += 3)
+    {
+        TEST_ASSERT_FALSE(transfers[i].data);
+        TEST_ASSERT_EQUAL_UINT32(CHUNK_MAX, transfers[i + 1].len);
+        TEST_ASSERT_EQUAL_UINT32(WIDTH - CHUNK_MAX, transfers[i + 2].len);
+    }
+    TEST_ASSERT_EQUAL_MEMORY(frame, gddram, sizeof(frame));
+    TEST_ASSERT_FALSE(displayPending());
+}
+
+static void test_unchanged_frame_sends_nothing()
+{
+    displayPush();
+    transfers.clear();
+    uint32_t skipped = getDisplayStats().framesSkipped;
+
+    displayPush();
+    displayPush();
+    TEST_ASSERT_EQUAL_UINT32(0, transfers.size());
+    TEST_ASSERT_EQUAL_UINT32(skipped + 2, getDisplayStats().framesSkipped);
+    TEST_ASSERT_EQUAL_UINT32(0, getDisplayStats().lastFrameBytes);
+}
+
+// One changed byte: one window of one column, one data byte
+static void test_single_change_sends_one_column()
+{
+    displayPush();
+    transfers.clear();
+
+    frame[3 * WIDTH + 40] = 0x18;
+    displayPush();
+    TEST_ASSERT_EQUAL_UINT32(2, transfers.size());
+    TEST_ASSERT_EQUAL_INT(3, pageStart);
+    TEST_ASSERT_EQUAL_INT(3, pageEnd);
+    TEST_ASSERT_EQUAL_INT(40, colStart);
+    TEST_ASSERT_EQUAL_INT(40, colEnd);
+    TEST_ASSERT_EQUAL_UINT32(1, transfers[1].len);
+    TEST_ASSERT_EQUAL_MEMORY(frame, gddram, sizeof(frame));
+}
+
+// Only the span between the first and last changed column of a page is
+// sent; a span wider than a chunk splits at 127 bytes
+static void test_changed_span_chunks_at_127()
+{
+    displayPush();
+    transfers.clear();
+
+    frame[5 * WIDTH + 0] = 0xFF;
+    frame[5 * WIDTH + 127] = 0xFF;
+    frame[6 * WIDTH + 10] = 0x01;
+    frame[6 * WIDTH + 20] = 0x02;
+    displayPush();
+
+    TEST_ASSERT_EQUAL_UINT32(5, transfers.size());
+    TEST_ASSERT_EQUAL_UINT32(CHUNK_MAX, transfers[1].len);
+    TEST_ASSERT_EQUAL_UINT32(1, transfers[2].len);
+    TEST_ASSERT_EQUAL_UINT32(11, transfers[4].len);
+    TEST_ASSERT_EQUAL_MEMORY(frame, gddram, sizeof(frame));
+}
+
+// Random edits frame after frame: the panel always matches, and no frame
+// sends more than it changed plus chunk / window overhead
+static void test_random_frames_stay_in_sync()
+{
+    srand(1);
+    displayPush();
+    for (int f = 0; f < 2000; f++)
+    {
+        int edits = rand() % 40;
+        for (int e = 0; e < edits; e++)
+            frame[rand() % sizeof(frame)] ^= (uint8_t)(1 + rand() % 255);
+        transfers.clear();
+        displayPush();
+        TEST_ASSERT_EQUAL_MEMORY(frame, gddram, sizeof(frame));
+        for (const Transfer &t : transfers)
+            TEST_ASSERT_TRUE(t.len <= CHUNK_MAX);
+        if (edits == 0)
+            TEST_ASSERT_EQUAL_UINT32(0, transfers.size());
+    }
+}
+
+static void test_invalidate_and_power()
+{
+    displayPush();
+    displayInvalidate();
+    transfers.clear();
+    displayPush();
+    TEST_ASSERT_EQUAL_INT(PAGES, count(false));
+
+    displayPower(false);
+    TEST_ASSERT_FALSE(panelOn);
+    displayPower(true);
+    TEST_ASSERT_TRUE(panelOn);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_first_push_sends_full_frame);
+    RUN_TEST(test_unchanged_frame_sends_nothing);
+    RUN_TEST(test_single_change_sends_one_column);
+    RUN_TEST(test_changed_span_chunks_at_127);
+    RUN_TEST(test_random_frames_stay_in_sync);
+    RUN_TEST(test_invalidate_and_power);
+    return UNITY_END();
+}
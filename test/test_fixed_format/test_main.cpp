@@ -0,0 +1,205 @@
+// Check and microbenchmark for the printf-free formatter (FixedFormat.h)
+//
+// Run: pio test -e native -f test_fixed_format
+// Every float in every range instead of random samples (minutes):
+//   PLATFORMIO_BUILD_FLAGS=-DFMT_TEST_EXHAUSTIVE pio test -e native -f test_fixed_format
+//
+// The check compares fmtFixed() byte for byte with the host's snprintf
+// ("%.0f" .. "%.3f") over the sensor ranges, their boundaries, exact
+// decimal ties and special values. The benchmark times one CSV line, the
+// /api/data JSON and one BLE value against the snprintf versions they
+// replaced.
+#include "FixedFormat.h"
+#include "LogFormat.h"
+#include "ApiJson.h"
+#include <unity.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#define SAMPLES 500000 // Random floats per range
+#define BENCH_ITERATIONS 1000000
+#ifdef FMT_TEST_EXHAUSTIVE
+#define EXHAUSTIVE true
+#else
+#define EXHAUSTIVE false
+#endif
+
+struct Range
+{
+    const char *name;
+    float lo;
+    float hi;
+};
+
+static const Range ranges[] = {
+    {"temp C", -40.0f, 85.0f},
+    {"press Pa", 300.0f, 110000.0f},
+    {"iaq", 0.0f, 500.0f},
+    {"co2 ppm", 400.0f, 10000.0f},
+    {"hum %", 0.0f, 100.0f},
+};
+
+static unsigned long mismatches = 0;
+static unsigned long checked = 0;
+
+static void check(float v)
+{
+    for (int d = 0; d <= FMT_MAX_DECIMALS; d++)
+    {
+        char ref[64];
+        char got[64];
+        snprintf(ref, sizeof(ref), "%.*f", d, v);
+        fmtFixedTo(got, sizeof(got), v, d);
+        checked++;
+        if (strcmp(ref, got) != 0 && mismatches++ < 10)
+            printf("MISMATCH %.9g %%.%df: snprintf \"%s\" fmtFixed \"%s\"\n", v, d, ref, got);
+    }
+}
+
+static uint32_t rng = 2463534242u;
+static uint32_t xorshift()
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static void checkRange(const Range &r, long samples, bool exhaustive)
+{
+    unsigned long before = checked;
+    if (exhaustive)
+    {
+        for (float v = r.lo; v <= r.hi; v = nextafterf(v, INFINITY))
+            check(v);
+    }
+    else
+    {
+        // Uniform values, plus the floats around every hundredth where the
+        // rounding decision is closest
+        for (long i = 0; i < samples; i++)
+            check(r.lo + (r.hi - r.lo) * (xorshift() / 4294967296.0f));
+        for (long i = 0; i < samples / 4; i++)
+        {
+            float c = roundf((r.lo + (r.hi - r.lo) * (xorshift() / 4294967296.0f)) * 200.0f) / 200.0f;
+            check(c);
+            check(nextafterf(c, INFINITY));
+            check(nextafterf(c, -INFINITY));
+        }
+    }
+    check(r.lo);
+    check(r.hi);
+    printf("%-10s %12lu checks\n", r.name, checked - before);
+}
+
+static void checkSpecial()
+{
+    // Exact binary ties (x.xx5 representable), signed zero, tiny,
+    // subnormal, huge and non-finite values
+    const float special[] = {0.0f, -0.0f, 0.005f, -0.005f, 0.125f, 0.375f, 2.5f, 0.5f, 1.5f,
+                             -2.5f, 0.0625f, 1.0f / 1024, 1e-45f, -1e-45f, 1e-38f,
+                             16777216.0f, 9.1e15f, 1e17f, 3.4028235e38f, -3.4028235e38f,
+                             INFINITY, -INFINITY, NAN};
+    for (float v : special)
+        check(v);
+    // Every multiple of 1/1024 up to 64 hits the tie cases of each precision
+    for (int i = -65536; i <= 65536; i++)
+        check(i / 1024.0f);
+}
+
+// --- Previous snprintf implementations ---
+static int oldCsvLine(char *out, size_t outSize, const LogData &s)
+{
+    return snprintf(out, outSize, "%lu,%.2f,%.2f,%.2f,%.2f\n", s.timestamp, s.iaq, s.co2, s.temp, s.hum);
+}
+
+static int oldDataJson(char *json, size_t len, const SensorReadings &r, uint32_t seq, uint32_t uptimeMs)
+{
+    return snprintf(json, len,
+        "{\"seq\":%lu,\"iaq\":%.2f,\"co2\":%.2f,\"temp\":%.2f,\"hum\":%.2f,\"press\":%.2f,\"volt\":%.2f,\"acc\":%d,\"uptime\":%lu,\"isRec\":%s,\"recFile\":\"%s\"}",
+        (unsigned long)seq, r.iaq, r.co2, r.temp, r.hum, r.press, r.voltage, r.accuracy,
+        (unsigned long)uptimeMs, "true", "/log_007.csv");
+}
+
+static volatile int sink;
+
+template <typename F>
+static double timeNs(int iterations, F fn)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        sink += fn(i);
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / iterations;
+}
+
+static void bench(int iterations)
+{
+    LogData s;
+    SensorReadings r;
+    r.press = 101325.0f;
+    r.voltage = 3.91f;
+    r.accuracy = 3;
+    char buf[544];
+
+    auto sample = [&](int i) {
+        s.timestamp = 1000 + i * 3000UL;
+        s.iaq = 25.0f + (i % 400) * 0.37f;
+        s.co2 = 450.0f + (i % 900) * 3.11f;
+        s.temp = -5.5f + (i % 500) * 0.07f;
+        s.hum = 40.0f + (i % 30) * 0.53f;
+        r.iaq = s.iaq;
+        r.co2 = s.co2;
+        r.temp = s.temp;
+        r.hum = s.hum;
+    };
+
+    double oldCsv = timeNs(iterations, [&](int i) { sample(i); return oldCsvLine(buf, sizeof(buf), s); });
+    double newCsv = timeNs(iterations, [&](int i) { sample(i); return logCsvFormatLine(buf, sizeof(buf), s); });
+    double oldJson = timeNs(iterations, [&](int i) { sample(i); return oldDataJson(buf, sizeof(buf), r, i, i * 3000u); });
+    double newJson = timeNs(iterations, [&](int i) { sample(i); return apiDataJson(buf, sizeof(buf), r, i, i * 3000u, true, "/log_007.csv"); });
+    double oldBle = timeNs(iterations, [&](int i) { sample(i); return snprintf(buf, 16, "%.2f", s.iaq); });
+    double newBle = timeNs(iterations, [&](int i) { sample(i); return fmtFixedTo(buf, 16, s.iaq, 2); });
+
+    printf("\n%-14s %12s %12s %8s\n", "ns/op", "snprintf", "fmtFixed", "speedup");
+    printf("%-14s %12.1f %12.1f %7.2fx\n", "csv line", oldCsv, newCsv, oldCsv / newCsv);
+    printf("%-14s %12.1f %12.1f %7.2fx\n", "/api/data", oldJson, newJson, oldJson / newJson);
+    printf("%-14s %12.1f %12.1f %7.2fx\n", "ble value", oldBle, newBle, oldBle / newBle);
+}
+
+void setUp()
+{
+    mismatches = 0;
+}
+
+void tearDown() {}
+
+static void test_special_values()
+{
+    checkSpecial();
+    TEST_ASSERT_EQUAL_UINT32(0, mismatches);
+}
+
+static void test_sensor_ranges()
+{
+    for (const Range &r : ranges)
+        checkRange(r, SAMPLES, EXHAUSTIVE);
+    printf("%lu checks, %lu mismatches\n", checked, mismatches);
+    TEST_ASSERT_EQUAL_UINT32(0, mismatches);
+}
+
+static void test_against_snprintf()
+{
+    bench(BENCH_ITERATIONS);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_special_values);
+    RUN_TEST(test_sensor_ranges);
+    RUN_TEST(test_against_snprintf);
+    return UNITY_END();
+}
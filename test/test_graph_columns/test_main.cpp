@@ -0,0 +1,195 @@
+// Graph screen per-frame cost (GraphHistory.h): the incremental autoscale
+// range must match a full rescan, and the cached columns are timed against
+// the previous drawGraph().
+//
+// Run: pio test -e native -f test_graph_columns
+//
+// "rescan" is the previous drawGraph(): scan every point for min/max, then
+// two float divisions per column. "columns" is graphSpanColumns() after a
+// new sample (cache miss), "cached" is a redraw with no new data.
+#include "GraphHistory.h"
+#include <unity.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#define TOP 20
+#define BOTTOM 60
+#define FRAMES 20000
+
+static volatile int sink;
+static unsigned long t = 0;
+
+static int oldGraphY(float val, float minVal, float maxVal)
+{
+    int y = BOTTOM - ((val - minVal) / (maxVal - minVal)) * (BOTTOM - TOP);
+    if (y < TOP)
+        y = TOP;
+    if (y > BOTTOM)
+        y = BOTTOM;
+    return y;
+}
+
+static int rescanFrame(int span, int channel)
+{
+    int limit = graphSpanPoints(span);
+    float minVal = 100000;
+    float maxVal = -100000;
+    for (int i = 0; i < limit; i++)
+    {
+        GraphPoint p = graphSpanPoint(span, channel, i);
+        if (p.minV < minVal)
+            minVal = p.minV;
+        if (p.maxV > maxVal)
+            maxVal = p.maxV;
+    }
+    if (maxVal - minVal < 2)
+    {
+        maxVal += 1;
+        minVal -= 1;
+    }
+
+    int acc = 0;
+    for (int x = 0; x < limit; x++)
+    {
+        GraphPoint p = graphSpanPoint(span, channel, x);
+        acc += oldGraphY(p.meanV, minVal, maxVal);
+        if (span > 0)
+            acc += oldGraphY(p.maxV, minVal, maxVal) + oldGraphY(p.minV, minVal, maxVal);
+    }
+    return acc;
+}
+
+static float sample(int i, int channel)
+{
+    return 400.0f + channel * 50.0f + 40.0f * sinf(i * 0.05f) + (rand() % 100) * 0.1f;
+}
+
+static void feed(int count)
+{
+    float values[GRAPH_COUNT];
+    for (int i = 0; i < count; i++)
+    {
+        for (int g = 0; g < GRAPH_COUNT; g++)
+            values[g] = sample(i, g);
+        graphHistoryAdd(t, values);
+        t += 3000;
+    }
+}
+
+// Incremental range must match a full scan for every span and channel
+static int checkRanges()
+{
+    int mismatches = 0;
+    for (int span = 0; span < GRAPH_SPAN_COUNT; span++)
+    {
+        for (int ch = 0; ch < GRAPH_COUNT; ch++)
+        {
+            int n = graphSpanPoints(span);
+            float lo = 1e30f, hi = -1e30f, qlo, qhi;
+            for (int i = 0; i < n; i++)
+            {
+                GraphPoint p = graphSpanPoint(span, ch, i);
+                lo = p.minV < lo ? p.minV : lo;
+                hi = p.maxV > hi ? p.maxV : hi;
+            }
+            if (n > 0 && (!graphSpanRange(span, ch, qlo, qhi) || qlo != lo || qhi != hi))
+                mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_range_matches_rescan()
+{
+    // Four days of 3 s samples fills every tier
+    int mismatches = 0;
+    for (int chunk = 0; chunk < 120; chunk++)
+    {
+        feed(1000);
+        mismatches += checkRanges();
+    }
+    TEST_ASSERT_EQUAL_INT(0, mismatches);
+}
+
+static void test_columns_cached_until_new_sample()
+{
+    static GraphColumns cols;
+    float values[GRAPH_COUNT] = {0};
+    graphHistoryAdd(t, values);
+    t += 3000;
+
+    TEST_ASSERT_TRUE(graphSpanColumns(0, 0, TOP, BOTTOM, cols));
+    TEST_ASSERT_FALSE(graphSpanColumns(0, 0, TOP, BOTTOM, cols));
+    TEST_ASSERT_TRUE(graphSpanColumns(1, 0, TOP, BOTTOM, cols));
+    graphHistoryAdd(t, values);
+    t += 3000;
+    TEST_ASSERT_TRUE(graphSpanColumns(1, 0, TOP, BOTTOM, cols));
+    for (int x = 0; x < cols.count; x++)
+    {
+        TEST_ASSERT_TRUE(cols.yTop[x] >= TOP && cols.yBottom[x] <= BOTTOM);
+        TEST_ASSERT_TRUE(cols.yTop[x] <= cols.yMean[x] && cols.yMean[x] <= cols.yBottom[x]);
+    }
+}
+
+static void test_frame_cost()
+{
+    static GraphColumns cols;
+    float values[GRAPH_COUNT] = {0};
+
+    for (int span = 0; span < GRAPH_SPAN_COUNT; span++)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        for (int f = 0; f < FRAMES; f++)
+            sink = rescanFrame(span, f % GRAPH_COUNT);
+        auto t1 = std::chrono::steady_clock::now();
+
+        // New sample before every frame: always a cache miss
+        for (int f = 0; f < FRAMES; f++)
+        {
+            values[0] = sample(f, 0);
+            graphHistoryAdd(t, values);
+            t += 3000;
+            graphSpanColumns(span, 0, TOP, BOTTOM, cols);
+            sink = cols.yMean[0];
+        }
+        auto t2 = std::chrono::steady_clock::now();
+
+        for (int f = 0; f < FRAMES; f++)
+        {
+            graphSpanColumns(span, 0, TOP, BOTTOM, cols);
+            sink = cols.yMean[0];
+        }
+        auto t3 = std::chrono::steady_clock::now();
+
+        // The columns run includes graphHistoryAdd, so time it on its own
+        for (int f = 0; f < FRAMES; f++)
+        {
+            values[0] = sample(f, 0);
+            graphHistoryAdd(t, values);
+            t += 3000;
+        }
+        auto t4 = std::chrono::steady_clock::now();
+
+        double rescanNs = std::chrono::duration<double, std::nano>(t1 - t0).count() / FRAMES;
+        double addNs = std::chrono::duration<double, std::nano>(t4 - t3).count() / FRAMES;
+        double columnsNs = std::chrono::duration<double, std::nano>(t2 - t1).count() / FRAMES - addNs;
+        double cachedNs = std::chrono::duration<double, std::nano>(t3 - t2).count() / FRAMES;
+
+        printf("span %-4s  rescan %8.1f ns  columns %8.1f ns  cached %6.1f ns  add %6.1f ns\n",
+               graphSpanLabel(span), rescanNs, columnsNs, cachedNs, addNs);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_range_matches_rescan);
+    RUN_TEST(test_columns_cached_until_new_sample);
+    RUN_TEST(test_frame_cost);
+    return UNITY_END();
+}
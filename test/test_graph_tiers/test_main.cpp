@@ -0,0 +1,163 @@
+// Multi-resolution graph tiers (GraphHistory.h): every 1m / 15m / 1h point
+// must equal the min / max / mean of the raw samples in its time slot, and
+// the O(1) per-sample update is timed against the readout of a full span.
+//
+// Run: pio test -e native -f test_graph_tiers
+//
+// "add" is graphHistoryAdd() per sample (raw ring plus every tier), "span"
+// is reading all points of one span and channel for a frame.
+#include "GraphHistory.h"
+#include <unity.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#define PERIOD_MS 3000
+#define SAMPLES 1000000 // ~35 days at 3 s, inside the u32 ms timestamp range
+#define FRAMES 200000
+
+static const uint32_t bucketMs[GRAPH_TIER_COUNT] = {60000UL, 900000UL, 3600000UL};
+
+struct Sample
+{
+    uint32_t t;
+    float v[GRAPH_COUNT];
+};
+
+static std::vector<Sample> history;
+static uint32_t t = 1000;
+static volatile float sink;
+
+static void add(int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        Sample s;
+        s.t = t;
+        for (int g = 0; g < GRAPH_COUNT; g++)
+            s.v[g] = 400.0f + g * 50.0f + 40.0f * sinf(t * 1e-5f) + (rand() % 100) * 0.1f;
+        graphHistoryAdd(s.t, s.v);
+        history.push_back(s);
+        t += PERIOD_MS;
+    }
+}
+
+// The last points of a tier, rebuilt from every sample: one group per
+// time slot that saw a sample, newest last
+static void checkTier(int tier)
+{
+    struct Group
+    {
+        uint32_t start;
+        float minV[GRAPH_COUNT];
+        float maxV[GRAPH_COUNT];
+        double sum[GRAPH_COUNT];
+        int count;
+    };
+    std::vector<Group> groups;
+    for (const Sample &s : history)
+    {
+        uint32_t start = s.t - s.t % bucketMs[tier];
+        if (groups.empty() || groups.back().start != start)
+        {
+            Group g = {start, {}, {}, {}, 0};
+            for (int c = 0; c < GRAPH_COUNT; c++)
+            {
+                g.minV[c] = s.v[c];
+                g.maxV[c] = s.v[c];
+            }
+            groups.push_back(g);
+        }
+        Group &g = groups.back();
+        for (int c = 0; c < GRAPH_COUNT; c++)
+        {
+            g.minV[c] = s.v[c] < g.minV[c] ? s.v[c] : g.minV[c];
+            g.maxV[c] = s.v[c] > g.maxV[c] ? s.v[c] : g.maxV[c];
+            g.sum[c] += s.v[c];
+        }
+        g.count++;
+    }
+
+    int span = tier + 1;
+    int points = graphSpanPoints(span);
+    int expect = groups.size() < GRAPH_WIDTH ? (int)groups.size() : GRAPH_WIDTH;
+    TEST_ASSERT_EQUAL_INT(expect, points);
+    for (int i = 0; i < points; i++)
+    {
+        const Group &g = groups[groups.size() - points + i];
+        for (int c = 0; c < GRAPH_COUNT; c++)
+        {
+            GraphPoint p = graphSpanPoint(span, c, i);
+            TEST_ASSERT_EQUAL_FLOAT(g.minV[c], p.minV);
+            TEST_ASSERT_EQUAL_FLOAT(g.maxV[c], p.maxV);
+            // The tier sums in float
+            TEST_ASSERT_FLOAT_WITHIN(0.01f, (float)(g.sum[c] / g.count), p.meanV);
+        }
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_buckets_match_samples()
+{
+    // Four and a half days with the device off now and then, so some slots
+    // stay empty and buckets close across the gaps
+    for (int stretch = 0; stretch < 9; stretch++)
+    {
+        for (int chunk = 0; chunk < 8; chunk++)
+        {
+            add(1800);
+            for (int tier = 0; tier < GRAPH_TIER_COUNT; tier++)
+                checkTier(tier);
+        }
+        t += 20 * 60000 + 1234; // Off for 20 min
+    }
+    TEST_ASSERT_EQUAL_INT(GRAPH_WIDTH, graphSpanPoints(GRAPH_TIER_COUNT));
+}
+
+static void test_update_cost()
+{
+    history.clear();
+    std::vector<Sample> samples(SAMPLES);
+    for (Sample &s : samples)
+    {
+        s.t = t;
+        for (int g = 0; g < GRAPH_COUNT; g++)
+            s.v[g] = 400.0f + g * 50.0f + (rand() % 1000) * 0.1f;
+        t += PERIOD_MS;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (const Sample &s : samples)
+        graphHistoryAdd(s.t, s.v);
+    auto t1 = std::chrono::steady_clock::now();
+    printf("add        %6.1f ns/sample over %d samples\n",
+           std::chrono::duration<double, std::nano>(t1 - t0).count() / SAMPLES, SAMPLES);
+
+    for (int span = 0; span < GRAPH_SPAN_COUNT; span++)
+    {
+        auto s0 = std::chrono::steady_clock::now();
+        for (int f = 0; f < FRAMES; f++)
+        {
+            int n = graphSpanPoints(span);
+            float acc = 0;
+            for (int i = 0; i < n; i++)
+                acc += graphSpanPoint(span, f % GRAPH_COUNT, i).meanV;
+            sink = acc;
+        }
+        auto s1 = std::chrono::steady_clock::now();
+        printf("span %-4s  %6.1f ns/frame for %d points\n", graphSpanLabel(span),
+               std::chrono::duration<double, std::nano>(s1 - s0).count() / FRAMES, graphSpanPoints(span));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_buckets_match_samples);
+    RUN_TEST(test_update_cost);
+    return UNITY_END();
+}
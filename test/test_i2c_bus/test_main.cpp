@@ -0,0 +1,250 @@
+// Simulated-clock check for the shared I2C bus schedule (I2CBus.h).
+//
+// Replays a BSEC measurement schedule on the BME688 together with UI
+// traffic on the SSD1306 for an hour per scenario. Every transaction holds
+// the bus for its bytes at I2C_BUS_CLOCK. Compares the previous unscheduled
+// full-frame push with DisplayDiff's chunked push that yields to the
+// sensor: how late BSEC got the bus for a measurement, and how long a UI
+// change took to reach the panel.
+//
+// Run: pio test -e native -f test_i2c_bus
+#include "I2CBus.h"
+#include "DisplayDiff.h"
+#include "HalHost.h"
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+// Model of the firmware around the bus
+#define SIM_MS 3600000
+#define LOOP_PASS_US 1000   // One awake loop pass
+#define OUTPUT_LAG_MS 150   // Cycle start -> field data read (TPH + heater)
+#define PANEL_ADDR 0x3C
+#define SENSOR_ADDR 0x77
+#define BYTE_US (9.0 * 1000000.0 / I2C_BUS_CLOCK)
+
+struct Scenario
+{
+    const char *name;
+    uint32_t periodMs;   // BSEC sample period
+    uint32_t uiPeriodMs; // A full-screen change this often
+};
+
+// UI periods don't divide the sample period, so pushes sweep across every
+// phase of the sensor cycle
+static const Scenario scenarios[] = {
+    {"REALTIME graph", 1000, 97},
+    {"NORMAL graph", 3000, 97},
+    {"NORMAL menu", 3000, 1013},
+    {"ECO screen on", 3000, 251},
+};
+
+struct Result
+{
+    uint32_t cycles = 0;
+    uint32_t lateMaxUs = 0;      // Cycle due -> sensor got the bus
+    uint32_t overlaps = 0;       // Display transfers running into a cycle
+    uint32_t frames = 0;
+    uint32_t frameMaxMs = 0;     // UI change -> fully on the panel
+    uint32_t deferrals = 0;
+};
+
+static uint8_t frame[128 * 8];
+
+// --- Bus model: a transaction holds the bus for its bytes ---
+struct Busy
+{
+    uint64_t startUs;
+    uint64_t endUs;
+};
+static std::vector<Busy> displayBusy;
+static uint64_t clockUs = 0;
+
+static uint64_t nowUs()
+{
+    return clockUs;
+}
+
+static void advanceUs(uint64_t us)
+{
+    clockUs += us;
+    halHostAdvanceUs((uint32_t)us);
+}
+
+static bool sink(uint8_t addr, const uint8_t *wr, size_t wlen, uint8_t *rd, size_t rlen)
+{
+    uint64_t start = nowUs();
+    advanceUs((uint64_t)((1 + wlen + (rlen ? 1 + rlen : 0)) * BYTE_US + 0.5));
+    if (addr == PANEL_ADDR)
+        displayBusy.push_back({start, nowUs()});
+    return true;
+}
+
+// The push this replaced: the Adafruit driver sent the whole frame in
+// Wire-buffer chunks, whatever the sensor was doing
+static void unscheduledPush()
+{
+    uint8_t cmd[7] = {0x00, 0x22, 0, 7, 0x21, 0, 127};
+    halI2cWrite(PANEL_ADDR, cmd, sizeof(cmd));
+    for (size_t i = 0; i < sizeof(frame); i += 127)
+    {
+        uint8_t buf[128] = {0x40};
+        size_t n = sizeof(frame) - i < 127 ? sizeof(frame) - i : 127;
+        memcpy(buf + 1, frame + i, n);
+        halI2cWrite(PANEL_ADDR, buf, 1 + n);
+    }
+}
+
+// One BSEC cycle's bus traffic: heater + forced mode at the start, field
+// data once the measurement is done
+static void sensorCycleStart()
+{
+    uint8_t heater[6] = {0};
+    uint8_t meas = 0x25;
+    i2cSensorWriteRegs(SENSOR_ADDR, 0x64, heater, sizeof(heater));
+    i2cSensorWriteRegs(SENSOR_ADDR, 0x74, &meas, 1);
+}
+
+static void sensorCycleRead()
+{
+    uint8_t field[17];
+    i2cSensorReadRegs(SENSOR_ADDR, 0x1D, field, sizeof(field));
+}
+
+static Result run(const Scenario &sc, bool scheduled)
+{
+    Result res;
+    displayBusy.clear();
+    i2cBusSetSensorPeriod(sc.periodMs);
+    displayInvalidate();
+    uint32_t deferralsBefore = getI2CBusStats().displayDeferrals;
+
+    uint64_t startUs = nowUs();
+    uint64_t endUs = startUs + (uint64_t)SIM_MS * 1000;
+    uint64_t sensorDue = startUs + 500000;
+    uint64_t readDue = 0;
+    uint64_t nextUi = startUs;
+    uint64_t changedAt = 0;
+    bool dirty = false;
+    std::vector<uint64_t> dues;
+    int pattern = 0;
+
+    while (nowUs() < endUs)
+    {
+        uint64_t passStart = nowUs();
+
+        // Sensor task: takes the bus as soon as its cycle is due
+        if (passStart >= sensorDue)
+        {
+            uint32_t late = (uint32_t)(passStart - sensorDue);
+            // The bus learns the schedule from the first cycle
+            if (res.cycles > 0 && late > res.lateMaxUs)
+                res.lateMaxUs = late;
+            if (res.cycles > 0)
+                dues.push_back(sensorDue);
+            res.cycles++;
+            sensorCycleStart();
+            readDue = sensorDue + OUTPUT_LAG_MS * 1000;
+            sensorDue += (uint64_t)sc.periodMs * 1000;
+        }
+        if (readDue && nowUs() >= readDue)
+        {
+            sensorCycleRead();
+            readDue = 0;
+        }
+
+        // UI: a full-screen change (graph scroll, page switch)
+        if (nowUs() >= nextUi)
+        {
+            pattern++;
+            for (size_t i = 0; i < sizeof(frame); i++)
+                frame[i] = (uint8_t)(pattern * 7 + i);
+            if (!dirty)
+                changedAt = nowUs();
+            dirty = true;
+            nextUi += (uint64_t)sc.uiPeriodMs * 1000;
+        }
+        if (dirty || displayPending())
+        {
+            if (scheduled)
+                displayPush();
+            else
+                unscheduledPush();
+            if (!displayPending())
+            {
+                uint32_t ms = (uint32_t)((nowUs() - changedAt) / 1000);
+                if (ms > res.frameMaxMs)
+                    res.frameMaxMs = ms;
+                res.frames++;
+                dirty = false;
+            }
+        }
+
+        uint64_t spent = nowUs() - passStart;
+        if (spent < LOOP_PASS_US)
+            advanceUs(LOOP_PASS_US - spent);
+    }
+
+    // No display transfer may still hold the bus when a cycle is due, nor
+    // start inside the guard window before it
+    size_t b = 0;
+    for (uint64_t due : dues)
+    {
+        while (b < displayBusy.size() && displayBusy[b].endUs <= due - I2C_SENSOR_GUARD_MS * 1000ULL)
+            b++;
+        if (b < displayBusy.size() && displayBusy[b].startUs < due)
+            res.overlaps++;
+    }
+    res.deferrals = getI2CBusStats().displayDeferrals - deferralsBefore;
+    return res;
+}
+
+void setUp()
+{
+    halHostManualClock(0);
+    clockUs = 0;
+    halHostSetI2cSink(sink);
+    initI2CBus(0, 0);
+    initDisplayDiff(frame, PANEL_ADDR);
+}
+
+void tearDown()
+{
+    halHostSetI2cSink(nullptr);
+}
+
+static void test_sensor_cycles_keep_the_bus()
+{
+    printf("%-16s %-11s %7s %10s %9s %8s %11s %10s\n", "scenario", "push", "cycles", "late max", "overlaps", "frames",
+           "frame max", "deferred");
+    for (const Scenario &sc : scenarios)
+    {
+        Result r[2];
+        for (int p = 0; p < 2; p++)
+        {
+            r[p] = run(sc, p == 1);
+            printf("%-16s %-11s %7u %8.1fms %9u %8u %9ums %10u\n", sc.name, p ? "scheduled" : "unscheduled",
+                   (unsigned)r[p].cycles, r[p].lateMaxUs / 1000.0, (unsigned)r[p].overlaps, (unsigned)r[p].frames,
+                   (unsigned)r[p].frameMaxMs, (unsigned)r[p].deferrals);
+        }
+
+        // Scheduled: the display never holds the bus into a cycle, so BSEC
+        // only waits for the loop pass it lands in
+        TEST_ASSERT_EQUAL_UINT32(0, r[1].overlaps);
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(LOOP_PASS_US, r[1].lateMaxUs);
+        TEST_ASSERT_EQUAL_UINT32(r[0].cycles, r[1].cycles);
+
+        // ...and the panel still keeps up: every change gets out, a frame
+        // waiting at most the guard window plus one more frame transfer
+        TEST_ASSERT_EQUAL_UINT32(r[0].frames, r[1].frames);
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(2 * r[0].frameMaxMs + I2C_SENSOR_GUARD_MS, r[1].frameMaxMs);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_sensor_cycles_keep_the_bus);
+    return UNITY_END();
+}
@@ -0,0 +1,143 @@
+// Simulated-clock check for the latency monitor (LatencyMonitor.h).
+//
+// Drives the loop's latency hooks from a virtual microsecond clock: loop
+// passes, button presses (edge -> release -> click handler), frames paced
+// at the UI refresh rate, and the blocking menu actions that hold the loop
+// (force save 2.5 s, BLE toggle 0.5 s). Prints the same p50 / p99 / max the
+// STATS page and /api/latency report, so the histogram maths can be checked
+// against known inputs.
+//
+// Run: pio test -e native -f test_latency_monitor
+#include "LatencyMonitor.h"
+#include <unity.h>
+#include <cstdio>
+
+// Model of the firmware around the monitor
+#define PASS_BUSY_US 400       // Plain loop pass (button tick, dirty checks)
+#define PASS_WAIT_US 1000      // vTaskDelay(1) at the end of an awake pass
+#define REFRESH_US 100000      // NORMAL refresh cap (main.cpp)
+#define PUSH_US 9000           // Diffed SSD1306 push of a menu frame at 400 kHz
+#define DEBOUNCE_US 50000      // OneButton debounce before the click fires
+#define PRESS_GAP_MIN_US 1500000
+#define PRESS_GAP_SPAN_US 3000000
+#define HOLD_MIN_US 60000
+#define HOLD_SPAN_US 180000
+#define IGNORE_EVERY 25        // Presses swallowed by the post-wake lockout
+#define BLOCKING_EVERY 40      // Presses that land on a blocking menu action
+#define SIM_MINUTES 60
+
+static uint32_t rng = 12345;
+static uint32_t rnd(uint32_t span)
+{
+    rng = rng * 1664525u + 1013904223u;
+    return span ? (rng >> 8) % span : 0;
+}
+
+static void printHist(const char *name, const Histogram &h)
+{
+    printf("%-14s n=%-7u p50 %8.1f ms  p99 %8.1f ms  max %8.1f ms  mean %8.1f ms\n",
+           name, (unsigned)h.count,
+           h.percentile(50) / 1000.0, h.percentile(99) / 1000.0,
+           h.max / 1000.0, h.mean() / 1000.0);
+}
+
+void setUp()
+{
+    resetLatencyStats();
+}
+
+void tearDown() {}
+
+static void test_simulated_hour()
+{
+    uint32_t minutes = SIM_MINUTES;
+    uint64_t endUs = (uint64_t)minutes * 60 * 1000000;
+
+    uint64_t now = 0;
+    uint64_t lastFrame = 0;
+    uint64_t nextPress = PRESS_GAP_MIN_US;
+    uint64_t releaseAt = 0;
+    uint64_t clickAt = 0;
+    bool held = false;
+    bool dirty = false;
+    uint32_t presses = 0;
+    uint32_t expectedIgnored = 0;
+
+    while (now < endUs)
+    {
+        uint64_t passStart = now;
+        now += PASS_BUSY_US;
+
+        // Edge stamped by the ISR, forwarded at the top of the next pass
+        if (!held && clickAt == 0 && passStart >= nextPress)
+        {
+            latencyInputEdge((uint32_t)nextPress);
+            held = true;
+            releaseAt = nextPress + HOLD_MIN_US + rnd(HOLD_SPAN_US);
+            presses++;
+        }
+        if (held && passStart >= releaseAt)
+        {
+            held = false;
+            clickAt = releaseAt + DEBOUNCE_US;
+        }
+        if (clickAt && passStart >= clickAt)
+        {
+            clickAt = 0;
+            nextPress = now + PRESS_GAP_MIN_US + rnd(PRESS_GAP_SPAN_US);
+            if (presses % IGNORE_EVERY == 0)
+            {
+                // Handler bailed out; the button goes idle with nothing drawn
+                latencyInputIdle();
+                expectedIgnored++;
+            }
+            else if (presses % BLOCKING_EVERY == 0)
+            {
+                // Action pushes its own status screen, then blocks
+                latencyInputHandled();
+                now += PUSH_US;
+                latencyFrameShown((uint32_t)now);
+                now += (presses / BLOCKING_EVERY) % 2 ? 2500000 : 500000;
+                dirty = true;
+            }
+            else
+            {
+                latencyInputHandled();
+                dirty = true;
+            }
+        }
+
+        // Frame interval caps the rate; dirty decides whether to draw
+        if (dirty && now - lastFrame > REFRESH_US)
+        {
+            now += PUSH_US;
+            latencyFrameShown((uint32_t)now);
+            lastFrame = now;
+            dirty = false;
+        }
+
+        latencyLoopPass((uint32_t)(now - passStart));
+        now += PASS_WAIT_US;
+    }
+
+    const LatencyStats &s = getLatencyStats();
+    printf("simulated %u min, %u presses\n", (unsigned)minutes, (unsigned)presses);
+    printHist("loop pass", s.loopUs);
+    printHist("input->pixel", s.inputToPixelUs);
+    printf("ignored        %u (expected %u)\n", (unsigned)s.inputsIgnored, (unsigned)expectedIgnored);
+
+    TEST_ASSERT_EQUAL_UINT32(expectedIgnored, s.inputsIgnored);
+    TEST_ASSERT_EQUAL_UINT32(presses - expectedIgnored, s.inputToPixelUs.count);
+    // A press shows up no sooner than hold + debounce; the blocking
+    // actions draw first, so their 2.5 s lands on the loop pass instead
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(HOLD_MIN_US + DEBOUNCE_US, s.inputToPixelUs.percentile(50));
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(2500000, s.loopUs.max);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(s.inputToPixelUs.max, s.inputToPixelUs.percentile(99));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_simulated_hour);
+    return UNITY_END();
+}
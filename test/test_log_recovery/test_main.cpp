@@ -0,0 +1,282 @@
+// Boot-time recovery of an interrupted recording (recoverLogSession() in
+// LogWriter.h). A recording made by the writer is torn at every byte
+// offset; recovery must cut it back to the last complete CSV line or
+// binary block, and resuming must append cleanly after it, with binary
+// block numbers continuing from the last good block. A tail that can't be
+// truncated ends the segment in the index instead.
+//
+// Run: pio test -e native -f test_log_recovery
+//
+// Files are created under HAL_FS_ROOT (default .pio/native_fs).
+#include "LogWriter.h"
+#include "SharedData.h"
+#include "HalHost.h"
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#define RECORDED 200 // Spans a 4 KiB flash block in CSV, several binary blocks
+#define RESUMED 70
+
+static const char *csvName = "/log_001.csv";
+static const char *binName = "/log_001.hlg";
+static const char *sessionName = "/rec_session.bin"; // LogWriter's marker
+
+// Index hooks: what recovery told the manifest
+static char sizedFile[32];
+static long sizedTo = -1;
+static int truncates = 0;
+static bool failTruncate = false;
+
+static void indexSetSize(const char *fileName, uint32_t size)
+{
+    snprintf(sizedFile, sizeof(sizedFile), "%s", fileName);
+    sizedTo = size;
+}
+
+static bool fileHook(HalHostFileOp op, const char *path, size_t offset, size_t len)
+{
+    if (op != HAL_HOST_TRUNCATE)
+        return true;
+    truncates++;
+    return !failTruncate;
+}
+
+static LogData sampleAt(int i)
+{
+    LogData s;
+    s.timestamp = 1000 + i * 3000UL;
+    s.iaq = 25.0f + (i % 400) * 0.37f;
+    s.co2 = 450.0f + (i % 900) * 3.11f;
+    s.temp = -5.5f + (i % 500) * 0.07f;
+    s.hum = 40.0f + (i % 30) * 0.53f;
+    return s;
+}
+
+static std::vector<uint8_t> readFile(const char *name)
+{
+    long size = halFileSize(name);
+    std::vector<uint8_t> data(size > 0 ? size : 0);
+    halFileRead(name, 0, data.data(), data.size());
+    return data;
+}
+
+// Records samples first..first+count-1 into name through the writer
+static void record(const char *name, int first, int count)
+{
+    snprintf(currentLogFileName, sizeof(currentLogFileName), "%s", name);
+    for (int i = first; i < first + count; i++)
+        TEST_ASSERT_TRUE(logWriterPush(sampleAt(i)));
+    logWriterClose();
+}
+
+// Every sample in a file, in order; binary block numbers must count up
+// from 0 without gaps
+static std::vector<LogData> decode(const char *name)
+{
+    std::vector<uint8_t> data = readFile(name);
+    std::vector<LogData> out;
+    if (data.empty())
+        return out;
+    if (strstr(name, ".hlg"))
+    {
+        LogBinHeader hdr;
+        TEST_ASSERT_TRUE(logBinDecodeHeader(data.data(), data.size(), hdr));
+        size_t offset = LOG_BIN_HEADER_SIZE;
+        uint16_t expectSeq = 0;
+        while (offset < data.size())
+        {
+            LogData block[LOG_BIN_BLOCK_MAX_RECORDS];
+            size_t consumed = 0;
+            uint16_t seq = 0;
+            int n = logBinDecodeBlock(data.data() + offset, data.size() - offset, block, LOG_BIN_BLOCK_MAX_RECORDS, consumed, &seq);
+            TEST_ASSERT_TRUE(n > 0);
+            TEST_ASSERT_EQUAL_UINT32(expectSeq++, seq);
+            out.insert(out.end(), block, block + n);
+            offset += consumed;
+        }
+    }
+    else
+    {
+        size_t start = 0;
+        bool header = true;
+        for (size_t i = 0; i < data.size(); i++)
+        {
+            if (data[i] != '\n')
+                continue;
+            LogData s;
+            bool ok = logCsvParseLine((const char *)data.data() + start, i - start, s);
+            TEST_ASSERT_TRUE(ok != header);
+            if (ok)
+                out.push_back(s);
+            header = false;
+            start = i + 1;
+        }
+        TEST_ASSERT_EQUAL_UINT32(data.size(), start); // No partial line
+    }
+    return out;
+}
+
+// Where recovery has to cut a file torn at offset torn: the end of the
+// last complete line / block of the intact recording
+static size_t validLength(const std::vector<size_t> &boundaries, size_t torn)
+{
+    size_t valid = 0;
+    for (size_t b : boundaries)
+    {
+        if (b <= torn)
+            valid = b;
+    }
+    return valid;
+}
+
+static std::vector<size_t> boundaries(const char *name, const std::vector<uint8_t> &data)
+{
+    std::vector<size_t> out;
+    if (strstr(name, ".hlg"))
+    {
+        size_t offset = LOG_BIN_HEADER_SIZE;
+        out.push_back(offset);
+        while (offset < data.size())
+        {
+            LogData block[LOG_BIN_BLOCK_MAX_RECORDS];
+            size_t consumed = 0;
+            logBinDecodeBlock(data.data() + offset, data.size() - offset, block, LOG_BIN_BLOCK_MAX_RECORDS, consumed);
+            offset += consumed;
+            out.push_back(offset);
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < data.size(); i++)
+        {
+            if (data[i] == '\n')
+                out.push_back(i + 1);
+        }
+    }
+    return out;
+}
+
+static void tearAtEveryOffset(const char *name)
+{
+    record(name, 0, RECORDED);
+    std::vector<uint8_t> intact = readFile(name);
+    std::vector<size_t> cuts = boundaries(name, intact);
+    TEST_ASSERT_EQUAL_UINT32(RECORDED, decode(name).size());
+
+    for (size_t torn = 0; torn <= intact.size(); torn++)
+    {
+        halFileWrite(name, intact.data(), torn, false);
+        logSessionBegin(name, 1);
+        truncates = 0;
+        sizedTo = -1;
+
+        char resumed[32] = "";
+        TEST_ASSERT_EQUAL_INT(LOG_RECOVER_RESUME, recoverLogSession(1, resumed, sizeof(resumed)));
+        TEST_ASSERT_EQUAL_STRING(name, resumed);
+
+        size_t valid = validLength(cuts, torn);
+        TEST_ASSERT_EQUAL_UINT32(valid, halFileSize(name));
+        TEST_ASSERT_EQUAL_UINT32(valid, sizedTo);
+        TEST_ASSERT_EQUAL_STRING(name, sizedFile);
+        TEST_ASSERT_EQUAL_INT(valid < torn ? 1 : 0, truncates);
+
+        // Complete samples before the tear survive; new ones follow them
+        std::vector<LogData> kept = decode(name);
+        record(resumed, (int)kept.size(), RESUMED);
+        logSessionEnd();
+
+        std::vector<LogData> all = decode(name);
+        TEST_ASSERT_EQUAL_UINT32(kept.size() + RESUMED, all.size());
+        for (size_t i = 0; i < all.size(); i++)
+        {
+            LogData want = sampleAt((int)i);
+            TEST_ASSERT_EQUAL_UINT32(want.timestamp, all[i].timestamp);
+            TEST_ASSERT_FLOAT_WITHIN(0.0051f, want.co2, all[i].co2);
+            TEST_ASSERT_FLOAT_WITHIN(0.0051f, want.temp, all[i].temp);
+        }
+    }
+}
+
+void setUp()
+{
+    // The host filesystem is shared by every suite: start from no recording
+    halFileRemove(csvName);
+    halFileRemove(binName);
+    halFileRemove(sessionName);
+
+    LogWriterIndex index = {};
+    index.setSize = indexSetSize;
+    logWriterSetIndex(index);
+    initLogWriter();
+    halHostSetFileHook(fileHook);
+    failTruncate = false;
+    truncates = 0;
+}
+
+void tearDown()
+{
+    halHostSetFileHook(nullptr);
+    logSessionEnd();
+    halFileRemove(csvName);
+    halFileRemove(binName);
+}
+
+static void test_csv_torn_at_every_offset()
+{
+    tearAtEveryOffset(csvName);
+}
+
+static void test_binary_torn_at_every_offset()
+{
+    tearAtEveryOffset(binName);
+}
+
+static void test_truncate_failure_starts_new_segment()
+{
+    const char *names[] = {csvName, binName};
+    for (const char *name : names)
+    {
+        record(name, 0, RECORDED);
+        std::vector<uint8_t> intact = readFile(name);
+        size_t torn = intact.size() - 5;
+        size_t valid = validLength(boundaries(name, intact), torn);
+        halFileWrite(name, intact.data(), torn, false);
+        logSessionBegin(name, 1);
+
+        failTruncate = true;
+        char resumed[32] = "";
+        TEST_ASSERT_EQUAL_INT(LOG_RECOVER_NEW_SEGMENT, recoverLogSession(1, resumed, sizeof(resumed)));
+        TEST_ASSERT_EQUAL_INT(1, truncates);
+
+        // The index ends the file at its valid length; the file itself is
+        // left alone and never appended to again
+        TEST_ASSERT_EQUAL_STRING(name, sizedFile);
+        TEST_ASSERT_EQUAL_UINT32(valid, sizedTo);
+        TEST_ASSERT_EQUAL_UINT32(torn, halFileSize(name));
+        TEST_ASSERT_EQUAL_INT(LOG_RECOVER_NONE, recoverLogSession(1, resumed, sizeof(resumed)));
+        truncates = 0;
+    }
+}
+
+static void test_stale_marker_is_dropped()
+{
+    record(csvName, 0, RECORDED);
+    logSessionBegin(csvName, 1);
+
+    char resumed[32] = "";
+    TEST_ASSERT_EQUAL_INT(LOG_RECOVER_NONE, recoverLogSession(2, resumed, sizeof(resumed)));
+    TEST_ASSERT_EQUAL_INT(LOG_RECOVER_NONE, recoverLogSession(1, resumed, sizeof(resumed)));
+    TEST_ASSERT_EQUAL_INT(0, truncates);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_csv_torn_at_every_offset);
+    RUN_TEST(test_binary_torn_at_every_offset);
+    RUN_TEST(test_truncate_failure_starts_new_segment);
+    RUN_TEST(test_stale_marker_is_dropped);
+    return UNITY_END();
+}
@@ -0,0 +1,205 @@
+// Playback of recordings (LogReplay.h) from files written the way the log
+// writer writes them: every sample comes back in order at 2-decimal
+// resolution, pacing follows the recorded timestamps, long gaps are
+// skipped, looping wraps, and a torn binary block ends playback.
+//
+// Run: pio test -e native -f test_log_replay
+//
+// Files are created under HAL_FS_ROOT (default .pio/native_fs).
+#include "LogReplay.h"
+#include "Hal.h"
+#include <unity.h>
+#include <string.h>
+#include <vector>
+
+#define SAMPLES 1000 // Spans many read chunks
+#define PERIOD_MS 3000
+
+static const char *csvPath = "/replay_test.csv";
+static const char *binPath = "/replay_test.hlg";
+
+static LogData sampleAt(int i)
+{
+    LogData s;
+    s.timestamp = 1000 + i * (unsigned long)PERIOD_MS;
+    s.iaq = 25.0f + (i % 400) * 0.37f;
+    s.co2 = 450.0f + (i % 900) * 3.11f;
+    s.temp = -5.5f + (i % 500) * 0.07f;
+    s.hum = 40.0f + (i % 30) * 0.53f;
+    return s;
+}
+
+static void writeCsv(const std::vector<LogData> &samples)
+{
+    std::vector<uint8_t> out(LOG_CSV_HEADER, LOG_CSV_HEADER + strlen(LOG_CSV_HEADER));
+    for (const LogData &s : samples)
+    {
+        char line[128];
+        int n = logCsvFormatLine(line, sizeof(line), s);
+        out.insert(out.end(), line, line + n);
+    }
+    halFileWrite(csvPath, out.data(), out.size(), false);
+}
+
+static void writeBinary(const std::vector<LogData> &samples)
+{
+    std::vector<uint8_t> out(LOG_BIN_HEADER_SIZE);
+    logBinEncodeHeader(out.data(), 1000, 1);
+    uint16_t seq = 0;
+    for (size_t i = 0; i < samples.size(); i += LOG_BIN_BLOCK_MAX_RECORDS)
+    {
+        int n = samples.size() - i < LOG_BIN_BLOCK_MAX_RECORDS ? (int)(samples.size() - i) : LOG_BIN_BLOCK_MAX_RECORDS;
+        uint8_t block[LOG_BIN_BLOCK_MAX_SIZE];
+        size_t len = logBinEncodeBlock(block, sizeof(block), seq++, &samples[i], n);
+        out.insert(out.end(), block, block + len);
+    }
+    halFileWrite(binPath, out.data(), out.size(), false);
+}
+
+static std::vector<LogData> recording(int count)
+{
+    std::vector<LogData> samples;
+    for (int i = 0; i < count; i++)
+        samples.push_back(sampleAt(i));
+    return samples;
+}
+
+// Plays path as fast as possible and compares with what was recorded
+static void checkPlayback(const char *path, const std::vector<LogData> &want)
+{
+    static LogReplay r;
+    TEST_ASSERT_TRUE(logReplayOpen(r, path, 0, false, 0));
+    LogData s;
+    size_t n = 0;
+    while (logReplayNext(r, 0, s))
+    {
+        TEST_ASSERT_TRUE(n < want.size());
+        TEST_ASSERT_EQUAL_UINT32(want[n].timestamp, s.timestamp);
+        TEST_ASSERT_FLOAT_WITHIN(0.0051f, want[n].iaq, s.iaq);
+        TEST_ASSERT_FLOAT_WITHIN(0.0051f, want[n].co2, s.co2);
+        TEST_ASSERT_FLOAT_WITHIN(0.0051f, want[n].temp, s.temp);
+        TEST_ASSERT_FLOAT_WITHIN(0.0051f, want[n].hum, s.hum);
+        n++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(want.size(), n);
+    TEST_ASSERT_EQUAL_UINT32(want.size(), r.samples);
+    TEST_ASSERT_EQUAL_UINT32(0, r.skipped);
+    TEST_ASSERT_FALSE(r.active);
+}
+
+void setUp() {}
+
+void tearDown()
+{
+    halFileRemove(csvPath);
+    halFileRemove(binPath);
+}
+
+static void test_csv_round_trip()
+{
+    std::vector<LogData> samples = recording(SAMPLES);
+    writeCsv(samples);
+    checkPlayback(csvPath, samples);
+}
+
+static void test_binary_round_trip()
+{
+    std::vector<LogData> samples = recording(SAMPLES);
+    writeBinary(samples);
+    checkPlayback(binPath, samples);
+}
+
+static void test_paced_by_timestamps()
+{
+    std::vector<LogData> samples = recording(10);
+    samples[5].timestamp += 10 * LOG_REPLAY_MAX_GAP_MS; // Device was off
+    for (int i = 6; i < 10; i++)
+        samples[i].timestamp = samples[5].timestamp + (i - 5) * PERIOD_MS;
+    writeBinary(samples);
+
+    static LogReplay r;
+    LogData s;
+    TEST_ASSERT_TRUE(logReplayOpen(r, binPath, 2.0f, false, 500));
+    TEST_ASSERT_TRUE(logReplayNext(r, 500, s));
+
+    // Double speed: the next sample is due 1.5 s later, not before
+    TEST_ASSERT_EQUAL_UINT32(500 + PERIOD_MS / 2, logReplayDueMs(r));
+    TEST_ASSERT_FALSE(logReplayNext(r, 500 + PERIOD_MS / 2 - 1, s));
+    TEST_ASSERT_TRUE(logReplayNext(r, 500 + PERIOD_MS / 2, s));
+    TEST_ASSERT_EQUAL_UINT32(samples[1].timestamp, s.timestamp);
+
+    // The long gap before sample 5 plays as no gap at all
+    uint32_t now = logReplayDueMs(r);
+    for (int i = 2; i < 4; i++)
+    {
+        TEST_ASSERT_TRUE(logReplayNext(r, now, s));
+        now = logReplayDueMs(r);
+    }
+    TEST_ASSERT_TRUE(logReplayNext(r, now, s));
+    TEST_ASSERT_EQUAL_UINT32(samples[4].timestamp, s.timestamp);
+    TEST_ASSERT_EQUAL_UINT32(now, logReplayDueMs(r));
+    TEST_ASSERT_TRUE(logReplayNext(r, now, s));
+    TEST_ASSERT_EQUAL_UINT32(samples[5].timestamp, s.timestamp);
+}
+
+static void test_loop_wraps()
+{
+    std::vector<LogData> samples = recording(5);
+    writeCsv(samples);
+
+    static LogReplay r;
+    LogData s;
+    TEST_ASSERT_TRUE(logReplayOpen(r, csvPath, 0, true, 0));
+    for (int i = 0; i < 12; i++)
+    {
+        TEST_ASSERT_TRUE(logReplayNext(r, 0, s));
+        TEST_ASSERT_EQUAL_UINT32(samples[i % 5].timestamp, s.timestamp);
+    }
+    TEST_ASSERT_EQUAL_UINT32(2, r.loops);
+    TEST_ASSERT_TRUE(r.active);
+}
+
+static void test_torn_block_ends_playback()
+{
+    std::vector<LogData> samples = recording(3 * LOG_BIN_BLOCK_MAX_RECORDS);
+    writeBinary(samples);
+
+    // Flip a byte inside the second block's records
+    uint8_t b;
+    uint32_t offset = LOG_BIN_HEADER_SIZE + LOG_BIN_BLOCK_MAX_SIZE + LOG_BIN_BLOCK_HEADER_SIZE + 3;
+    halFileRead(binPath, offset, &b, 1);
+    std::vector<uint8_t> file(halFileSize(binPath));
+    halFileRead(binPath, 0, file.data(), file.size());
+    file[offset] = b ^ 0xFF;
+    halFileWrite(binPath, file.data(), file.size(), false);
+
+    static LogReplay r;
+    LogData s;
+    TEST_ASSERT_TRUE(logReplayOpen(r, binPath, 0, false, 0));
+    uint32_t n = 0;
+    while (logReplayNext(r, 0, s))
+        n++;
+    TEST_ASSERT_EQUAL_UINT32(LOG_BIN_BLOCK_MAX_RECORDS, n);
+    TEST_ASSERT_EQUAL_UINT32(1, r.skipped);
+}
+
+static void test_rejects_non_recordings()
+{
+    static LogReplay r;
+    const char text[] = "not a recording\n";
+    halFileWrite(binPath, (const uint8_t *)text, sizeof(text) - 1, false);
+    TEST_ASSERT_FALSE(logReplayOpen(r, binPath, 1.0f, true, 0));
+    TEST_ASSERT_FALSE(logReplayOpen(r, "/missing.csv", 1.0f, true, 0));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_csv_round_trip);
+    RUN_TEST(test_binary_round_trip);
+    RUN_TEST(test_paced_by_timestamps);
+    RUN_TEST(test_loop_wraps);
+    RUN_TEST(test_torn_block_ends_playback);
+    RUN_TEST(test_rejects_non_recordings);
+    return UNITY_END();
+}
@@ -0,0 +1,196 @@
+// Recording writer flash traffic (LogWriter.h) against a recorded
+// filesystem and a manual clock: the file only gets whole 4 KiB blocks
+// between commits, metadata commits (sync) happen on the commit interval,
+// and power-safe batching commits once per batch.
+//
+// Run: pio test -e native -f test_log_writer
+//
+// Files are created under HAL_FS_ROOT (default .pio/native_fs).
+#include "LogWriter.h"
+#include "SharedData.h"
+#include "HalHost.h"
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+static const char *fileName = "/log_001.csv";
+
+struct FileOp
+{
+    HalHostFileOp op;
+    size_t offset;
+    size_t len;
+};
+static std::vector<FileOp> ops;
+
+static bool fileHook(HalHostFileOp op, const char *path, size_t offset, size_t len)
+{
+    if (strcmp(path, fileName) == 0)
+        ops.push_back({op, offset, len});
+    return true;
+}
+
+static int count(HalHostFileOp op)
+{
+    int n = 0;
+    for (const FileOp &o : ops)
+        n += o.op == op;
+    return n;
+}
+
+static void push(int count)
+{
+    static uint32_t t = 0;
+    for (int i = 0; i < count; i++)
+    {
+        LogData s = {t, 25.0f + (i % 400) * 0.37f, 450.0f + (i % 900) * 3.11f, 21.5f + (i % 50) * 0.07f, 40.0f};
+        t += 3000;
+        TEST_ASSERT_TRUE(logWriterPush(s));
+    }
+}
+
+void setUp()
+{
+    halHostManualClock(1000000);
+    initLogWriter();
+    logWriterSetCommitInterval(LOG_COMMIT_INTERVAL_MS);
+    logWriterSetSyncBatch(0);
+    logWriterReset();
+    snprintf(currentLogFileName, sizeof(currentLogFileName), "%s", fileName);
+    halFileRemove(fileName);
+    ops.clear();
+    halHostSetFileHook(fileHook);
+}
+
+void tearDown()
+{
+    logWriterClose();
+    halHostSetFileHook(nullptr);
+    halFileRemove(fileName);
+}
+
+// Between commits LittleFS only sees whole, block-aligned 4 KiB writes;
+// the partial tail goes out with the commit
+static void test_appends_are_block_aligned()
+{
+    push(10 * LOG_BUFFER_SIZE);
+    TEST_ASSERT_FALSE(isLogWriterBusy());
+    TEST_ASSERT_EQUAL_INT(0, count(HAL_HOST_SYNC));
+    TEST_ASSERT_TRUE(count(HAL_HOST_APPEND) > 0);
+    for (const FileOp &o : ops)
+    {
+        TEST_ASSERT_EQUAL_UINT32(0, o.offset % LOG_FLASH_BLOCK_SIZE);
+        TEST_ASSERT_EQUAL_UINT32(LOG_FLASH_BLOCK_SIZE, o.len);
+    }
+
+    size_t written = ops.size() * LOG_FLASH_BLOCK_SIZE;
+    logWriterCommit();
+    TEST_ASSERT_EQUAL_INT(1, count(HAL_HOST_SYNC));
+    FileOp tail = ops[ops.size() - 2];
+    TEST_ASSERT_EQUAL_INT(HAL_HOST_APPEND, tail.op);
+    TEST_ASSERT_EQUAL_UINT32(written, tail.offset);
+    TEST_ASSERT_TRUE(tail.len < LOG_FLASH_BLOCK_SIZE);
+    TEST_ASSERT_EQUAL_INT(HAL_HOST_SYNC, ops.back().op);
+
+    // Every sample is in the file, and the next block fills up to the
+    // boundary again
+    LogWriterStats stats = getLogWriterStats();
+    TEST_ASSERT_EQUAL_UINT32(halFileSize(fileName), stats.sessionBytes);
+    TEST_ASSERT_EQUAL_UINT32(written + tail.len, stats.sessionBytes);
+    ops.clear();
+    push(10 * LOG_BUFFER_SIZE);
+    TEST_ASSERT_EQUAL_UINT32(written + tail.len, ops[0].offset);
+    TEST_ASSERT_EQUAL_UINT32(0, (ops[0].offset + ops[0].len) % LOG_FLASH_BLOCK_SIZE);
+}
+
+// The buffered tail and file metadata go to flash once per commit
+// interval, on the writer's own pass
+static void test_commit_on_interval()
+{
+    logWriterSetCommitInterval(10000);
+    uint32_t commitsBefore = getLogWriterStats().commits;
+    push(LOG_BUFFER_SIZE); // Handoff: the writer opens the file and appends
+    TEST_ASSERT_EQUAL_INT(0, count(HAL_HOST_SYNC));
+    TEST_ASSERT_EQUAL_UINT32(10000, logWriterRun());
+
+    halHostAdvanceUs(9999 * 1000);
+    TEST_ASSERT_EQUAL_UINT32(1, logWriterRun());
+    TEST_ASSERT_EQUAL_INT(0, count(HAL_HOST_SYNC));
+
+    halHostAdvanceUs(1000);
+    TEST_ASSERT_EQUAL_UINT32(10000, logWriterRun());
+    TEST_ASSERT_EQUAL_INT(1, count(HAL_HOST_SYNC));
+    TEST_ASSERT_EQUAL_UINT32(halFileSize(fileName), getLogWriterStats().sessionBytes);
+
+    // Nothing new: the next commit is a full interval later
+    halHostAdvanceUs(5000 * 1000);
+    TEST_ASSERT_EQUAL_UINT32(5000, logWriterRun());
+    TEST_ASSERT_EQUAL_INT(1, count(HAL_HOST_SYNC));
+    TEST_ASSERT_EQUAL_UINT32(1, getLogWriterStats().commits - commitsBefore);
+}
+
+// Power-safe batching: every N samples are handed over and synced
+static void test_sync_batching()
+{
+    const int batch = 10;
+    logWriterSetSyncBatch(batch);
+    uint32_t commitsBefore = getLogWriterStats().commits;
+
+    push(3 * batch + 5);
+    TEST_ASSERT_EQUAL_INT(3, count(HAL_HOST_SYNC));
+    TEST_ASSERT_EQUAL_INT(5, logWriterPending());
+    TEST_ASSERT_EQUAL_UINT32(3, getLogWriterStats().commits - commitsBefore);
+
+    // Each sync follows the append of its batch, and the file holds every
+    // batched sample when it lands
+    size_t lastSize = 0;
+    for (size_t i = 0; i < ops.size(); i++)
+    {
+        if (ops[i].op != HAL_HOST_SYNC)
+            continue;
+        TEST_ASSERT_TRUE(i > 0 && ops[i - 1].op == HAL_HOST_APPEND);
+        size_t size = ops[i - 1].offset + ops[i - 1].len;
+        TEST_ASSERT_TRUE(size > lastSize);
+        lastSize = size;
+    }
+    TEST_ASSERT_EQUAL_UINT32(lastSize, halFileSize(fileName));
+
+    // No clock involved: batching doesn't wait for the commit interval
+    push(batch - 5);
+    TEST_ASSERT_EQUAL_INT(4, count(HAL_HOST_SYNC));
+    TEST_ASSERT_EQUAL_INT(0, logWriterPending());
+}
+
+// The committed count only reaches what was pushed once a commit has
+// covered it: a buffer written between commits isn't durable yet
+static void test_committed_seq()
+{
+    uint32_t base = logWriterPushedSeq();
+    push(LOG_BUFFER_SIZE + 10);
+    TEST_ASSERT_EQUAL_UINT32(base + LOG_BUFFER_SIZE + 10, logWriterPushedSeq());
+    TEST_ASSERT_TRUE(getLogWriterStats().buffersWritten > 0);
+    TEST_ASSERT_TRUE((int32_t)(logWriterCommittedSeq() - base) <= 0);
+
+    // The request rides on the handoff of the 10 buffered samples
+    logWriterRequestCommit();
+    TEST_ASSERT_EQUAL_INT(1, count(HAL_HOST_SYNC));
+    TEST_ASSERT_EQUAL_UINT32(logWriterPushedSeq(), logWriterCommittedSeq());
+
+    // Nothing buffered: the request commits right away
+    push(1);
+    logWriterFlush();
+    TEST_ASSERT_EQUAL_UINT32(logWriterPushedSeq() - 1, logWriterCommittedSeq());
+    logWriterRequestCommit();
+    TEST_ASSERT_EQUAL_UINT32(logWriterPushedSeq(), logWriterCommittedSeq());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_appends_are_block_aligned);
+    RUN_TEST(test_commit_on_interval);
+    RUN_TEST(test_sync_batching);
+    RUN_TEST(test_committed_seq);
+    return UNITY_END();
+}
@@ -0,0 +1,107 @@
+// Stress test for Seqlock.h: one writer thread publishes readings whose
+// fields are all derived from a counter, several readers check every
+// snapshot is internally consistent and the sequence never goes backwards.
+//
+// Run: pio test -e native -f test_seqlock
+#include "Seqlock.h"
+#include "SharedData.h"
+#include <unity.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+typedef SensorReadings Readings;
+
+static Readings make(uint32_t n)
+{
+    Readings r;
+    r.temp = (float)(n % 1000);
+    r.hum = r.temp + 1;
+    r.press = r.temp + 2;
+    r.iaq = r.temp + 3;
+    r.co2 = r.temp + 4;
+    r.voltage = r.temp + 5;
+    r.batteryPercent = (int)(n % 1000) + 6;
+    r.accuracy = (uint8_t)n;
+    return r;
+}
+
+static bool consistent(const Readings &r, uint32_t seq)
+{
+    // seq is the number of completed writes, and write k stores make(k)
+    Readings e = seq ? make(seq) : Readings();
+    return r.temp == e.temp && r.press == e.press && r.hum == e.hum && r.iaq == e.iaq &&
+           r.co2 == e.co2 && r.voltage == e.voltage && r.batteryPercent == e.batteryPercent &&
+           r.accuracy == e.accuracy;
+}
+
+#define WRITES 5000000
+#define READERS 3
+
+void setUp() {}
+void tearDown() {}
+
+static void test_snapshots_never_torn()
+{
+    const uint32_t writes = WRITES;
+    const int readers = READERS;
+
+    Seqlock<Readings> lock;
+    std::atomic<bool> done{false};
+    std::vector<uint64_t> reads(readers), torn(readers), backwards(readers);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < readers; t++)
+    {
+        threads.emplace_back([&, t] {
+            uint32_t last = 0;
+            Readings r;
+            while (!done.load(std::memory_order_relaxed))
+            {
+                uint32_t seq = lock.read(r);
+                if (!consistent(r, seq))
+                    torn[t]++;
+                if (seq < last)
+                    backwards[t]++;
+                last = seq;
+                reads[t]++;
+            }
+        });
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint32_t n = 1; n <= writes; n++)
+        lock.write(make(n));
+    auto t1 = std::chrono::steady_clock::now();
+    done = true;
+    for (auto &th : threads)
+        th.join();
+
+    uint64_t totalReads = 0, totalTorn = 0, totalBack = 0;
+    for (int t = 0; t < readers; t++)
+    {
+        totalReads += reads[t];
+        totalTorn += torn[t];
+        totalBack += backwards[t];
+    }
+
+    Readings last;
+    uint32_t finalSeq = lock.read(last);
+
+    printf("writes    %u (%.1f ns/write)\n", writes, std::chrono::duration<double, std::nano>(t1 - t0).count() / writes);
+    printf("readers   %d, %llu snapshots\n", readers, (unsigned long long)totalReads);
+
+    TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)totalTorn);
+    TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)totalBack);
+    TEST_ASSERT_EQUAL_UINT32(writes, finalSeq);
+    TEST_ASSERT_TRUE(consistent(last, finalSeq));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_snapshots_never_torn);
+    return UNITY_END();
+}
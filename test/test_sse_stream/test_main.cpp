@@ -0,0 +1,275 @@
+// Simulated-clock check for the /api/stream push path (SseStream.h).
+//
+// Simulated sockets stand in for WiFiClient: each has a send buffer the
+// size of lwIP's TCP send buffer and a reader that drains it at its own
+// rate. The loop runs every WEB_POLL_MS on a virtual clock and publishes
+// an event per sensor sample. Clients must get every event the moment it
+// is published and keep-alives only when no data flows. A client that
+// stops reading or disconnects loses its slot, and a stream is closed
+// right after any event that didn't fit.
+//
+// Run: pio test -e native -f test_sse_stream
+#include "SseStream.h"
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// Model of the firmware around the stream
+#define WEB_POLL_MS 10     // main.cpp: web server pass while WiFi is up
+#define SND_BUF 5744       // lwIP TCP_SND_BUF on the ESP32 Arduino core
+#define REALTIME_MS 1000
+#define NORMAL_MS 3000
+
+struct Socket
+{
+    bool connected = false;
+    size_t buffered = 0;    // Written, not yet read by the client
+    uint32_t readPerPass = 0;
+    std::string received;   // In order, as the client's EventSource sees it
+    std::vector<uint32_t> eventAt;
+    std::vector<uint32_t> keepaliveAt;
+    bool closed = false;
+};
+
+static Socket sockets[SSE_MAX_CLIENTS];
+static uint32_t nowMs = 0;
+static SseStream sse;
+
+static size_t sockWrite(int slot, const uint8_t *data, size_t len)
+{
+    Socket &s = sockets[slot];
+    size_t n = SND_BUF - s.buffered < len ? SND_BUF - s.buffered : len;
+    s.received.append((const char *)data, n);
+    s.buffered += n;
+    if (n == len && data[0] == 'd')
+        s.eventAt.push_back(nowMs);
+    if (n == len && data[0] == ':')
+        s.keepaliveAt.push_back(nowMs);
+    return n;
+}
+
+static bool sockConnected(int slot)
+{
+    return sockets[slot].connected;
+}
+
+static void sockClose(int slot)
+{
+    sockets[slot].connected = false;
+    sockets[slot].closed = true;
+}
+
+// A client as the /api/stream handler accepts it
+static int connect(uint32_t readPerPass)
+{
+    int slot = sseFreeSlot(sse);
+    if (slot < 0)
+        return -1;
+    sockets[slot] = Socket();
+    sockets[slot].connected = true;
+    sockets[slot].readPerPass = readPerPass;
+    sseAttach(sse, slot);
+    return slot;
+}
+
+// Runs the loop until endMs, publishing a sample every periodMs (0: none)
+static void run(uint32_t endMs, uint32_t periodMs, uint32_t &nextSample, uint32_t &seq)
+{
+    for (; nowMs < endMs; nowMs += WEB_POLL_MS)
+    {
+        if (periodMs && nowMs >= nextSample)
+        {
+            SensorReadings r;
+            r.temp = 21.5f;
+            r.co2 = 612.0f;
+            char msg[SSE_EVENT_MAX];
+            int len = sseDataEvent(msg, sizeof(msg), r, seq++, nowMs, false, "");
+            ssePublish(sse, msg, len, nowMs);
+            nextSample += periodMs;
+        }
+        ssePoll(sse, nowMs);
+
+        for (Socket &s : sockets)
+        {
+            size_t n = s.readPerPass < s.buffered ? s.readPerPass : s.buffered;
+            s.buffered -= n;
+        }
+    }
+}
+
+// Events EventSource dispatches from a stream: whole ones, in order, with
+// consecutive seq. A stream the device closed may end in a cut-off event,
+// which EventSource discards.
+static int parseEvents(const std::string &stream, uint32_t firstSeq, bool closed = false)
+{
+    int events = 0;
+    size_t pos = 0;
+    while (pos < stream.size())
+    {
+        size_t end = stream.find("\n\n", pos);
+        if (end == std::string::npos)
+        {
+            TEST_ASSERT_TRUE(closed);
+            break;
+        }
+        std::string ev = stream.substr(pos, end - pos);
+        if (ev[0] == 'd')
+        {
+            char want[32];
+            snprintf(want, sizeof(want), "data: {\"seq\":%u,", (unsigned)(firstSeq + events));
+            TEST_ASSERT_EQUAL_INT(0, ev.compare(0, strlen(want), want));
+            TEST_ASSERT_TRUE(ev.back() == '}');
+            events++;
+        }
+        else
+        {
+            TEST_ASSERT_EQUAL_STRING(": ka", ev.c_str());
+        }
+        pos = end + 2;
+    }
+    return events;
+}
+
+static SseLink link()
+{
+    SseLink l;
+    l.write = sockWrite;
+    l.connected = sockConnected;
+    l.close = sockClose;
+    return l;
+}
+
+void setUp()
+{
+    nowMs = 0;
+    for (Socket &s : sockets)
+        s = Socket();
+    sseInit(sse, link(), nowMs);
+}
+
+void tearDown() {}
+
+// Data flowing: one event per sample, written the pass it was published,
+// and no keep-alives in between
+static void test_event_per_sample()
+{
+    int a = connect(SND_BUF);
+    int b = connect(SND_BUF);
+    uint32_t nextSample = 500, seq = 100;
+    run(10 * 60000, NORMAL_MS, nextSample, seq);
+
+    TEST_ASSERT_EQUAL_UINT32(200, sse.events);
+    TEST_ASSERT_EQUAL_UINT32(0, sse.keepalives);
+    for (int slot : {a, b})
+    {
+        Socket &s = sockets[slot];
+        TEST_ASSERT_EQUAL_INT(200, parseEvents(s.received, 100));
+        for (size_t i = 0; i < s.eventAt.size(); i++)
+            TEST_ASSERT_EQUAL_UINT32(500 + i * NORMAL_MS, s.eventAt[i]);
+    }
+    TEST_ASSERT_EQUAL_INT(2, sseClientCount(sse));
+}
+
+// No new data (ULP, replay paused): a keep-alive every SSE_KEEPALIVE_MS,
+// and a client that went away is noticed by the next one
+static void test_keepalive_when_idle()
+{
+    int a = connect(SND_BUF);
+    int gone = connect(SND_BUF);
+    uint32_t nextSample = 0, seq = 0;
+
+    run(40000, 0, nextSample, seq);
+    sockets[gone].connected = false;
+    uint32_t lostAt = nowMs;
+    run(10 * 60000, 0, nextSample, seq);
+
+    Socket &s = sockets[a];
+    TEST_ASSERT_EQUAL_INT(0, parseEvents(s.received, 0));
+    TEST_ASSERT_TRUE(s.keepaliveAt.size() >= 10 * 60000 / (SSE_KEEPALIVE_MS + WEB_POLL_MS));
+    uint32_t last = 0;
+    for (uint32_t at : s.keepaliveAt)
+    {
+        TEST_ASSERT_TRUE(at - last > SSE_KEEPALIVE_MS && at - last <= SSE_KEEPALIVE_MS + WEB_POLL_MS);
+        last = at;
+    }
+
+    TEST_ASSERT_TRUE(sockets[gone].closed);
+    TEST_ASSERT_TRUE(sockets[gone].keepaliveAt.back() < lostAt);
+    TEST_ASSERT_EQUAL_INT(1, sseClientCount(sse));
+    TEST_ASSERT_EQUAL_UINT32(1, sse.dropped);
+}
+
+// REALTIME: a client that stops reading fills its send buffer and is
+// dropped before it gets a partial event; a disconnected one is dropped on
+// the next event. The reader that keeps up sees all of them, and the
+// freed slots take new clients.
+static void test_slow_and_dead_clients_dropped()
+{
+    int fast = connect(SND_BUF);
+    int stalled = connect(0);
+    int dead = connect(SND_BUF);
+    int slow = connect(100); // 10 KB/s, far above the event rate
+    TEST_ASSERT_EQUAL_INT(-1, sseFreeSlot(sse));
+
+    uint32_t nextSample = 0, seq = 0;
+    run(30000, REALTIME_MS, nextSample, seq);
+    sockets[dead].connected = false;
+    uint32_t deadAt = nowMs;
+    run(5 * 60000, REALTIME_MS, nextSample, seq);
+
+    TEST_ASSERT_EQUAL_INT((int)sse.events, parseEvents(sockets[fast].received, 0));
+    TEST_ASSERT_FALSE(sockets[fast].closed);
+
+    // Stalled: closed on the first event its full send buffer cut short
+    Socket &st = sockets[stalled];
+    TEST_ASSERT_TRUE(st.closed);
+    TEST_ASSERT_EQUAL_UINT32(SND_BUF, st.received.size());
+    int fit = parseEvents(st.received, 0, true);
+    TEST_ASSERT_EQUAL_INT(fit, (int)st.eventAt.size());
+    TEST_ASSERT_TRUE(fit > 0 && fit < (int)sse.events);
+
+    // Dead: the event after the disconnect closes it
+    TEST_ASSERT_TRUE(sockets[dead].closed);
+    TEST_ASSERT_TRUE(sockets[dead].eventAt.back() < deadAt);
+    TEST_ASSERT_EQUAL_INT(30, (int)sockets[dead].eventAt.size());
+
+    // Slow but reading faster than the event rate: stays
+    TEST_ASSERT_FALSE(sockets[slow].closed);
+    TEST_ASSERT_EQUAL_INT((int)sse.events, parseEvents(sockets[slow].received, 0));
+
+    TEST_ASSERT_EQUAL_UINT32(2, sse.dropped);
+    TEST_ASSERT_TRUE(connect(SND_BUF) >= 0);
+    TEST_ASSERT_TRUE(connect(SND_BUF) >= 0);
+    TEST_ASSERT_EQUAL_INT(-1, connect(SND_BUF));
+}
+
+// A socket that dropped before any write still frees its slot for the
+// next client
+static void test_stale_slot_reused()
+{
+    int slots[SSE_MAX_CLIENTS];
+    for (int i = 0; i < SSE_MAX_CLIENTS; i++)
+        slots[i] = connect(SND_BUF);
+    TEST_ASSERT_EQUAL_INT(-1, sseFreeSlot(sse));
+
+    sockets[slots[2]].connected = false;
+    TEST_ASSERT_EQUAL_INT(slots[2], connect(SND_BUF));
+    TEST_ASSERT_EQUAL_UINT32(1, sse.dropped);
+
+    sseCloseAll(sse);
+    TEST_ASSERT_EQUAL_INT(0, sseClientCount(sse));
+    for (Socket &s : sockets)
+        TEST_ASSERT_TRUE(s.closed);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_event_per_sample);
+    RUN_TEST(test_keepalive_when_idle);
+    RUN_TEST(test_slow_and_dead_clients_dropped);
+    RUN_TEST(test_stale_slot_reused);
+    return UNITY_END();
+}
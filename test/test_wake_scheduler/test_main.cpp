@@ -0,0 +1,176 @@
+// Simulated-clock check for the sleep scheduler (WakeScheduler.h).
+//
+// Runs an hour of the loop's sleep logic for each operating mode and
+// compares the old fixed-period rule (3 s / 300 s after the last BSEC
+// output) with the deadline scheduler. Counts wake-ups per hour, the share
+// of time awake, and how late BSEC got called relative to its own schedule.
+//
+// Run: pio test -e native -f test_wake_scheduler
+#include "WakeScheduler.h"
+#include <unity.h>
+#include <cstdio>
+
+// Model of the firmware around the scheduler
+#define LOOP_PASS_MS 2      // One awake loop pass incl. the vTaskDelay(1)
+#define SENSOR_POLL_MS 10   // Sensor task poll (SensorTask.cpp)
+#define OUTPUT_LAG_MS 180   // Cycle start -> BSEC outputs (forced-mode heater profile)
+#define SENSOR_GUARD_MS 15  // I2C_SENSOR_GUARD_MS
+
+struct Scenario
+{
+    const char *name;
+    uint32_t periodMs;      // From the subscribed BSEC rate
+    uint32_t fixedPeriodMs; // What the old rule assumed
+    bool stayAwake;         // REALTIME never sleeps
+    int ble;                // 0 off, 1 advertising, 2 connected
+    bool lowBattery;
+};
+
+static const Scenario scenarios[] = {
+    {"REALTIME", 1000, 3000, true, 0, false},
+    {"NORMAL", 3000, 3000, false, 0, false},
+    {"NORMAL+BLE adv", 3000, 3000, false, 1, false},
+    {"NORMAL+BLE conn", 3000, 3000, false, 2, false},
+    {"NORMAL+low batt", 3000, 3000, false, 0, true},
+    {"ECO screen on", 3000, 3000, false, 0, false},
+    {"ECO screen off", 300000, 300000, false, 0, false},
+};
+
+struct Result
+{
+    uint32_t wakeups = 0;
+    uint64_t awakeMs = 0;
+    uint32_t cycles = 0;
+    uint64_t lateSumMs = 0;
+    uint32_t lateMaxMs = 0;
+};
+
+static Result run(const Scenario &sc, bool deadlines, uint32_t durationMs)
+{
+    Result res;
+    wakeClearAll();
+    resetWakeStats();
+
+    uint32_t t = 0;
+    uint32_t bsecNext = 0;      // BSEC's own next-call time
+    uint32_t cycleStart = 0;    // First bus transaction of the last cycle
+    bool cycleKnown = false;
+    uint32_t lastOutput = 0;    // SensorStatus::lastRunMs
+    bool outputPending = false;
+    uint32_t nextPoll = 0;
+    uint32_t ledLastUpdate = 0;
+
+    while (t < durationMs)
+    {
+        // Sensor task: polls BSEC while the CPU is up
+        if ((int32_t)(t - nextPoll) >= 0)
+        {
+            if ((int32_t)(t - bsecNext) >= 0)
+            {
+                uint32_t late = t - bsecNext;
+                res.lateSumMs += late;
+                if (late > res.lateMaxMs)
+                    res.lateMaxMs = late;
+                res.cycles++;
+                cycleStart = t;
+                cycleKnown = true;
+                bsecNext = t + sc.periodMs;
+                outputPending = true;
+            }
+            if (outputPending && t - cycleStart >= OUTPUT_LAG_MS)
+            {
+                lastOutput = t;
+                outputPending = false;
+            }
+            nextPoll = t + SENSOR_POLL_MS;
+        }
+
+        // updateLED(): low-battery blink
+        if (sc.lowBattery && t - ledLastUpdate > 500)
+            ledLastUpdate = t;
+
+        uint32_t sleepMs = 0;
+        WakeSource src = WAKE_SENSOR;
+        if (!sc.stayAwake && deadlines)
+        {
+            // armWakeDeadlines() + i2cBusNextSensorCycle()
+            uint32_t due = lastOutput + sc.periodMs;
+            if (cycleKnown)
+            {
+                due = cycleStart + sc.periodMs;
+                while ((int32_t)(due - t) < -SENSOR_GUARD_MS)
+                    due += sc.periodMs;
+            }
+            wakeAt(WAKE_SENSOR, due);
+            if (sc.lowBattery)
+                wakeAt(WAKE_LED, ledLastUpdate + 501);
+            if (sc.ble)
+                wakeAt(WAKE_BLE, t + (sc.ble == 2 ? 50 : 500));
+            sleepMs = wakePlanSleep(t, src);
+        }
+        else if (!sc.stayAwake)
+        {
+            // The rule this replaced
+            long timeUntilNext = (long)sc.fixedPeriodMs - (long)(t - lastOutput);
+            if (timeUntilNext > 200 && timeUntilNext <= (long)sc.fixedPeriodMs)
+            {
+                sleepMs = timeUntilNext - 10;
+                if (sc.ble == 2 && sleepMs > 50)
+                    sleepMs = 50;
+                if (sc.ble == 1 && sleepMs > 500)
+                    sleepMs = 500;
+            }
+        }
+
+        if (sleepMs > 0)
+        {
+            wakeNoteSleep(src, sleepMs, false);
+            res.wakeups++;
+            t += sleepMs;
+            nextPoll = t; // The sensor task's timeout expired during sleep
+        }
+        else
+        {
+            t += LOOP_PASS_MS;
+            res.awakeMs += LOOP_PASS_MS;
+        }
+    }
+    return res;
+}
+
+#define SIM_MS 3600000
+
+void setUp() {}
+void tearDown() {}
+
+static void test_deadlines_per_mode()
+{
+    printf("%-16s %-9s %10s %8s %8s %9s %9s\n", "mode", "policy", "wakeups/h", "awake%", "cycles", "late avg", "late max");
+    for (const Scenario &sc : scenarios)
+    {
+        Result r[2];
+        for (int p = 0; p < 2; p++)
+        {
+            r[p] = run(sc, p == 1, SIM_MS);
+            printf("%-16s %-9s %10u %7.1f%% %8u %7.1fms %7ums\n",
+                   sc.name, p ? "deadline" : "fixed",
+                   (unsigned)r[p].wakeups,
+                   100.0 * r[p].awakeMs / SIM_MS,
+                   (unsigned)r[p].cycles,
+                   r[p].cycles ? (double)r[p].lateSumMs / r[p].cycles : 0.0,
+                   (unsigned)r[p].lateMaxMs);
+        }
+        // Deadlines never lose BSEC cycles or awake time to the fixed
+        // rule, and never call BSEC later than one sensor poll
+        TEST_ASSERT_GREATER_OR_EQUAL_UINT32(r[0].cycles, r[1].cycles);
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(r[0].awakeMs, r[1].awakeMs);
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(SENSOR_POLL_MS, r[1].lateMaxMs);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_deadlines_per_mode);
+    return UNITY_END();
+}
@@ -0,0 +1,120 @@
+// Host-side converter for binary recordings (.hlg -> .csv)
+//
+// Build (from the repo root):
+//   g++ -O2 -Iinclude tools/hlg2csv.cpp src/LogFormat.cpp src/FixedFormat.cpp -o hlg2csv
+//
+// Usage:
+//   hlg2csv log_001.hlg > log_001.csv
+//   hlg2csv --bench [samples]    compare CSV vs binary size and encode time
+#include "LogFormat.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static int convert(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+    {
+        fprintf(stderr, "Can't open %s\n", path);
+        return 1;
+    }
+
+    std::vector<uint8_t> data;
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+        data.insert(data.end(), chunk, chunk + n);
+    fclose(f);
+
+    LogBinHeader hdr;
+    if (!logBinDecodeHeader(data.data(), data.size(), hdr))
+    {
+        fprintf(stderr, "%s: not a v%d recording\n", path, LOG_BIN_VERSION);
+        return 1;
+    }
+
+    fputs(LOG_CSV_HEADER, stdout);
+
+    size_t offset = LOG_BIN_HEADER_SIZE;
+    size_t samples = 0;
+    int blocks = 0;
+    LogData records[LOG_BIN_BLOCK_MAX_RECORDS];
+    char line[128];
+
+    while (offset < data.size())
+    {
+        size_t consumed = 0;
+        int count = logBinDecodeBlock(data.data() + offset, data.size() - offset, records, LOG_BIN_BLOCK_MAX_RECORDS, consumed);
+        if (count < 0)
+        {
+            fprintf(stderr, "%s: stopping at torn/corrupt block at offset %zu\n", path, offset);
+            break;
+        }
+        for (int i = 0; i < count; i++)
+        {
+            logCsvFormatLine(line, sizeof(line), records[i]);
+            fputs(line, stdout);
+        }
+        offset += consumed;
+        samples += count;
+        blocks++;
+    }
+
+    fprintf(stderr, "%s: session %u, %zu samples in %d blocks\n", path, (unsigned)hdr.sessionId, samples, blocks);
+    return 0;
+}
+
+static int bench(int count)
+{
+    std::vector<LogData> samples(count);
+    for (int i = 0; i < count; i++)
+    {
+        samples[i].timestamp = 1000 + i * 3000UL;
+        samples[i].iaq = 25.0f + (i % 400) * 0.37f;
+        samples[i].co2 = 450.0f + (i % 900) * 3.11f;
+        samples[i].temp = 21.5f + (i % 50) * 0.07f;
+        samples[i].hum = 40.0f + (i % 30) * 0.53f;
+    }
+
+    std::vector<char> csv(count * 64 + 64);
+    std::vector<uint8_t> bin(LOG_BIN_HEADER_SIZE + (count / LOG_BIN_BLOCK_MAX_RECORDS + 1) * LOG_BIN_BLOCK_MAX_SIZE);
+
+    auto t0 = std::chrono::steady_clock::now();
+    size_t csvBytes = strlen(LOG_CSV_HEADER);
+    for (int i = 0; i < count; i++)
+        csvBytes += logCsvFormatLine(csv.data() + csvBytes, csv.size() - csvBytes, samples[i]);
+    auto t1 = std::chrono::steady_clock::now();
+
+    size_t binBytes = logBinEncodeHeader(bin.data(), samples[0].timestamp, 1);
+    uint16_t seq = 0;
+    for (int i = 0; i < count; i += LOG_BIN_BLOCK_MAX_RECORDS)
+    {
+        int n = count - i < LOG_BIN_BLOCK_MAX_RECORDS ? count - i : LOG_BIN_BLOCK_MAX_RECORDS;
+        binBytes += logBinEncodeBlock(bin.data() + binBytes, bin.size() - binBytes, seq++, &samples[i], n);
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    double csvNs = std::chrono::duration<double, std::nano>(t1 - t0).count() / count;
+    double binNs = std::chrono::duration<double, std::nano>(t2 - t1).count() / count;
+
+    printf("samples          %d\n", count);
+    printf("csv  bytes/sample %.2f  encode %.1f ns/sample\n", (double)csvBytes / count, csvNs);
+    printf("bin  bytes/sample %.2f  encode %.1f ns/sample\n", (double)binBytes / count, binNs);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc >= 2 && strcmp(argv[1], "--bench") == 0)
+        return bench(argc >= 3 ? atoi(argv[2]) : 100000);
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: %s <file.hlg> | --bench [samples]\n", argv[0]);
+        return 2;
+    }
+    return convert(argv[1]);
+}